@@ -10,6 +10,7 @@
 
 #include "src/bitvector.h"
 #include "src/column.h"
+#include "src/cpu_features.h"
 #include "src/types.h"
 
 #include "hybrid_timer.h"
@@ -53,6 +54,7 @@ int main(int argc, char* argv[]){
     }
     
     std::cout << "[INFO ] omp_max_threads = " << omp_get_max_threads() << std::endl;
+    std::cout << "[INFO ] simd level = " << GetSimdLevel() << std::endl;
     std::cout << "[INFO ] Executing scan ..." << std::endl;
     HybridTimer t1;
     t1.Start();
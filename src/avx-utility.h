@@ -23,6 +23,14 @@ inline T FLIP(T value){
     return static_cast<T>(value ^ offset);
 }
 
+/*
+   The helpers below are compiled for AVX2 / AVX-512 regardless of the
+   compiler flags. Only call them from kernels running on a matching
+   instruction set (see cpu_features.h).
+*/
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
 // Compare less
 template <typename T>
 inline __m256i avx_cmplt(const __m256i &a, const __m256i &b){
@@ -123,6 +131,43 @@ inline bool avx_iszero(const __m256i &a){
     return _mm256_testz_si256(a, a);
 }
 
+#pragma GCC pop_options
+
+
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512bw,avx512vl")
+/*
+   AVX-512 (BW) helpers on 64 byte lanes.
+   Comparisons produce a lane mask and only consider lanes set in k.
+*/
+
+// Set1
+inline __m512i avx512_set1_epi8(uint8_t a){
+    return _mm512_set1_epi8(static_cast<int8_t>(a));
+}
+
+// Compare less (signed bytes)
+inline __mmask64 avx512_cmplt_epi8(__mmask64 k, const __m512i &a, const __m512i &b){
+    return _mm512_mask_cmplt_epi8_mask(k, a, b);
+}
+
+// Compare greater (signed bytes)
+inline __mmask64 avx512_cmpgt_epi8(__mmask64 k, const __m512i &a, const __m512i &b){
+    return _mm512_mask_cmpgt_epi8_mask(k, a, b);
+}
+
+// Compare equal
+inline __mmask64 avx512_cmpeq_epi8(__mmask64 k, const __m512i &a, const __m512i &b){
+    return _mm512_mask_cmpeq_epi8_mask(k, a, b);
+}
+
+// Test is zero (kortest)
+inline bool avx512_iszero(__mmask64 k){
+    return _kortestz_mask64_u8(k, k);
+}
+
+#pragma GCC pop_options
+
 
 }   // namespace
 
@@ -11,6 +11,8 @@
 #include    <algorithm>
 #include    <omp.h>
 
+#include "numa_placement.h"
+
 namespace byteslice{
 
 BitVector::BitVector(const Column* column):
@@ -21,8 +23,9 @@ BitVector::BitVector(size_t num):
     num_(num){
 
     for(size_t count=0; count < num_; count += kNumTuplesPerBlock){
-        BitVectorBlock* new_block = 
-            new BitVectorBlock(std::min(kNumTuplesPerBlock, num_ - count));
+        //next to the column block it holds the bits of
+        BitVectorBlock* new_block = new BitVectorBlock(
+                std::min(kNumTuplesPerBlock, num_ - count), GetBlockNode(blocks_.size()));
         blocks_.push_back(new_block);
     }
     SetOnes();
@@ -54,6 +57,65 @@ void BitVector::Or(const BitVector* bitvector){
     }
 }
 
+void BitVector::AndNot(const BitVector* bitvector){
+    assert(num_ == bitvector->num_);
+
+#   pragma omp parallel for schedule(dynamic)
+    for(size_t i=0; i < blocks_.size(); i++){
+        blocks_[i]->AndNot(bitvector->GetBVBlock(i));
+    }
+}
+
+void BitVector::Xor(const BitVector* bitvector){
+    assert(num_ == bitvector->num_);
+
+#   pragma omp parallel for schedule(dynamic)
+    for(size_t i=0; i < blocks_.size(); i++){
+        blocks_[i]->Xor(bitvector->GetBVBlock(i));
+    }
+}
+
+void BitVector::Not(){
+#   pragma omp parallel for schedule(dynamic)
+    for(size_t i=0; i < blocks_.size(); i++){
+        blocks_[i]->Not();
+    }
+}
+
+size_t BitVector::AndCount(const BitVector* bitvector) const{
+    assert(num_ == bitvector->num_);
+    size_t count = 0;
+#   pragma omp parallel for schedule(dynamic) reduction(+: count)
+    for(size_t i=0; i < blocks_.size(); i++){
+        count += blocks_[i]->AndCount(bitvector->GetBVBlock(i));
+    }
+    return count;
+}
+
+void BitVector::AndAll(const std::vector<const BitVector*> &bitvectors){
+#   pragma omp parallel for schedule(dynamic)
+    for(size_t i=0; i < blocks_.size(); i++){
+        std::vector<const BitVectorBlock*> others;
+        for(const BitVector* bitvector : bitvectors){
+            assert(num_ == bitvector->num_);
+            others.push_back(bitvector->GetBVBlock(i));
+        }
+        blocks_[i]->AndAll(others.data(), others.size());
+    }
+}
+
+void BitVector::OrAll(const std::vector<const BitVector*> &bitvectors){
+#   pragma omp parallel for schedule(dynamic)
+    for(size_t i=0; i < blocks_.size(); i++){
+        std::vector<const BitVectorBlock*> others;
+        for(const BitVector* bitvector : bitvectors){
+            assert(num_ == bitvector->num_);
+            others.push_back(bitvector->GetBVBlock(i));
+        }
+        blocks_[i]->OrAll(others.data(), others.size());
+    }
+}
+
 
 void BitVector::SetOnes(){
 #   pragma omp parallel for schedule(dynamic)
@@ -69,6 +131,13 @@ void BitVector::SetZeros(){
     }
 }
 
+void BitVector::EnableSummary(){
+#   pragma omp parallel for schedule(dynamic)
+    for(size_t i=0; i < blocks_.size(); i++){
+        blocks_[i]->EnableSummary();
+    }
+}
+
 size_t BitVector::CountOnes() const{
     size_t count = 0;
 #   pragma omp parallel for schedule(dynamic) reduction(+: count)
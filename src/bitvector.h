@@ -36,10 +36,22 @@ public:
     void SetOnes();
     void SetZeros();
     size_t CountOnes() const;
+    //summaries of dead runs in every block, see BitVectorBlock
+    void EnableSummary();
 
     //bitwise combination
     void And(const BitVector* bitvector);
     void Or(const BitVector* bitvector);
+    //this & ~bitvector
+    void AndNot(const BitVector* bitvector);
+    void Xor(const BitVector* bitvector);
+    void Not();
+    //ones of this & bitvector, without writing it
+    size_t AndCount(const BitVector* bitvector) const;
+    //combine with many bit vectors in one pass over each of them,
+    //instead of one And/Or per bit vector
+    void AndAll(const std::vector<const BitVector*> &bitvectors);
+    void OrAll(const std::vector<const BitVector*> &bitvectors);
 
     //bit manipulation
     bool GetBit(size_t pos);
@@ -8,18 +8,202 @@
  *******************************************************************************/
 #include "bitvector_block.h"
 
+#include	<algorithm>
 #include	<cassert>
 #include    <cstdlib>
 #include    <cstring>
+#include    <vector>
+
+#include "cpu_features.h"
+#include "numa_placement.h"
+#include "simd_isa.h"
 
 namespace byteslice{
 
-BitVectorBlock::BitVectorBlock(size_t num):
+//Word-wise operations on bit vector blocks; kNot ignores src
+enum class WordOp{
+    kSet,
+    kAnd,
+    kOr,
+    kAndNot,
+    kXor,
+    kNot
+};
+
+//Word-wise combination of two bit vector blocks, compiled once per
+//instruction set; returns whether any result word is non-zero
+template <class ISA, WordOp OP>
+FORCE_INLINE static bool CombineLoop(WordUnit* dst, const WordUnit* src, size_t num_words){
+    typename ISA::WordVec any = ISA::ZeroWords();
+    size_t i = 0;
+    for(; i + ISA::kNumWordsPerVec <= num_words; i += ISA::kNumWordsPerVec){
+        typename ISA::WordVec x;
+        switch(OP){
+            case WordOp::kSet:
+                x = ISA::LoadWords(src + i);
+                break;
+            case WordOp::kAnd:
+                x = ISA::AndWords(ISA::LoadWords(dst + i), ISA::LoadWords(src + i));
+                break;
+            case WordOp::kOr:
+                x = ISA::OrWords(ISA::LoadWords(dst + i), ISA::LoadWords(src + i));
+                break;
+            case WordOp::kAndNot:
+                x = ISA::AndNotWords(ISA::LoadWords(dst + i), ISA::LoadWords(src + i));
+                break;
+            case WordOp::kXor:
+                x = ISA::XorWords(ISA::LoadWords(dst + i), ISA::LoadWords(src + i));
+                break;
+            case WordOp::kNot:
+                x = ISA::XorWords(ISA::LoadWords(dst + i), ISA::OnesWords());
+                break;
+        }
+        ISA::StoreWords(dst + i, x);
+        any = ISA::OrWords(any, x);
+    }
+    //num_words is a multiple of AVX words; wider vectors may leave a tail
+    WordUnit any_tail = 0;
+    for(; i < num_words; i++){
+        switch(OP){
+            case WordOp::kSet:
+                dst[i] = src[i];
+                break;
+            case WordOp::kAnd:
+                dst[i] &= src[i];
+                break;
+            case WordOp::kOr:
+                dst[i] |= src[i];
+                break;
+            case WordOp::kAndNot:
+                dst[i] &= ~src[i];
+                break;
+            case WordOp::kXor:
+                dst[i] ^= src[i];
+                break;
+            case WordOp::kNot:
+                dst[i] = ~dst[i];
+                break;
+        }
+        any_tail |= dst[i];
+    }
+    return ISA::AnyWords(any) || 0 != any_tail;
+}
+
+//Words of dst combined with a chunk of every source before moving on:
+//the chunk of dst stays in L1 and every source is read once. An AND stops
+//early once a chunk is all zeros.
+static constexpr size_t kNumChunkWords = 512;
+
+template <class ISA, WordOp OP>
+FORCE_INLINE static void CombineAllLoop(WordUnit* dst, const WordUnit* const* srcs,
+        size_t num_srcs, size_t begin_word, size_t end_word){
+    for(size_t begin = begin_word; begin < end_word; begin += kNumChunkWords){
+        const size_t count = std::min(kNumChunkWords, end_word - begin);
+        for(size_t j = 0; j < num_srcs; j++){
+            const bool any = CombineLoop<ISA, OP>(dst + begin, srcs[j] + begin, count);
+            if(WordOp::kAnd == OP && !any){
+                break;
+            }
+        }
+    }
+}
+
+//Ones of a block, or of the AND of two blocks without writing it
+template <class ISA, bool AND>
+FORCE_INLINE static size_t CountLoop(const WordUnit* a, const WordUnit* b, size_t num_words){
+    typename ISA::WordVec sum = ISA::ZeroWords();
+    size_t i = 0;
+    for(; i + ISA::kNumWordsPerVec <= num_words; i += ISA::kNumWordsPerVec){
+        typename ISA::WordVec x = ISA::LoadWords(a + i);
+        if(AND){
+            x = ISA::AndWords(x, ISA::LoadWords(b + i));
+        }
+        sum = ISA::AddWords(sum, ISA::CountWords(x));
+    }
+    size_t count = ISA::ReduceWords(sum);
+    for(; i < num_words; i++){
+        count += POPCNT64(AND ? a[i] & b[i] : a[i]);
+    }
+    return count;
+}
+
+template <WordOp OP>
+TARGET_SSE42 static void CombineSse42(WordUnit* dst, const WordUnit* const* srcs,
+        size_t num_srcs, size_t begin_word, size_t end_word){
+    CombineAllLoop<Sse42Isa, OP>(dst, srcs, num_srcs, begin_word, end_word);
+}
+
+template <WordOp OP>
+TARGET_AVX2 static void CombineAvx2(WordUnit* dst, const WordUnit* const* srcs,
+        size_t num_srcs, size_t begin_word, size_t end_word){
+    CombineAllLoop<Avx2Isa, OP>(dst, srcs, num_srcs, begin_word, end_word);
+}
+
+template <WordOp OP>
+TARGET_AVX512 static void CombineAvx512(WordUnit* dst, const WordUnit* const* srcs,
+        size_t num_srcs, size_t begin_word, size_t end_word){
+    CombineAllLoop<Avx512Isa, OP>(dst, srcs, num_srcs, begin_word, end_word);
+}
+
+//Words [begin_word, end_word) of dst combined with those of every source
+template <WordOp OP>
+static void Combine(WordUnit* dst, const WordUnit* const* srcs, size_t num_srcs,
+        size_t begin_word, size_t end_word){
+    switch(GetSimdLevel()){
+        case SimdLevel::kAVX512:
+            return CombineAvx512<OP>(dst, srcs, num_srcs, begin_word, end_word);
+        case SimdLevel::kAVX2:
+            return CombineAvx2<OP>(dst, srcs, num_srcs, begin_word, end_word);
+        case SimdLevel::kSSE42:
+            return CombineSse42<OP>(dst, srcs, num_srcs, begin_word, end_word);
+    }
+}
+
+template <WordOp OP>
+static void Combine(WordUnit* dst, const WordUnit* src, size_t num_words){
+    Combine<OP>(dst, &src, 1, 0, num_words);
+}
+
+template <bool AND>
+TARGET_SSE42 static size_t CountSse42(const WordUnit* a, const WordUnit* b, size_t num_words){
+    return CountLoop<Sse42Isa, AND>(a, b, num_words);
+}
+
+template <bool AND>
+TARGET_AVX2 static size_t CountAvx2(const WordUnit* a, const WordUnit* b, size_t num_words){
+    return CountLoop<Avx2Isa, AND>(a, b, num_words);
+}
+
+template <bool AND>
+TARGET_AVX512 static size_t CountAvx512(const WordUnit* a, const WordUnit* b, size_t num_words){
+    return CountLoop<Avx512Isa, AND>(a, b, num_words);
+}
+
+template <bool AND>
+static size_t Count(const WordUnit* a, const WordUnit* b, size_t num_words){
+    switch(GetSimdLevel()){
+        case SimdLevel::kAVX512:
+            return CountAvx512<AND>(a, b, num_words);
+        case SimdLevel::kAVX2:
+            return CountAvx2<AND>(a, b, num_words);
+        case SimdLevel::kSSE42:
+            return CountSse42<AND>(a, b, num_words);
+    }
+    return 0;
+}
+
+constexpr size_t BitVectorBlock::kNumSummaryRunWords;
+constexpr size_t BitVectorBlock::kNumSummaryWords;
+
+BitVectorBlock::BitVectorBlock(size_t num, size_t node):
     num_(num), num_word_units_(CEIL(num, kNumAvxBits)*(kNumAvxBits/kNumWordBits)){
     assert(num_ <= kNumTuplesPerBlock);
     // always allocate a full-block's storage
     size_t count = posix_memalign((void**)&data_, 32, sizeof(WordUnit)*CEIL(kNumTuplesPerBlock, kNumWordBits));
     (void)count;
+    //placed before SetOnes first touches the words
+    PlaceOnNode(data_, sizeof(WordUnit)*CEIL(kNumTuplesPerBlock, kNumWordBits), node);
+    memset(summary_, 0, sizeof(summary_));
     SetOnes();
 }
 
@@ -39,6 +223,7 @@ void BitVectorBlock::SetBit(size_t pos){
     size_t offset = pos % kNumWordBits;
     WordUnit mask = 1ULL << offset;
     data_[word_id] |= mask;
+    MarkLive(word_id, true);
 }
 
 void BitVectorBlock::UnsetBit(size_t pos){
@@ -51,41 +236,120 @@ void BitVectorBlock::UnsetBit(size_t pos){
 void BitVectorBlock::SetOnes(){
     memset(data_, 0xff, sizeof(WordUnit)*num_word_units_);
     ClearTail();
+    UpdateSummary();
 }
 
 void BitVectorBlock::SetZeros(){
     memset(data_, 0x0, sizeof(WordUnit)*num_word_units_);
+    memset(summary_, 0, sizeof(summary_));
 }
 
-size_t BitVectorBlock::CountOnes(){
-    size_t count = 0;
-    for(size_t i=0; i<num_word_units_; i++){
-        //count += _mm_popcnt_u64(data_[i]);
-        count += POPCNT64(data_[i]);
+void BitVectorBlock::EnableSummary(){
+    has_summary_ = true;
+    UpdateSummary();
+}
+
+void BitVectorBlock::UpdateSummary(){
+    UpdateSummary(0, num_word_units_);
+}
+
+//Whole runs overlapping the range are rechecked
+void BitVectorBlock::UpdateSummary(size_t begin_word, size_t num_words){
+    if(!has_summary_){
+        return;
     }
+    const size_t end_run = CEIL(begin_word + num_words, kNumSummaryRunWords);
+    for(size_t run = begin_word / kNumSummaryRunWords; run < end_run; run++){
+        const size_t end = std::min((run + 1) * kNumSummaryRunWords, num_word_units_);
+        WordUnit any = 0;
+        for(size_t w = run * kNumSummaryRunWords; w < end; w++){
+            any |= data_[w];
+        }
+        const WordUnit bit = 1ULL << (run % kNumWordBits);
+        summary_[run / kNumWordBits] = 0 != any ?
+            summary_[run / kNumWordBits] | bit : summary_[run / kNumWordBits] & ~bit;
+    }
+}
+
+size_t BitVectorBlock::CountOnes() const{
+    size_t count = 0;
+    ForEachLiveRange([&](size_t begin_word, size_t num_words){
+        count += Count<false>(data_ + begin_word, data_ + begin_word, num_words);
+    });
     return count;
 }
 
+size_t BitVectorBlock::AndCount(const BitVectorBlock* block) const{
+    size_t count = 0;
+    ForEachLiveRange([&](size_t begin_word, size_t num_words){
+        count += Count<true>(data_ + begin_word, block->data_ + begin_word, num_words);
+    });
+    return count;
+}
+
+//AND-like operations leave dead runs dead, so only the live ones are combined
+template <WordOp OP>
+static void CombineLive(BitVectorBlock* block, const WordUnit* const* srcs, size_t num_srcs){
+    block->ForEachLiveRange([&](size_t begin_word, size_t num_words){
+        Combine<OP>(block->data(), srcs, num_srcs, begin_word, begin_word + num_words);
+        block->UpdateSummary(begin_word, num_words);
+    });
+}
+
 void BitVectorBlock::And(const BitVectorBlock* block){
-    for(size_t i=0; i<num_word_units_; i++){
-        data_[i] &= block->GetWordUnit(i);
-    }
+    CombineLive<WordOp::kAnd>(this, &block->data_, 1);
     ClearTail();
 }
 
 void BitVectorBlock::Or(const BitVectorBlock* block){
-    for(size_t i=0; i<num_word_units_; i++){
-        data_[i] |= block->GetWordUnit(i);
-    }
+    Combine<WordOp::kOr>(data_, block->data_, num_word_units_);
     ClearTail();
+    UpdateSummary();
 }
 
 void BitVectorBlock::Set(const BitVectorBlock* block){
-    for(size_t i=0; i<num_word_units_; i++){
-        data_[i] = block->GetWordUnit(i);
+    Combine<WordOp::kSet>(data_, block->data_, num_word_units_);
+    ClearTail();
+    UpdateSummary();
+}
+
+void BitVectorBlock::AndNot(const BitVectorBlock* block){
+    CombineLive<WordOp::kAndNot>(this, &block->data_, 1);
+    ClearTail();
+}
+
+void BitVectorBlock::Xor(const BitVectorBlock* block){
+    Combine<WordOp::kXor>(data_, block->data_, num_word_units_);
+    ClearTail();
+    UpdateSummary();
+}
+
+void BitVectorBlock::Not(){
+    Combine<WordOp::kNot>(data_, data_, num_word_units_);
+    ClearTail();
+    UpdateSummary();
+}
+
+void BitVectorBlock::AndAll(const BitVectorBlock* const* blocks, size_t num_blocks){
+    std::vector<const WordUnit*> srcs(num_blocks);
+    for(size_t i=0; i < num_blocks; i++){
+        assert(num_ == blocks[i]->num_);
+        srcs[i] = blocks[i]->data_;
     }
+    CombineLive<WordOp::kAnd>(this, srcs.data(), num_blocks);
     ClearTail();
-} 
+}
+
+void BitVectorBlock::OrAll(const BitVectorBlock* const* blocks, size_t num_blocks){
+    std::vector<const WordUnit*> srcs(num_blocks);
+    for(size_t i=0; i < num_blocks; i++){
+        assert(num_ == blocks[i]->num_);
+        srcs[i] = blocks[i]->data_;
+    }
+    Combine<WordOp::kOr>(data_, srcs.data(), num_blocks, 0, num_word_units_);
+    ClearTail();
+    UpdateSummary();
+}
 
 
 void BitVectorBlock::ClearTail(){
@@ -9,7 +9,10 @@
 #ifndef _BITVECTOR_BLOCK_H_
 #define _BITVECTOR_BLOCK_H_
 
+#include    <algorithm>
+
 #include "../src/macros.h"
+#include "../src/numa_placement.h"
 #include "../src/param.h"
 #include "../src/types.h"
 
@@ -32,15 +35,42 @@ class BitVectorBlock{
    a multiple of AVX registers
 */
 public:
-    BitVectorBlock(size_t num);
+    //words on a NUMA node (see numa_placement.h)
+    BitVectorBlock(size_t num, size_t node = kAnyNode);
     ~BitVectorBlock();
     void SetOnes();
     void SetZeros();
-    size_t CountOnes();
+    size_t CountOnes() const;
     void ClearTail();
     void And(const BitVectorBlock* block);
     void Or(const BitVectorBlock* block);
     void Set(const BitVectorBlock* block);
+    //this & ~block
+    void AndNot(const BitVectorBlock* block);
+    void Xor(const BitVectorBlock* block);
+    void Not();
+    //ones of this & block, without writing it
+    size_t AndCount(const BitVectorBlock* block) const;
+    //combine with many blocks at once, reading each of them once
+    void AndAll(const BitVectorBlock* const* blocks, size_t num_blocks);
+    void OrAll(const BitVectorBlock* const* blocks, size_t num_blocks);
+
+    //Optional summary: one bit per run of kNumSummaryRunWords words, 0 only
+    //if the run has no ones. AND-like operations, kAnd scans, counting and
+    //iteration then skip the dead runs. The methods here keep it up to
+    //date; code that writes words through data() other than by ANDing
+    //calls UpdateSummary afterwards.
+    static constexpr size_t kNumSummaryRunWords = 64;
+    void EnableSummary();
+    bool has_summary() const;
+    void UpdateSummary();
+    void UpdateSummary(size_t begin_word, size_t num_words);
+    //f(begin_word, num_words) for every range of live runs, in order;
+    //a single range of the whole block without a summary
+    template <typename F>
+    void ForEachLiveRange(F f) const;
+    //first word from word_id on in a live run, num_word_units() if none
+    size_t NextLiveWord(size_t word_id) const;
 
     //bit manipulation
     bool GetBit(size_t pos);
@@ -49,28 +79,91 @@ public:
 
     //mutators
     void SetWordUnit(WordUnit word, size_t pos);
-    void SetAvxUnit(AvxUnit avxunit, size_t start_word_pos);
+    TARGET_AVX2 void SetAvxUnit(AvxUnit avxunit, size_t start_word_pos);
 
     //accessors
     WordUnit GetWordUnit(size_t pos) const;
-    AvxUnit GetAvxUnit(size_t start_word_pos) const;
+    TARGET_AVX2 AvxUnit GetAvxUnit(size_t start_word_pos) const;
     size_t num() const;
     size_t num_word_units() const;
+    WordUnit* data();
+    const WordUnit* data() const;
 
 
 private:
+    static constexpr size_t kNumSummaryWords =
+        CEIL(kNumTuplesPerBlock, kNumWordBits * kNumSummaryRunWords * kNumWordBits);
+
+    bool IsLiveRun(size_t run) const;
+    void MarkLive(size_t word_id, bool live);
+
     WordUnit* data_ = NULL;
     size_t num_;
     size_t num_word_units_;
+    //maintained even when disabled, where it is not read
+    WordUnit summary_[kNumSummaryWords];
+    bool has_summary_ = false;
 
 };
 
+//summary
+inline bool BitVectorBlock::IsLiveRun(size_t run) const{
+    return (summary_[run / kNumWordBits] >> (run % kNumWordBits)) & 1ULL;
+}
+
+//branch-free; a run is never marked dead here
+inline void BitVectorBlock::MarkLive(size_t word_id, bool live){
+    const size_t run = word_id / kNumSummaryRunWords;
+    summary_[run / kNumWordBits] |= WordUnit(live) << (run % kNumWordBits);
+}
+
+inline bool BitVectorBlock::has_summary() const{
+    return has_summary_;
+}
+
+template <typename F>
+inline void BitVectorBlock::ForEachLiveRange(F f) const{
+    if(!has_summary_){
+        f(size_t(0), num_word_units_);
+        return;
+    }
+    const size_t num_runs = CEIL(num_word_units_, kNumSummaryRunWords);
+    size_t run = 0;
+    while(run < num_runs){
+        if(!IsLiveRun(run)){
+            run++;
+            continue;
+        }
+        size_t end = run + 1;
+        while(end < num_runs && IsLiveRun(end)){
+            end++;
+        }
+        const size_t begin_word = run * kNumSummaryRunWords;
+        f(begin_word, std::min(end * kNumSummaryRunWords, num_word_units_) - begin_word);
+        run = end;
+    }
+}
+
+inline size_t BitVectorBlock::NextLiveWord(size_t word_id) const{
+    if(!has_summary_){
+        return word_id;
+    }
+    const size_t num_runs = CEIL(num_word_units_, kNumSummaryRunWords);
+    size_t run = word_id / kNumSummaryRunWords;
+    while(run < num_runs && !IsLiveRun(run)){
+        run++;
+    }
+    return run < num_runs ? std::max(word_id, run * kNumSummaryRunWords) : num_word_units_;
+}
+
 //mutators
 inline void BitVectorBlock::SetWordUnit(WordUnit word, size_t pos){
     data_[pos] = word;
+    MarkLive(pos, 0 != word);
 }
 inline void BitVectorBlock::SetAvxUnit(AvxUnit avxunit, size_t start_word_pos){
     _mm256_storeu_si256((__m256i*)(data_+start_word_pos), avxunit);
+    MarkLive(start_word_pos, !_mm256_testz_si256(avxunit, avxunit));
 }
 
 //accessors
@@ -90,6 +183,14 @@ inline size_t BitVectorBlock::num_word_units() const{
     return num_word_units_;
 }
 
+inline WordUnit* BitVectorBlock::data(){
+    return data_;
+}
+
+inline const WordUnit* BitVectorBlock::data() const{
+    return data_;
+}
+
 
 }   // namespace
 
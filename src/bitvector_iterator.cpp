@@ -8,6 +8,11 @@
  *******************************************************************************/
 #include "bitvector_iterator.h"
 
+#include    <algorithm>
+#include    <cassert>
+
+#include "position_list.h"
+
 namespace byteslice{
 
 BitVectorIterator::BitVectorIterator(const BitVector *bitvector):
@@ -19,5 +24,83 @@ BitVectorIterator::BitVectorIterator(const BitVector *bitvector):
 BitVectorIterator::~BitVectorIterator(){
 }
 
+template <typename T>
+size_t BitVectorIterator::NextBatchHelper(T* positions, size_t max_positions){
+    size_t count = 0;
+    //first what Next left of its word; stack_[stack_top_ - 1] was returned
+    while(stack_top_ > 1 && count < max_positions){
+        positions[count++] = static_cast<T>(stack_[stack_top_ - 2]);
+        stack_top_--;
+    }
+
+    while(count < max_positions && cur_block_id_ < bitvector_->GetNumBlocks()){
+        //words past num() are padding
+        const size_t num_words = CEIL(cur_block_->num(), kNumWordBits);
+        if(cur_word_id_ >= num_words){
+            if(cur_block_id_ + 1 == bitvector_->GetNumBlocks()){
+                //left for Next to step past the last block
+                cur_word_id_ = std::max(cur_word_id_, cur_block_->num_word_units());
+                break;
+            }
+            cur_word_id_ = 0;
+            cur_block_id_++;
+            block_offset_ += cur_block_->num();
+            cur_block_ = bitvector_->GetBVBlock(cur_block_id_);
+            continue;
+        }
+        if(0 == cur_word_id_ % BitVectorBlock::kNumSummaryRunWords){
+            cur_word_id_ = cur_block_->NextLiveWord(cur_word_id_);
+            if(cur_word_id_ >= num_words){
+                continue;
+            }
+        }
+        const uint64_t offset = block_offset_ + cur_word_id_ * kNumWordBits;
+
+        //as many whole words as surely fit, with SIMD; with a summary,
+        //up to the end of the run so that the next one can be skipped
+        size_t num_fit = std::min(num_words - cur_word_id_,
+                (max_positions - count) / kNumWordBits);
+        if(cur_block_->has_summary()){
+            num_fit = std::min(num_fit, BitVectorBlock::kNumSummaryRunWords
+                    - cur_word_id_ % BitVectorBlock::kNumSummaryRunWords);
+        }
+        if(num_fit > 0){
+            const size_t num_bits = std::min(num_fit * kNumWordBits,
+                    cur_block_->num() - cur_word_id_ * kNumWordBits);
+            count += ExtractPositions(cur_block_->data() + cur_word_id_, num_bits, offset,
+                    positions + count);
+            cur_word_id_ += num_fit;
+            continue;
+        }
+
+        //less than a word of room left: bit by bit, keeping the rest for later
+        WordUnit word = cur_block_->GetWordUnit(cur_word_id_);
+        cur_word_id_++;
+        while(0 != word && count < max_positions){
+            positions[count++] = static_cast<T>(offset + __builtin_ctzll(word));
+            word &= word - 1;
+        }
+        if(0 != word){
+            //pushed the way Next does, above a slot for the "current" position
+            stack_top_ = 0;
+            for(size_t bit = kNumWordBits - 1; bit < kNumWordBits; bit--){
+                stack_[stack_top_] = offset + bit;
+                stack_top_ += ((word >> bit) & 1ULL);
+            }
+            stack_top_++;
+        }
+    }
+    return count;
+}
+
+size_t BitVectorIterator::NextBatch(uint32_t* positions, size_t max_positions){
+    assert(bitvector_->num() <= (1ULL << 32));
+    return NextBatchHelper(positions, max_positions);
+}
+
+size_t BitVectorIterator::NextBatch(uint64_t* positions, size_t max_positions){
+    return NextBatchHelper(positions, max_positions);
+}
+
 
 }   // namespace
@@ -9,6 +9,8 @@
 #ifndef BITVECTOR_ITERATOR_H
 #define BITVECTOR_ITERATOR_H
 
+#include    <cstdint>
+
 #include "../src/bitvector.h"
 
 namespace byteslice{
@@ -27,7 +29,17 @@ public:
     bool Next();    //Move the cursor to the next 1, return true if next exists
     size_t GetPosition();   //Return the position of the cursor
 
+    //Write the positions of up to max_positions next 1's, in increasing
+    //order, and return how many were written (0 once exhausted).
+    //Can be mixed with Next; GetPosition is undefined right after a batch.
+    //For all positions at once, see ExtractPositions(const BitVector*, ...)
+    size_t NextBatch(uint32_t* positions, size_t max_positions);
+    size_t NextBatch(uint64_t* positions, size_t max_positions);
+
 private:
+    template <typename T>
+    size_t NextBatchHelper(T* positions, size_t max_positions);
+
     const BitVector *bitvector_;
     size_t stack_[kNumWordBits];
     size_t stack_top_ = 1;  //*top* is the available position to push in new item
@@ -63,6 +75,13 @@ inline bool BitVectorIterator::Next(){
                 }
                 cur_block_ = bitvector_->GetBVBlock(cur_block_id_);
             }
+            //skip the runs the block summary (if any) says are empty
+            if(0 == cur_word_id_ % BitVectorBlock::kNumSummaryRunWords){
+                cur_word_id_ = cur_block_->NextLiveWord(cur_word_id_);
+                if(cur_word_id_ >= cur_block_->num_word_units()){
+                    continue;
+                }
+            }
             word = cur_block_->GetWordUnit(cur_word_id_);
             cur_word_id_++;
         }
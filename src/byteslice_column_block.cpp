@@ -8,22 +8,32 @@
  *******************************************************************************/
 #include "byteslice_column_block.h"
 
+#include    <algorithm>
 #include	<cassert>
 #include    <cstdlib>
 #include    <cstring>
+#include    <functional>
+#include    <iostream>
 
 #include "avx-utility.h"
+#include "cpu_features.h"
+#include "early_stop.h"
+#include "numa_placement.h"
+#include "slice_codec.h"
 
 namespace byteslice{
     
-#ifdef      NEARLYSTOP
-#warning    "Early-stop is disabled in ByteSliceColumnBlock!"
-#endif
-
 static constexpr size_t kPrefetchDistance = 512*2;
 
+//Early-stop policy (see early_stop.h): decisions are made per stride of
+//words; a sampled stride with fewer than 1 stop per kMinEarlyStopRate
+//checks switches the next kNumFullStrides strides to the branch-free kernel.
+static constexpr size_t kNumEarlyStopStrideWords = 64;
+static constexpr size_t kMinEarlyStopRate = 4;
+static constexpr size_t kNumFullStrides = 16;
+
 template <size_t BIT_WIDTH, Direction PDIRECTION>
-ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ByteSliceColumnBlock(size_t num):
+ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ByteSliceColumnBlock(size_t num, size_t node):
     ColumnBlock(
             PDIRECTION==Direction::kLeft ? 
                 ColumnType::kByteSlicePadLeft:ColumnType::kByteSlicePadRight, 
@@ -32,43 +42,184 @@ ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ByteSliceColumnBlock(size_t num):
 {
     //allocate memory space
     assert(num <= kNumTuplesPerBlock);
+    //align to cache line so that 512-bit loads never split lines
     for(size_t i=0; i < kNumBytesPerCode; i++){
-        size_t ret = posix_memalign((void**)&data_[i], 32, kMemSizePerByteSlice);                    
+        size_t ret = posix_memalign((void**)&data_[i], 64, kMemSizePerByteSlice);
         (void)ret;
-        memset(data_[i], 0x0, kMemSizePerByteSlice);
+        //placed before the first touch below
+        PlaceOnNode(data_[i], kMemSizePerByteSlice, node);
+        //FLIPPED zero bytes, so that fresh tuples read as 0
+        memset(data_[i], FLIP(ByteUnit(0)), kMemSizePerByteSlice);
     }
 
 }
 
 template <size_t BIT_WIDTH, Direction PDIRECTION>
 ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::~ByteSliceColumnBlock(){
-    for(size_t i=0; i < kNumBytesPerCode; i++){
-        free(data_[i]);
+    if(!mapped_){
+        for(size_t i=0; i < kNumBytesPerCode; i++){
+            free(data_[i]);
+        }
+    }
+    delete[] imprints_;
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::BuildImprints(){
+    if(nullptr == imprints_){
+        imprints_ = new WordUnit[kNumImprints];
+    }
+    ComputeImprints(0, kNumTuplesPerBlock);
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ComputeImprints(size_t begin, size_t end){
+    for(size_t stride_id = begin / kNumWordBits; stride_id < CEIL(end, kNumWordBits); stride_id++){
+        WordUnit imprint = 0;
+        const ByteUnit* leading = data_[0] + stride_id * kNumWordBits;
+        for(size_t i = 0; i < kNumWordBits; i++){
+            imprint |= 1ULL << (FLIP(leading[i]) >> 2);
+        }
+        imprints_[stride_id] = imprint;
     }
 }
 
 template <size_t BIT_WIDTH, Direction PDIRECTION>
 bool ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::Resize(size_t num){
+    //a mapping only holds the tuples it was written with
+    assert(!mapped_ || num <= num_tuples_);
+    assert(num <= kNumTuplesPerBlock);
+    if(num > num_tuples_){
+        //whatever a shrink left there, the added tuples read as 0
+        for(size_t byte_id = 0; byte_id < kNumBytesPerCode; byte_id++){
+            memset(data_[byte_id] + num_tuples_, FLIP(ByteUnit(0)), num - num_tuples_);
+        }
+        if(nullptr != imprints_){
+            ComputeImprints(num_tuples_, num);
+        }
+        ExtendZoneMap(0, 0);
+    }
     num_tuples_ = num;
     return true;
 }
 
 template <size_t BIT_WIDTH, Direction PDIRECTION>
 void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::
-                    SerToFile(SequentialWriteBinaryFile &file) const{
-    file.Append(&num_tuples_, sizeof(num_tuples_));
+                    SerToFile(SequentialWriteBinaryFile &file, Compression compression) const{
+    SerHeader(file, compression);
+    //trimmed to the tuples in use; whole words stay readable by the scans
+    const size_t slice_size = AlignedSize(num_tuples_);
+    std::vector<char> payload;
     for(size_t byte_id = 0; byte_id < kNumBytesPerCode; byte_id++){
-        file.Append(data_[byte_id], kMemSizePerByteSlice);
+        if(Compression::kNone == compression){
+            file.Append(data_[byte_id], slice_size);
+            continue;
+        }
+        //codec, payload size, payload
+        const SliceCodec codec = EncodeSlice(data_[byte_id], slice_size, payload);
+        const uint64_t payload_size = payload.size();
+        file.Append(&codec, sizeof(codec));
+        file.Append(&payload_size, sizeof(payload_size));
+        file.Append(payload.data(), payload_size);
+    }
+    bool has_imprints = HasImprints();
+    file.Append(&has_imprints, sizeof(has_imprints));
+    if(has_imprints){
+        file.Append(imprints_, sizeof(WordUnit)*kNumImprints);
     }
 }
 
 template <size_t BIT_WIDTH, Direction PDIRECTION>
 void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::
                     DeserFromFile(const SequentialReadBinaryFile &file){
-    file.Read(&num_tuples_, sizeof(num_tuples_));
+    assert(!mapped_);
+    const Compression compression = DeserHeader(file);
+    assert(num_tuples_ <= kNumTuplesPerBlock);
+    const size_t slice_size = AlignedSize(num_tuples_);
+    std::vector<char> payload;
+    for(size_t byte_id = 0; byte_id < kNumBytesPerCode; byte_id++){
+        memset(data_[byte_id] + slice_size, FLIP(ByteUnit(0)), kMemSizePerByteSlice - slice_size);
+        if(Compression::kNone == compression){
+            file.Read(data_[byte_id], slice_size);
+            continue;
+        }
+        SliceCodec codec = SliceCodec::kRaw;
+        uint64_t payload_size = 0;
+        file.Read(&codec, sizeof(codec));
+        file.Read(&payload_size, sizeof(payload_size));
+        if(SliceCodec::kRaw == codec && slice_size == payload_size){
+            //straight into the slice
+            file.Read(data_[byte_id], slice_size);
+            continue;
+        }
+        payload.resize(payload_size);
+        if(payload_size != file.Read(payload.data(), payload_size) ||
+                !DecodeSlice(codec, payload.data(), payload_size, data_[byte_id], slice_size)){
+            std::cerr << "Corrupted byte slice " << byte_id << std::endl;
+            memset(data_[byte_id], FLIP(ByteUnit(0)), slice_size);
+        }
+    }
+    bool has_imprints = false;
+    file.Read(&has_imprints, sizeof(has_imprints));
+    if(has_imprints){
+        if(nullptr == imprints_){
+            imprints_ = new WordUnit[kNumImprints];
+        }
+        file.Read(imprints_, sizeof(WordUnit)*kNumImprints);
+    }
+    else{
+        delete[] imprints_;
+        imprints_ = nullptr;
+    }
+}
+
+//Byte slices are used in place; the small imprints are copied
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+bool ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::MapFromBuffer(const char* buffer,
+                                                        size_t size, size_t &offset){
+    if(!MapHeader(buffer, size, offset) || num_tuples_ > kNumTuplesPerBlock ||
+            offset + kNumBytesPerCode * AlignedSize(num_tuples_) + sizeof(bool) > size){
+        return false;
+    }
+    for(size_t byte_id = 0; byte_id < kNumBytesPerCode; byte_id++){
+        if(!mapped_){
+            free(data_[byte_id]);
+        }
+        data_[byte_id] = reinterpret_cast<ByteUnit*>(const_cast<char*>(buffer + offset));
+        offset += AlignedSize(num_tuples_);
+    }
+    mapped_ = true;
+
+    bool has_imprints = false;
+    memcpy(&has_imprints, buffer + offset, sizeof(has_imprints));
+    offset += sizeof(has_imprints);
+    delete[] imprints_;
+    imprints_ = nullptr;
+    if(has_imprints){
+        if(offset + sizeof(WordUnit)*kNumImprints > size){
+            return false;
+        }
+        imprints_ = new WordUnit[kNumImprints];
+        memcpy(imprints_, buffer + offset, sizeof(WordUnit)*kNumImprints);
+        offset += sizeof(WordUnit)*kNumImprints;
+    }
+    return true;
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+ColumnBlock* ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::Clone(size_t node) const{
+    ByteSliceColumnBlock* block = new ByteSliceColumnBlock(num_tuples_, node);
+    //as much as a record holds; the rest of fresh slices reads as 0 already
+    const size_t slice_size = AlignedSize(num_tuples_);
     for(size_t byte_id = 0; byte_id < kNumBytesPerCode; byte_id++){
-        file.Read(data_[byte_id], kMemSizePerByteSlice);
+        memcpy(block->data_[byte_id], data_[byte_id], slice_size);
+    }
+    block->SetZoneMap(min_value_, max_value_);
+    if(nullptr != imprints_){
+        block->imprints_ = new WordUnit[kNumImprints];
+        memcpy(block->imprints_, imprints_, sizeof(WordUnit)*kNumImprints);
     }
+    return block;
 }
 
 
@@ -77,173 +228,343 @@ template <size_t BIT_WIDTH, Direction PDIRECTION>
 void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::Scan(Comparator comparator,
         WordUnit literal, BitVectorBlock* bvblock, Bitwise bit_opt) const{
     assert(bvblock->num() == num_tuples_);
+    WordUnit* words = bvblock->data();
+    const size_t num_words = CEIL(num_tuples_, kNumWordBits);
+    EarlyStopState early_stop;
+    if(Bitwise::kAnd == bit_opt && bvblock->has_summary()){
+        //only the runs the summary marks live can keep ones
+        bvblock->ForEachLiveRange([&](size_t begin_word, size_t num_live_words){
+            if(begin_word < num_words){
+                const size_t n = std::min(num_live_words, num_words - begin_word);
+                FilterWords(comparator, literal, words + begin_word, begin_word, n,
+                        &early_stop);
+                bvblock->UpdateSummary(begin_word, n);
+            }
+        });
+        return;
+    }
+    switch(comparator){
+        case Comparator::kLess:
+            ScanHelper1<Comparator::kLess>(literal, words, 0, num_words, bit_opt, early_stop);
+            break;
+        case Comparator::kGreater:
+            ScanHelper1<Comparator::kGreater>(literal, words, 0, num_words, bit_opt, early_stop);
+            break;
+        case Comparator::kLessEqual:
+            ScanHelper1<Comparator::kLessEqual>(literal, words, 0, num_words, bit_opt, early_stop);
+            break;
+        case Comparator::kGreaterEqual:
+            ScanHelper1<Comparator::kGreaterEqual>(literal, words, 0, num_words, bit_opt, early_stop);
+            break;
+        case Comparator::kEqual:
+            ScanHelper1<Comparator::kEqual>(literal, words, 0, num_words, bit_opt, early_stop);
+            break;
+        case Comparator::kInequal:
+            ScanHelper1<Comparator::kInequal>(literal, words, 0, num_words, bit_opt, early_stop);
+            break;
+    }
+    bvblock->ClearTail();
+    bvblock->UpdateSummary();
+}
+
+//Conjunctive filter on a range of bit vector words
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::FilterWords(Comparator comparator,
+        WordUnit literal, WordUnit* words, size_t begin_word, size_t num_words,
+        EarlyStopState* shared_early_stop) const{
+    //only the storage bound: a snapshot scan calls this while Append may be
+    //growing num_tuples_, so the caller keeps the range within what it has seen
+    assert((begin_word + num_words) * kNumWordBits <= kNumTuplesPerBlock);
+    EarlyStopState own_early_stop;
+    EarlyStopState &early_stop = (nullptr != shared_early_stop) ?
+        *shared_early_stop : own_early_stop;
     switch(comparator){
         case Comparator::kLess:
-            return ScanHelper1<Comparator::kLess>(literal, bvblock, bit_opt);
+            return ScanHelper2<Comparator::kLess, Bitwise::kAnd>(literal, words, begin_word, num_words, early_stop);
         case Comparator::kGreater:
-            return ScanHelper1<Comparator::kGreater>(literal, bvblock, bit_opt);
+            return ScanHelper2<Comparator::kGreater, Bitwise::kAnd>(literal, words, begin_word, num_words, early_stop);
         case Comparator::kLessEqual:
-            return ScanHelper1<Comparator::kLessEqual>(literal, bvblock, bit_opt);
+            return ScanHelper2<Comparator::kLessEqual, Bitwise::kAnd>(literal, words, begin_word, num_words, early_stop);
         case Comparator::kGreaterEqual:
-            return ScanHelper1<Comparator::kGreaterEqual>(literal, bvblock, bit_opt);
+            return ScanHelper2<Comparator::kGreaterEqual, Bitwise::kAnd>(literal, words, begin_word, num_words, early_stop);
         case Comparator::kEqual:
-            return ScanHelper1<Comparator::kEqual>(literal, bvblock, bit_opt);
+            return ScanHelper2<Comparator::kEqual, Bitwise::kAnd>(literal, words, begin_word, num_words, early_stop);
         case Comparator::kInequal:
-            return ScanHelper1<Comparator::kInequal>(literal, bvblock, bit_opt);
+            return ScanHelper2<Comparator::kInequal, Bitwise::kAnd>(literal, words, begin_word, num_words, early_stop);
     }
 }
 
 template <size_t BIT_WIDTH, Direction PDIRECTION>
 template <Comparator CMP>
 void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ScanHelper1(WordUnit literal,
-                                    BitVectorBlock* bvblock, Bitwise bit_opt) const{
+                    WordUnit* words, size_t begin_word, size_t num_words, Bitwise bit_opt,
+                    EarlyStopState &early_stop) const{
      switch(bit_opt){
         case Bitwise::kSet:
-            return ScanHelper2<CMP, Bitwise::kSet>(literal, bvblock);
+            return ScanHelper2<CMP, Bitwise::kSet>(literal, words, begin_word, num_words, early_stop);
         case Bitwise::kAnd:
-            return ScanHelper2<CMP, Bitwise::kAnd>(literal, bvblock);
+            return ScanHelper2<CMP, Bitwise::kAnd>(literal, words, begin_word, num_words, early_stop);
         case Bitwise::kOr:
-            return ScanHelper2<CMP, Bitwise::kOr>(literal, bvblock);
+            return ScanHelper2<CMP, Bitwise::kOr>(literal, words, begin_word, num_words, early_stop);
     }
 }
 
 template <size_t BIT_WIDTH, Direction PDIRECTION>
 template <Comparator CMP, Bitwise OPT>
 void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ScanHelper2(WordUnit literal,
-                                            BitVectorBlock* bvblock) const {
+                    WordUnit* words, size_t begin_word, size_t num_words,
+                    EarlyStopState &early_stop) const{
+    switch(GetSimdLevel()){
+        case SimdLevel::kAVX512:
+            return ScanAvx512<CMP, OPT>(literal, words, begin_word, num_words, early_stop);
+        case SimdLevel::kAVX2:
+            return ScanAvx2<CMP, OPT>(literal, words, begin_word, num_words, early_stop);
+        case SimdLevel::kSSE42:
+            return ScanSse42<CMP, OPT>(literal, words, begin_word, num_words, early_stop);
+    }
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+template <Comparator CMP, Bitwise OPT>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ScanSse42(WordUnit literal,
+                    WordUnit* words, size_t begin_word, size_t num_words,
+                    EarlyStopState &early_stop) const{
+    ScanLoop<Sse42Isa, CMP, OPT>(literal, words, begin_word, num_words, early_stop);
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+template <Comparator CMP, Bitwise OPT>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ScanAvx2(WordUnit literal,
+                    WordUnit* words, size_t begin_word, size_t num_words,
+                    EarlyStopState &early_stop) const{
+    ScanLoop<Avx2Isa, CMP, OPT>(literal, words, begin_word, num_words, early_stop);
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+template <Comparator CMP, Bitwise OPT>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ScanAvx512(WordUnit literal,
+                    WordUnit* words, size_t begin_word, size_t num_words,
+                    EarlyStopState &early_stop) const{
+    ScanLoop<Avx512Isa, CMP, OPT>(literal, words, begin_word, num_words, early_stop);
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+template <class ISA, Comparator CMP, Bitwise OPT>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ScanLoop(WordUnit literal,
+                    WordUnit* words, size_t begin_word, size_t num_words,
+                    EarlyStopState &early_stop) const{
+    typedef typename ISA::Vec Vec;
+
     //Prepare byte-slices of literal
-    AvxUnit mask_literal[kNumBytesPerCode];
+    Vec mask_literal[kNumBytesPerCode];
     literal &= kCodeMask;
     if(Direction::kRight == PDIRECTION){
         literal <<= kNumPaddingBits;
     }
     for(size_t byte_id=0; byte_id < kNumBytesPerCode; byte_id++){
          ByteUnit byte = FLIP(static_cast<ByteUnit>(literal >> 8*(kNumBytesPerCode - 1 - byte_id)));
-         mask_literal[byte_id] = avx_set1<ByteUnit>(byte);
+         mask_literal[byte_id] = ISA::Set1(byte);
+    }
+
+    //Imprint buckets where every value qualifies, and the literal's own bucket
+    const size_t literal_bucket = static_cast<ByteUnit>(literal >> 8*(kNumBytesPerCode - 1)) >> 2;
+    const WordUnit bucket_maybe = 1ULL << literal_bucket;
+    const WordUnit buckets_below = bucket_maybe - 1;
+    WordUnit bucket_all = 0;
+    switch(CMP){
+        case Comparator::kLess:
+        case Comparator::kLessEqual:
+            bucket_all = buckets_below;
+            break;
+        case Comparator::kGreater:
+        case Comparator::kGreaterEqual:
+            bucket_all = ~(buckets_below | bucket_maybe);
+            break;
+        case Comparator::kEqual:
+            break;
+        case Comparator::kInequal:
+            bucket_all = ~bucket_maybe;
+            break;
     }
     
-    //for every kNumWordBits (64) tuples
-    for(size_t offset = 0, bv_word_id = 0; offset < num_tuples_; offset += kNumWordBits, bv_word_id++){
-        WordUnit bitvector_word = WordUnit(0);
-        //need several iteration of AVX scan
-        for(size_t i=0; i < kNumWordBits; i += kNumAvxBits/8){
-            AvxUnit m_less = avx_zero();
-            AvxUnit m_greater = avx_zero();
-            AvxUnit m_equal; 
-            int input_mask;
+    //Early stop is decided per stride of words. Under kAdaptive, a stride
+    //with early stop samples the stop rate; if few checks stop a chunk,
+    //the next kNumFullStrides strides run branch-free. The decision and the
+    //counters live in early_stop, across the calls of one scan.
+    const EarlyStop policy = GetEarlyStop();
+    EarlyStopStats &stats = early_stop.stats;
+
+    for(size_t stride = 0; stride < num_words; stride += kNumEarlyStopStrideWords){
+        const size_t stride_end = std::min(num_words, stride + kNumEarlyStopStrideWords);
+        bool check = (EarlyStop::kNever != policy);
+        if(EarlyStop::kAdaptive == policy && early_stop.num_full_strides_left > 0){
+            check = false;
+            early_stop.num_full_strides_left--;
+        }
+        size_t num_checks = 0;
+        size_t num_stops = 0;
 
+        //for every kNumWordBits (64) tuples
+        for(size_t w = stride; w < stride_end; w++){
+            const size_t offset = (begin_word + w) * kNumWordBits;
+            if(OPT == Bitwise::kAnd && 0 == words[w]){
+                continue;   //no tuple alive in this word
+            }
+            WordUnit bitvector_word = WordUnit(0);
+            bool decided = false;
+            if(nullptr != imprints_){
+                const WordUnit imprint = imprints_[begin_word + w];
+                if(0 == (imprint & (bucket_all | bucket_maybe))){
+                    decided = true;     //no value can qualify
+                }
+                else if(0 == (imprint & ~bucket_all)){
+                    bitvector_word = -1ULL;
+                    decided = true;     //every value qualifies
+                }
+            }
+            if(!decided){
+                bitvector_word = check ?
+                    ScanWord<ISA, CMP, OPT, true>(mask_literal, offset, words[w],
+                                                    num_checks, num_stops) :
+                    ScanWord<ISA, CMP, OPT, false>(mask_literal, offset, words[w],
+                                                    num_checks, num_stops);
+            }
+            //put result bitvector into bitvector block
+            WordUnit x = bitvector_word;
             switch(OPT){
                 case Bitwise::kSet:
-                    m_equal = avx_ones();
                     break;
                 case Bitwise::kAnd:
-                    input_mask = static_cast<int>(bvblock->GetWordUnit(bv_word_id) >> i);
-                    m_equal = avx_ones();
+                    x &= words[w];
                     break;
                 case Bitwise::kOr:
-                    input_mask = ~static_cast<int>(bvblock->GetWordUnit(bv_word_id) >> i);
-                    m_equal = avx_ones();
+                    x |= words[w];
                     break;
             }
+            words[w] = x;
+        }
 
-            if(
-#ifndef         NEARLYSTOP
-                (OPT==Bitwise::kSet) ||  0 != input_mask
-#else           
-                true
-#endif
-              ){
-                __builtin_prefetch(data_[0] + offset + i + kPrefetchDistance);
-                ScanKernel2<CMP, 0>(
-                        _mm256_lddqu_si256(reinterpret_cast<__m256i*>(data_[0]+offset+i)),
-                        mask_literal[0],
+        if(check){
+            stats.num_strides_checked++;
+            if(EarlyStop::kAdaptive == policy &&
+                    num_stops * kMinEarlyStopRate < num_checks){
+                early_stop.num_full_strides_left = kNumFullStrides;
+            }
+        }
+        else{
+            stats.num_strides_full++;
+        }
+        stats.num_checks += num_checks;
+        stats.num_stops += num_stops;
+    }
+}
+
+//Continue with the next byte slice? Counts the check when early stop is on.
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+template <class ISA, Bitwise OPT, bool EARLY_STOP>
+bool ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::KeepScanning(
+                const typename ISA::Mask &m_equal, WordUnit input_mask,
+                size_t &num_checks, size_t &num_stops) const{
+    if(!EARLY_STOP){
+        return true;
+    }
+    bool any = (OPT == Bitwise::kSet) ? ISA::Any(m_equal) : ISA::AnyIn(m_equal, input_mask);
+    num_checks++;
+    num_stops += !any;
+    return any;
+}
+
+//Scan the 64 tuples of one bit vector word; word is its input for kAnd/kOr
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+template <class ISA, Comparator CMP, Bitwise OPT, bool EARLY_STOP>
+WordUnit ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ScanWord(
+                const typename ISA::Vec* mask_literal, size_t offset, WordUnit word,
+                size_t &num_checks, size_t &num_stops) const{
+    typedef typename ISA::Mask Mask;
+
+    WordUnit bitvector_word = WordUnit(0);
+    //need several iteration of SIMD scan, unless lanes cover a whole word
+    for(size_t i=0; i < kNumWordBits; i += ISA::kNumLanes){
+        Mask m_less = ISA::MaskZero();
+        Mask m_greater = ISA::MaskZero();
+        Mask m_equal = ISA::MaskOnes();
+        WordUnit input_mask = 0;
+
+        switch(OPT){
+            case Bitwise::kSet:
+                break;
+            case Bitwise::kAnd:
+                input_mask = word >> i;
+                break;
+            case Bitwise::kOr:
+                input_mask = ~word >> i;
+                break;
+        }
+        input_mask &= (-1ULL >> (kNumWordBits - ISA::kNumLanes));
+
+        if(!EARLY_STOP || (OPT==Bitwise::kSet) || 0 != input_mask){
+            __builtin_prefetch(data_[0] + offset + i + kPrefetchDistance);
+            ScanKernel<ISA, CMP, 0>(
+                    ISA::Load(data_[0]+offset+i),
+                    mask_literal[0],
+                    m_less,
+                    m_greater,
+                    m_equal);
+            if(kNumBytesPerCode > 1 && KeepScanning<ISA, OPT, EARLY_STOP>(
+                        m_equal, input_mask, num_checks, num_stops)){
+                __builtin_prefetch(data_[1] + offset + i + kPrefetchDistance);
+                ScanKernel<ISA, CMP, 1>(
+                        ISA::Load(data_[1]+offset+i),
+                        mask_literal[1],
                         m_less,
                         m_greater,
                         m_equal);
-                if(kNumBytesPerCode > 1
-#ifndef                 NEARLYSTOP
-                        && ((OPT==Bitwise::kSet && !avx_iszero(m_equal))
-                            || (OPT!=Bitwise::kSet && 0!=(input_mask & _mm256_movemask_epi8(m_equal))))
-#endif
-                  ){
-                    __builtin_prefetch(data_[1] + offset + i + kPrefetchDistance);
-                    ScanKernel2<CMP, 1>(
-                            _mm256_lddqu_si256(reinterpret_cast<__m256i*>(data_[1]+offset+i)),
-                            mask_literal[1],
+                if(kNumBytesPerCode > 2 && KeepScanning<ISA, OPT, EARLY_STOP>(
+                            m_equal, input_mask, num_checks, num_stops)){
+                    ScanKernel<ISA, CMP, 2>(
+                            ISA::Load(data_[2]+offset+i),
+                            mask_literal[2],
                             m_less,
                             m_greater,
                             m_equal);
-                    if(kNumBytesPerCode > 2
-#ifndef                     NEARLYSTOP
-                            && ((OPT==Bitwise::kSet && !avx_iszero(m_equal)) 
-                                || (OPT!=Bitwise::kSet && 0!=(input_mask & _mm256_movemask_epi8(m_equal))))
-#endif
-                      ){
-                        ScanKernel2<CMP, 2>(
-                                _mm256_lddqu_si256(reinterpret_cast<__m256i*>(data_[2]+offset+i)),
-                                mask_literal[2],
+                    if(kNumBytesPerCode > 3 && KeepScanning<ISA, OPT, EARLY_STOP>(
+                                m_equal, input_mask, num_checks, num_stops)){
+                        ScanKernel<ISA, CMP, 3>(
+                                ISA::Load(data_[3]+offset+i),
+                                mask_literal[3],
                                 m_less,
                                 m_greater,
                                 m_equal);
-                        if(kNumBytesPerCode > 3
-#ifndef                         NEARLYSTOP
-                                && ((OPT==Bitwise::kSet && !avx_iszero(m_equal)) 
-                                    || (OPT!=Bitwise::kSet && 0!=(input_mask & _mm256_movemask_epi8(m_equal))))
-#endif
-                          ){
-                            ScanKernel2<CMP, 3>(
-                                    _mm256_lddqu_si256(reinterpret_cast<__m256i*>(data_[3]+offset+i)),
-                                    mask_literal[3],
-                                    m_less,
-                                    m_greater,
-                                    m_equal);
-                        }
                     }
                 }
             }
-
-            AvxUnit m_result;
-            switch(CMP){
-                case Comparator::kLessEqual:
-                    m_result = avx_or(m_less, m_equal);
-                    break;
-                case Comparator::kLess:
-                    m_result = m_less;
-                    break;
-                case Comparator::kGreaterEqual:
-                    m_result = avx_or(m_greater, m_equal);
-                    break;
-                case Comparator::kGreater:
-                    m_result = m_greater;
-                    break;
-                case Comparator::kEqual:
-                    m_result = m_equal;
-                    break;
-                case Comparator::kInequal:
-                    m_result = avx_not(m_equal);
-                    break;
-            }
-            //move mask
-            uint32_t mmask = _mm256_movemask_epi8(m_result);
-            //save in temporary bit vector
-            bitvector_word |= (static_cast<WordUnit>(mmask) << i);
         }
-        //put result bitvector into bitvector block
-        //size_t bv_word_id = offset / kNumWordBits;
-        WordUnit x = bitvector_word;
-        switch(OPT){
-            case Bitwise::kSet:
+
+        Mask m_result;
+        switch(CMP){
+            case Comparator::kLessEqual:
+                m_result = ISA::Or(m_less, m_equal);
                 break;
-            case Bitwise::kAnd:
-                x &= bvblock->GetWordUnit(bv_word_id);
+            case Comparator::kLess:
+                m_result = m_less;
                 break;
-            case Bitwise::kOr:
-                x |= bvblock->GetWordUnit(bv_word_id);
+            case Comparator::kGreaterEqual:
+                m_result = ISA::Or(m_greater, m_equal);
+                break;
+            case Comparator::kGreater:
+                m_result = m_greater;
+                break;
+            case Comparator::kEqual:
+                m_result = m_equal;
+                break;
+            case Comparator::kInequal:
+                m_result = ISA::Not(m_equal);
                 break;
         }
-        bvblock->SetWordUnit(x, bv_word_id);
+        //move mask and save in temporary bit vector
+        bitvector_word |= (ISA::ToBits(m_result) << i);
     }
-    bvblock->ClearTail();
+    return bitvector_word;
 }
 
 //Scan against other block
@@ -297,66 +618,104 @@ template <Comparator CMP, Bitwise OPT>
 void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ScanHelper2(
                             const ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>* other_block,
                             BitVectorBlock* bvblock) const {
+    switch(GetSimdLevel()){
+        case SimdLevel::kAVX512:
+            return ScanAvx512<CMP, OPT>(other_block, bvblock);
+        case SimdLevel::kAVX2:
+            return ScanAvx2<CMP, OPT>(other_block, bvblock);
+        case SimdLevel::kSSE42:
+            return ScanSse42<CMP, OPT>(other_block, bvblock);
+    }
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+template <Comparator CMP, Bitwise OPT>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ScanSse42(
+                            const ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>* other_block,
+                            BitVectorBlock* bvblock) const {
+    ScanLoop<Sse42Isa, CMP, OPT>(other_block, bvblock);
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+template <Comparator CMP, Bitwise OPT>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ScanAvx2(
+                            const ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>* other_block,
+                            BitVectorBlock* bvblock) const {
+    ScanLoop<Avx2Isa, CMP, OPT>(other_block, bvblock);
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+template <Comparator CMP, Bitwise OPT>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ScanAvx512(
+                            const ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>* other_block,
+                            BitVectorBlock* bvblock) const {
+    ScanLoop<Avx512Isa, CMP, OPT>(other_block, bvblock);
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+template <class ISA, Comparator CMP, Bitwise OPT>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ScanLoop(
+                            const ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>* other_block,
+                            BitVectorBlock* bvblock) const {
+    typedef typename ISA::Mask Mask;
 
     //for every kNumWordBits (64) tuples
     for(size_t offset = 0, bv_word_id = 0; offset < num_tuples_; offset += kNumWordBits, bv_word_id++){
         WordUnit bitvector_word = WordUnit(0);
-        //need several iteration of AVX scan
-        for(size_t i=0; i < kNumWordBits; i += kNumAvxBits/8){
-            AvxUnit m_less = avx_zero();
-            AvxUnit m_greater = avx_zero();
-            AvxUnit m_equal; 
-            int input_mask = static_cast<int>(-1ULL);
+        //need several iteration of SIMD scan, unless lanes cover a whole word
+        for(size_t i=0; i < kNumWordBits; i += ISA::kNumLanes){
+            Mask m_less = ISA::MaskZero();
+            Mask m_greater = ISA::MaskZero();
+            Mask m_equal = ISA::MaskOnes();
+            WordUnit input_mask = 0;
 
             switch(OPT){
                 case Bitwise::kSet:
-                    m_equal = avx_ones();
                     break;
                 case Bitwise::kAnd:
-                    input_mask = static_cast<int>(bvblock->GetWordUnit(bv_word_id) >> i);
-                    m_equal = avx_ones();
+                    input_mask = bvblock->GetWordUnit(bv_word_id) >> i;
                     break;
                 case Bitwise::kOr:
-                    input_mask = ~static_cast<int>(bvblock->GetWordUnit(bv_word_id) >> i);
-                    m_equal = avx_ones();
+                    input_mask = ~bvblock->GetWordUnit(bv_word_id) >> i;
                     break;
             }
+            input_mask &= (-1ULL >> (kNumWordBits - ISA::kNumLanes));
 
             if((OPT==Bitwise::kSet) ||  0 != input_mask){
                 __builtin_prefetch(data_[0] + offset + i + 1024);
                 __builtin_prefetch(other_block->data_[0] + offset + i + 1024);
-                ScanKernel2<CMP, 0>(
-                        _mm256_lddqu_si256(reinterpret_cast<__m256i*>(data_[0]+offset+i)),
-                        _mm256_lddqu_si256(reinterpret_cast<__m256i*>(other_block->data_[0]+offset+i)),
+                ScanKernel<ISA, CMP, 0>(
+                        ISA::Load(data_[0]+offset+i),
+                        ISA::Load(other_block->data_[0]+offset+i),
                         m_less,
                         m_greater,
                         m_equal);
                 if(kNumBytesPerCode > 1 && 
-                        ((OPT==Bitwise::kSet && !avx_iszero(m_equal)) 
-                        || (OPT!=Bitwise::kSet && 0!=(input_mask & _mm256_movemask_epi8(m_equal))))){
+                        ((OPT==Bitwise::kSet && ISA::Any(m_equal))
+                        || (OPT!=Bitwise::kSet && ISA::AnyIn(m_equal, input_mask)))){
                     __builtin_prefetch(data_[1] + offset + i + 1024);
                     __builtin_prefetch(other_block->data_[1] + offset + i + 1024);
-                    ScanKernel2<CMP, 1>(
-                            _mm256_lddqu_si256(reinterpret_cast<__m256i*>(data_[1]+offset+i)),
-                            _mm256_lddqu_si256(reinterpret_cast<__m256i*>(other_block->data_[1]+offset+i)),
+                    ScanKernel<ISA, CMP, 1>(
+                            ISA::Load(data_[1]+offset+i),
+                            ISA::Load(other_block->data_[1]+offset+i),
                             m_less,
                             m_greater,
                             m_equal);
                     if(kNumBytesPerCode > 2 && 
-                            ((OPT==Bitwise::kSet && !avx_iszero(m_equal)) 
-                            || (OPT!=Bitwise::kSet && 0!=(input_mask & _mm256_movemask_epi8(m_equal))))){
-                        ScanKernel2<CMP, 2>(
-                                _mm256_lddqu_si256(reinterpret_cast<__m256i*>(data_[2]+offset+i)),
-                                _mm256_lddqu_si256(reinterpret_cast<__m256i*>(other_block->data_[2]+offset+i)),
+                            ((OPT==Bitwise::kSet && ISA::Any(m_equal))
+                            || (OPT!=Bitwise::kSet && ISA::AnyIn(m_equal, input_mask)))){
+                        ScanKernel<ISA, CMP, 2>(
+                                ISA::Load(data_[2]+offset+i),
+                                ISA::Load(other_block->data_[2]+offset+i),
                                 m_less,
                                 m_greater,
                                 m_equal);
                         if(kNumBytesPerCode > 3 && 
-                                ((OPT==Bitwise::kSet && !avx_iszero(m_equal)) 
-                                || (OPT!=Bitwise::kSet && 0!=(input_mask & _mm256_movemask_epi8(m_equal))))){
-                            ScanKernel2<CMP, 3>(
-                                    _mm256_lddqu_si256(reinterpret_cast<__m256i*>(data_[3]+offset+i)),
-                                    _mm256_lddqu_si256(reinterpret_cast<__m256i*>(other_block->data_[3]+offset+i)),
+                                ((OPT==Bitwise::kSet && ISA::Any(m_equal))
+                                || (OPT!=Bitwise::kSet && ISA::AnyIn(m_equal, input_mask)))){
+                            ScanKernel<ISA, CMP, 3>(
+                                    ISA::Load(data_[3]+offset+i),
+                                    ISA::Load(other_block->data_[3]+offset+i),
                                     m_less,
                                     m_greater,
                                     m_equal);
@@ -366,16 +725,16 @@ void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ScanHelper2(
             }
 
 
-            AvxUnit m_result;
+            Mask m_result;
             switch(CMP){
                 case Comparator::kLessEqual:
-                    m_result = avx_or(m_less, m_equal);
+                    m_result = ISA::Or(m_less, m_equal);
                     break;
                 case Comparator::kLess:
                     m_result = m_less;
                     break;
                 case Comparator::kGreaterEqual:
-                    m_result = avx_or(m_greater, m_equal);
+                    m_result = ISA::Or(m_greater, m_equal);
                     break;
                 case Comparator::kGreater:
                     m_result = m_greater;
@@ -384,13 +743,11 @@ void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ScanHelper2(
                     m_result = m_equal;
                     break;
                 case Comparator::kInequal:
-                    m_result = avx_not(m_equal);
+                    m_result = ISA::Not(m_equal);
                     break;
             }
-            //move mask
-            uint32_t mmask = _mm256_movemask_epi8(m_result);
-            //save in temporary bit vector
-            bitvector_word |= (static_cast<WordUnit>(mmask) << i);
+            //move mask and save in temporary bit vector
+            bitvector_word |= (ISA::ToBits(m_result) << i);
         }
         //put result bitvector into bitvector block
         WordUnit x = bitvector_word;
@@ -411,114 +768,960 @@ void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ScanHelper2(
 }
 
 
-//Scan Kernel
+//Scan against range [lower, upper]
+//Both bounds are compared in the same pass over the byte slices
 template <size_t BIT_WIDTH, Direction PDIRECTION>
-template <Comparator CMP>
-inline void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ScanKernel
-                                                        (const AvxUnit &byteslice1,
-                                                         const AvxUnit &byteslice2,
-                                                         AvxUnit &mask_less,
-                                                         AvxUnit &mask_greater,
-                                                         AvxUnit &mask_equal) const {
-    switch(CMP){
-        case Comparator::kEqual:
-        case Comparator::kInequal:
-            mask_equal = 
-                avx_and(mask_equal, avx_cmpeq<ByteUnit>(byteslice1, byteslice2));
-            break;
-        case Comparator::kLess:
-        case Comparator::kLessEqual:
-            mask_less = 
-                avx_or(mask_less, avx_and(mask_equal, avx_cmplt<ByteUnit>(byteslice1, byteslice2)));
-            mask_equal = 
-                avx_and(mask_equal, avx_cmpeq<ByteUnit>(byteslice1, byteslice2));
-            break;
-        case Comparator::kGreater:
-        case Comparator::kGreaterEqual:
-            mask_greater =
-                avx_or(mask_greater, avx_and(mask_equal, avx_cmpgt<ByteUnit>(byteslice1, byteslice2)));
-            mask_equal = 
-                avx_and(mask_equal, avx_cmpeq<ByteUnit>(byteslice1, byteslice2));
-            break;
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ScanBetween(WordUnit lower,
+        WordUnit upper, BitVectorBlock* bvblock, Bitwise bit_opt) const{
+    assert(bvblock->num() == num_tuples_);
+    //bounds outside the code range would be truncated by the kernel
+    if(upper > kCodeMask){
+        upper = kCodeMask;
+    }
+    if(lower > kCodeMask || lower > upper){
+        lower = 1;
+        upper = 0;  //empty range
+    }
+    switch(bit_opt){
+        case Bitwise::kSet:
+            return ScanBetweenHelper<Bitwise::kSet>(lower, upper, bvblock);
+        case Bitwise::kAnd:
+            return ScanBetweenHelper<Bitwise::kAnd>(lower, upper, bvblock);
+        case Bitwise::kOr:
+            return ScanBetweenHelper<Bitwise::kOr>(lower, upper, bvblock);
     }
 }
 
-//Scan Kernel2 --- Optimized on Scan Kernel
-//to remove unnecessary equal comparison for last byte slice
 template <size_t BIT_WIDTH, Direction PDIRECTION>
-template <Comparator CMP, size_t BYTE_ID>
-inline void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ScanKernel2
-                                                        (const AvxUnit &byteslice1,
-                                                         const AvxUnit &byteslice2,
-                                                         AvxUnit &mask_less,
-                                                         AvxUnit &mask_greater,
-                                                         AvxUnit &mask_equal) const {
-
-    //internal ByteSlice --- not last BS                                                        
-    if(BYTE_ID < kNumBytesPerCode - 1){ 
-        switch(CMP){
-            case Comparator::kEqual:
-            case Comparator::kInequal:
-                mask_equal = 
-                    avx_and(mask_equal, avx_cmpeq<ByteUnit>(byteslice1, byteslice2));
-                break;
-            case Comparator::kLess:
-            case Comparator::kLessEqual:
-                mask_less = 
-                    avx_or(mask_less, avx_and(mask_equal, avx_cmplt<ByteUnit>(byteslice1, byteslice2)));
-                mask_equal = 
-                    avx_and(mask_equal, avx_cmpeq<ByteUnit>(byteslice1, byteslice2));
-                break;
-            case Comparator::kGreater:
-            case Comparator::kGreaterEqual:
-                mask_greater =
-                    avx_or(mask_greater, avx_and(mask_equal, avx_cmpgt<ByteUnit>(byteslice1, byteslice2)));
-                mask_equal = 
-                    avx_and(mask_equal, avx_cmpeq<ByteUnit>(byteslice1, byteslice2));
-                break;
-        }
-    }
-    //last BS: no need to compute mask_equal for some comparisons
-    else if(BYTE_ID == kNumBytesPerCode - 1){   
-        switch(CMP){
-            case Comparator::kEqual:
-            case Comparator::kInequal:
-                mask_equal = 
-                    avx_and(mask_equal, avx_cmpeq<ByteUnit>(byteslice1, byteslice2));
-                break;
-            case Comparator::kLessEqual:
-                mask_less = 
-                    avx_or(mask_less, avx_and(mask_equal, avx_cmplt<ByteUnit>(byteslice1, byteslice2)));
-                mask_equal = 
-                    avx_and(mask_equal, avx_cmpeq<ByteUnit>(byteslice1, byteslice2));
-                break;
-            case Comparator::kLess:
-                mask_less = 
-                    avx_or(mask_less, avx_and(mask_equal, avx_cmplt<ByteUnit>(byteslice1, byteslice2)));
-                break;
-            case Comparator::kGreaterEqual:
-                mask_greater =
-                    avx_or(mask_greater, avx_and(mask_equal, avx_cmpgt<ByteUnit>(byteslice1, byteslice2)));
-                mask_equal = 
-                    avx_and(mask_equal, avx_cmpeq<ByteUnit>(byteslice1, byteslice2));
-                break;
-            case Comparator::kGreater:
-                mask_greater =
-                    avx_or(mask_greater, avx_and(mask_equal, avx_cmpgt<ByteUnit>(byteslice1, byteslice2)));
-                break;
-        }
+template <Bitwise OPT>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ScanBetweenHelper(WordUnit lower,
+                                WordUnit upper, BitVectorBlock* bvblock) const{
+    switch(GetSimdLevel()){
+        case SimdLevel::kAVX512:
+            return ScanBetweenAvx512<OPT>(lower, upper, bvblock);
+        case SimdLevel::kAVX2:
+            return ScanBetweenAvx2<OPT>(lower, upper, bvblock);
+        case SimdLevel::kSSE42:
+            return ScanBetweenSse42<OPT>(lower, upper, bvblock);
     }
-    //otherwise, do nothing
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+template <Bitwise OPT>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ScanBetweenSse42(WordUnit lower,
+                                WordUnit upper, BitVectorBlock* bvblock) const{
+    ScanBetweenLoop<Sse42Isa, OPT>(lower, upper, bvblock);
+}
 
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+template <Bitwise OPT>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ScanBetweenAvx2(WordUnit lower,
+                                WordUnit upper, BitVectorBlock* bvblock) const{
+    ScanBetweenLoop<Avx2Isa, OPT>(lower, upper, bvblock);
 }
 
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+template <Bitwise OPT>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ScanBetweenAvx512(WordUnit lower,
+                                WordUnit upper, BitVectorBlock* bvblock) const{
+    ScanBetweenLoop<Avx512Isa, OPT>(lower, upper, bvblock);
+}
 
 template <size_t BIT_WIDTH, Direction PDIRECTION>
-void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::BulkLoadArray(const WordUnit* codes,
-                                                        size_t num, size_t start_pos){
-    assert(start_pos + num <= num_tuples_);
-    for(size_t i = 0; i < num; i++){
-        SetTuple(start_pos+i, codes[i]);
+template <class ISA, Bitwise OPT>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ScanBetweenLoop(WordUnit lower,
+                                WordUnit upper, BitVectorBlock* bvblock) const{
+    typedef typename ISA::Vec Vec;
+    typedef typename ISA::Mask Mask;
+
+    //Prepare byte-slices of both bounds
+    Vec mask_lower[kNumBytesPerCode];
+    Vec mask_upper[kNumBytesPerCode];
+    if(Direction::kRight == PDIRECTION){
+        lower <<= kNumPaddingBits;
+        upper <<= kNumPaddingBits;
+    }
+    for(size_t byte_id=0; byte_id < kNumBytesPerCode; byte_id++){
+        size_t shift = 8*(kNumBytesPerCode - 1 - byte_id);
+        mask_lower[byte_id] = ISA::Set1(FLIP(static_cast<ByteUnit>(lower >> shift)));
+        mask_upper[byte_id] = ISA::Set1(FLIP(static_cast<ByteUnit>(upper >> shift)));
+    }
+
+    //for every kNumWordBits (64) tuples
+    for(size_t offset = 0, bv_word_id = 0; offset < num_tuples_; offset += kNumWordBits, bv_word_id++){
+        WordUnit bitvector_word = WordUnit(0);
+        for(size_t i=0; i < kNumWordBits; i += ISA::kNumLanes){
+            Mask m_greater_lower = ISA::MaskZero();
+            Mask m_equal_lower = ISA::MaskOnes();
+            Mask m_less_upper = ISA::MaskZero();
+            Mask m_equal_upper = ISA::MaskOnes();
+            WordUnit input_mask = 0;
+
+            switch(OPT){
+                case Bitwise::kSet:
+                    break;
+                case Bitwise::kAnd:
+                    input_mask = bvblock->GetWordUnit(bv_word_id) >> i;
+                    break;
+                case Bitwise::kOr:
+                    input_mask = ~bvblock->GetWordUnit(bv_word_id) >> i;
+                    break;
+            }
+            input_mask &= (-1ULL >> (kNumWordBits - ISA::kNumLanes));
+
+            //a lane is undecided while it ties with either bound
+            if((OPT==Bitwise::kSet) ||  0 != input_mask){
+                __builtin_prefetch(data_[0] + offset + i + kPrefetchDistance);
+                ScanBetweenKernel<ISA, 0>(
+                        ISA::Load(data_[0]+offset+i),
+                        mask_lower[0], mask_upper[0],
+                        m_greater_lower, m_equal_lower,
+                        m_less_upper, m_equal_upper);
+                Mask m_undecided = ISA::Or(m_equal_lower, m_equal_upper);
+                if(kNumBytesPerCode > 1 &&
+                        ((OPT==Bitwise::kSet && ISA::Any(m_undecided))
+                        || (OPT!=Bitwise::kSet && ISA::AnyIn(m_undecided, input_mask)))){
+                    __builtin_prefetch(data_[1] + offset + i + kPrefetchDistance);
+                    ScanBetweenKernel<ISA, 1>(
+                            ISA::Load(data_[1]+offset+i),
+                            mask_lower[1], mask_upper[1],
+                            m_greater_lower, m_equal_lower,
+                            m_less_upper, m_equal_upper);
+                    m_undecided = ISA::Or(m_equal_lower, m_equal_upper);
+                    if(kNumBytesPerCode > 2 &&
+                            ((OPT==Bitwise::kSet && ISA::Any(m_undecided))
+                            || (OPT!=Bitwise::kSet && ISA::AnyIn(m_undecided, input_mask)))){
+                        ScanBetweenKernel<ISA, 2>(
+                                ISA::Load(data_[2]+offset+i),
+                                mask_lower[2], mask_upper[2],
+                                m_greater_lower, m_equal_lower,
+                                m_less_upper, m_equal_upper);
+                        m_undecided = ISA::Or(m_equal_lower, m_equal_upper);
+                        if(kNumBytesPerCode > 3 &&
+                                ((OPT==Bitwise::kSet && ISA::Any(m_undecided))
+                                || (OPT!=Bitwise::kSet && ISA::AnyIn(m_undecided, input_mask)))){
+                            ScanBetweenKernel<ISA, 3>(
+                                    ISA::Load(data_[3]+offset+i),
+                                    mask_lower[3], mask_upper[3],
+                                    m_greater_lower, m_equal_lower,
+                                    m_less_upper, m_equal_upper);
+                        }
+                    }
+                }
+            }
+
+            //(value >= lower) AND (value <= upper)
+            Mask m_result = ISA::And(ISA::Or(m_greater_lower, m_equal_lower),
+                                     ISA::Or(m_less_upper, m_equal_upper));
+            bitvector_word |= (ISA::ToBits(m_result) << i);
+        }
+        WordUnit x = bitvector_word;
+        switch(OPT){
+            case Bitwise::kSet:
+                break;
+            case Bitwise::kAnd:
+                x &= bvblock->GetWordUnit(bv_word_id);
+                break;
+            case Bitwise::kOr:
+                x |= bvblock->GetWordUnit(bv_word_id);
+                break;
+        }
+        bvblock->SetWordUnit(x, bv_word_id);
+    }
+    bvblock->ClearTail();
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+template <class ISA, size_t BYTE_ID>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ScanBetweenKernel
+                                    (const typename ISA::Vec &byteslice,
+                                     const typename ISA::Vec &lower,
+                                     const typename ISA::Vec &upper,
+                                     typename ISA::Mask &mask_greater_lower,
+                                     typename ISA::Mask &mask_equal_lower,
+                                     typename ISA::Mask &mask_less_upper,
+                                     typename ISA::Mask &mask_equal_upper) const {
+    mask_greater_lower = ISA::Or(mask_greater_lower,
+            ISA::CmpGt(mask_equal_lower, byteslice, lower));
+    mask_equal_lower = ISA::CmpEq(mask_equal_lower, byteslice, lower);
+    mask_less_upper = ISA::Or(mask_less_upper,
+            ISA::CmpLt(mask_equal_upper, byteslice, upper));
+    mask_equal_upper = ISA::CmpEq(mask_equal_upper, byteslice, upper);
+}
+
+
+//Scan against a list of values
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ScanIn(const WordUnit* values,
+        size_t num_values, BitVectorBlock* bvblock, Bitwise bit_opt) const{
+    assert(bvblock->num() == num_tuples_);
+
+    InList list;
+    for(size_t v = 0; v < num_values; v++){
+        //values beyond the code range can never match
+        if(values[v] <= kCodeMask){
+            list.codes.push_back(values[v]);
+        }
+    }
+    std::sort(list.codes.begin(), list.codes.end());
+    list.codes.erase(std::unique(list.codes.begin(), list.codes.end()), list.codes.end());
+
+    //Split into byte slices. Sorted codes keep equal prefixes adjacent, so
+    //the list reads as a trie: the codes sharing byte slices 0..i are a run.
+    const size_t num_codes = list.codes.size();
+    memset(list.lut, 0x0, sizeof(list.lut));
+    list.diverge.resize(num_codes);
+    list.num_groups = 0;
+    for(size_t v = 0; v < num_codes; v++){
+        WordUnit code = list.codes[v];
+        if(Direction::kRight == PDIRECTION){
+            code <<= kNumPaddingBits;
+        }
+        for(size_t byte_id = 0; byte_id < kNumBytesPerCode; byte_id++){
+            list.bytes[byte_id].push_back(
+                FLIP(static_cast<ByteUnit>(code >> 8*(kNumBytesPerCode - 1 - byte_id))));
+        }
+        size_t byte_id = 0;
+        while(v > 0 && byte_id < kNumBytesPerCode
+                && list.bytes[byte_id][v] == list.bytes[byte_id][v-1]){
+            byte_id++;
+        }
+        list.diverge[v] = byte_id;
+        ByteUnit first = list.bytes[0][v];
+        if(0 == byte_id){
+            list.group_begin[first] = v;
+            list.num_groups++;
+        }
+        list.lut[first >> 7][first & 0x0f] |= 1 << ((first >> 4) & 0x7);
+    }
+    for(size_t byte_id = 0; byte_id < kNumBytesPerCode; byte_id++){
+        list.run_end[byte_id].resize(num_codes);
+        for(size_t v = num_codes; v-- > 0;){
+            list.run_end[byte_id][v] = (v + 1 < num_codes && list.diverge[v+1] > byte_id) ?
+                list.run_end[byte_id][v+1] : v + 1;
+        }
+    }
+    list.use_lut = (list.num_groups > kInListMaxGroups);
+
+    switch(bit_opt){
+        case Bitwise::kSet:
+            return ScanInHelper<Bitwise::kSet>(list, bvblock);
+        case Bitwise::kAnd:
+            return ScanInHelper<Bitwise::kAnd>(list, bvblock);
+        case Bitwise::kOr:
+            return ScanInHelper<Bitwise::kOr>(list, bvblock);
+    }
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+template <Bitwise OPT>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ScanInHelper(const InList &list,
+                                            BitVectorBlock* bvblock) const{
+    switch(GetSimdLevel()){
+        case SimdLevel::kAVX512:
+            return ScanInAvx512<OPT>(list, bvblock);
+        case SimdLevel::kAVX2:
+            return ScanInAvx2<OPT>(list, bvblock);
+        case SimdLevel::kSSE42:
+            return ScanInSse42<OPT>(list, bvblock);
+    }
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+template <Bitwise OPT>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ScanInSse42(const InList &list,
+                                            BitVectorBlock* bvblock) const{
+    ScanInLoop<Sse42Isa, OPT>(list, bvblock);
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+template <Bitwise OPT>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ScanInAvx2(const InList &list,
+                                            BitVectorBlock* bvblock) const{
+    ScanInLoop<Avx2Isa, OPT>(list, bvblock);
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+template <Bitwise OPT>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ScanInAvx512(const InList &list,
+                                            BitVectorBlock* bvblock) const{
+    ScanInLoop<Avx512Isa, OPT>(list, bvblock);
+}
+
+//Every chunk of lanes is checked against the whole list while its byte
+//slices are hot. Few prefixes: compare slice 0 per prefix group. Many
+//prefixes: filter slice 0 through the membership table, then take the
+//groups of the surviving lanes only. Either way, the lanes of a group are
+//narrowed slice by slice (see ScanInGroup).
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+template <class ISA, Bitwise OPT>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ScanInLoop(const InList &list,
+                                            BitVectorBlock* bvblock) const{
+    typedef typename ISA::Vec Vec;
+    typedef typename ISA::Mask Mask;
+
+    const size_t num_groups = list.num_groups;
+    const Vec table_lo = ISA::Broadcast16(list.lut[0]);
+    const Vec table_hi = ISA::Broadcast16(list.lut[1]);
+
+    //for every kNumWordBits (64) tuples
+    for(size_t offset = 0, bv_word_id = 0; offset < num_tuples_; offset += kNumWordBits, bv_word_id++){
+        WordUnit bitvector_word = WordUnit(0);
+        for(size_t i=0; i < kNumWordBits; i += ISA::kNumLanes){
+            WordUnit input_mask = -1ULL;
+            switch(OPT){
+                case Bitwise::kSet:
+                    break;
+                case Bitwise::kAnd:
+                    input_mask = bvblock->GetWordUnit(bv_word_id) >> i;
+                    break;
+                case Bitwise::kOr:
+                    input_mask = ~bvblock->GetWordUnit(bv_word_id) >> i;
+                    break;
+            }
+            input_mask &= (-1ULL >> (kNumWordBits - ISA::kNumLanes));
+            if(0 == input_mask || 0 == num_groups){
+                continue;
+            }
+
+            __builtin_prefetch(data_[0] + offset + i + kPrefetchDistance);
+            const Vec slice0 = ISA::Load(data_[0]+offset+i);
+            Mask m_result = ISA::MaskZero();
+            WordUnit scalar_bits = 0;
+            if(list.use_lut){
+                Mask m_member = ISA::InByteSet(ISA::MaskOnes(), slice0, table_lo, table_hi);
+                WordUnit candidates = ISA::ToBits(m_member) & input_mask;
+                if(1 == kNumBytesPerCode){
+                    candidates = 0;
+                    m_result = m_member;
+                }
+                //one group per distinct slice-0 byte among the candidates
+                while(0 != candidates){
+                    const ByteUnit first = data_[0][offset + i + __builtin_ctzll(candidates)];
+                    Mask m_prefix = ISA::CmpEq(ISA::MaskOnes(), slice0, ISA::Set1(first));
+                    candidates &= ~ISA::ToBits(m_prefix);
+                    m_result = ISA::Or(m_result, ScanInGroup<ISA>(list, offset + i, input_mask,
+                                list.group_begin[first], m_prefix, scalar_bits));
+                }
+            }
+            else{
+                for(size_t begin = 0; begin < list.codes.size(); begin = list.run_end[0][begin]){
+                    Mask m_prefix = ISA::CmpEq(ISA::MaskOnes(), slice0,
+                                                ISA::Set1(list.bytes[0][begin]));
+                    if(!ISA::AnyIn(m_prefix, input_mask)){
+                        continue;   //prunes every code of this group
+                    }
+                    m_result = ISA::Or(m_result, ScanInGroup<ISA>(list, offset + i, input_mask,
+                                begin, m_prefix, scalar_bits));
+                }
+            }
+            WordUnit lane_bits = ISA::ToBits(m_result) | scalar_bits;
+            bitvector_word |= (lane_bits << i);
+        }
+        WordUnit x = bitvector_word;
+        switch(OPT){
+            case Bitwise::kSet:
+                break;
+            case Bitwise::kAnd:
+                x &= bvblock->GetWordUnit(bv_word_id);
+                break;
+            case Bitwise::kOr:
+                x |= bvblock->GetWordUnit(bv_word_id);
+                break;
+        }
+        bvblock->SetWordUnit(x, bv_word_id);
+    }
+    bvblock->ClearTail();
+}
+
+//Lanes in m_prefix match byte slice 0 of the group starting at codes[begin].
+//Walk the group as a trie: every distinct prefix is compared once against
+//its byte slice, and a prefix that leaves no lane prunes all of its codes.
+//Once a prefix holds only a few lanes, those are looked up among its codes
+//one by one and reported in scalar_bits.
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+template <class ISA>
+typename ISA::Mask ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ScanInGroup(
+        const InList &list, size_t pos, WordUnit input_mask, size_t begin,
+        typename ISA::Mask m_prefix, WordUnit &scalar_bits) const{
+    typedef typename ISA::Mask Mask;
+    if(1 == kNumBytesPerCode){
+        return m_prefix;
+    }
+
+    const size_t end = list.run_end[0][begin];
+    Mask m_result = ISA::MaskZero();
+    //m_equal[i]: lanes matching byte slices 0..i of the current code
+    Mask m_equal[4];
+    m_equal[0] = m_prefix;
+    size_t v = begin;
+    while(v < end){
+        size_t byte_id = (v == begin) ? 1 : list.diverge[v];
+        for(; byte_id < kNumBytesPerCode; byte_id++){
+            m_equal[byte_id] = ISA::CmpEq(m_equal[byte_id-1], ISA::Load(data_[byte_id]+pos),
+                                    ISA::Set1(list.bytes[byte_id][v]));
+            WordUnit lanes = ISA::ToBits(m_equal[byte_id]) & input_mask;
+            if(0 == lanes){
+                break;
+            }
+            if(byte_id + 1 < kNumBytesPerCode
+                    && static_cast<size_t>(__builtin_popcountll(lanes)) <= kInListMaxScalarLanes){
+                auto first = list.codes.begin() + v;
+                auto last = list.codes.begin() + list.run_end[byte_id][v];
+                while(0 != lanes){
+                    size_t lane = __builtin_ctzll(lanes);
+                    lanes &= lanes - 1;
+                    if(pos + lane < num_tuples_ && std::binary_search(first, last,
+                                GetTuple(pos + lane))){
+                        scalar_bits |= (1ULL << lane);
+                    }
+                }
+                break;
+            }
+        }
+        if(kNumBytesPerCode == byte_id){
+            m_result = ISA::Or(m_result, m_equal[kNumBytesPerCode-1]);
+            v++;
+        }
+        else{
+            //skip the codes sharing the prefix that was settled
+            v = list.run_end[byte_id][v];
+        }
+    }
+    return m_result;
+}
+
+
+//Scan Kernel
+//The last byte slice does not need mask_equal for some comparisons
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+template <class ISA, Comparator CMP, size_t BYTE_ID>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ScanKernel
+                                                (const typename ISA::Vec &byteslice1,
+                                                 const typename ISA::Vec &byteslice2,
+                                                 typename ISA::Mask &mask_less,
+                                                 typename ISA::Mask &mask_greater,
+                                                 typename ISA::Mask &mask_equal) const {
+
+    //internal ByteSlice --- not last BS                                                        
+    if(BYTE_ID < kNumBytesPerCode - 1){ 
+        switch(CMP){
+            case Comparator::kEqual:
+            case Comparator::kInequal:
+                mask_equal = ISA::CmpEq(mask_equal, byteslice1, byteslice2);
+                break;
+            case Comparator::kLess:
+            case Comparator::kLessEqual:
+                mask_less = ISA::Or(mask_less, ISA::CmpLt(mask_equal, byteslice1, byteslice2));
+                mask_equal = ISA::CmpEq(mask_equal, byteslice1, byteslice2);
+                break;
+            case Comparator::kGreater:
+            case Comparator::kGreaterEqual:
+                mask_greater = ISA::Or(mask_greater, ISA::CmpGt(mask_equal, byteslice1, byteslice2));
+                mask_equal = ISA::CmpEq(mask_equal, byteslice1, byteslice2);
+                break;
+        }
+    }
+    //last BS: no need to compute mask_equal for some comparisons
+    else if(BYTE_ID == kNumBytesPerCode - 1){   
+        switch(CMP){
+            case Comparator::kEqual:
+            case Comparator::kInequal:
+                mask_equal = ISA::CmpEq(mask_equal, byteslice1, byteslice2);
+                break;
+            case Comparator::kLessEqual:
+                mask_less = ISA::Or(mask_less, ISA::CmpLt(mask_equal, byteslice1, byteslice2));
+                mask_equal = ISA::CmpEq(mask_equal, byteslice1, byteslice2);
+                break;
+            case Comparator::kLess:
+                mask_less = ISA::Or(mask_less, ISA::CmpLt(mask_equal, byteslice1, byteslice2));
+                break;
+            case Comparator::kGreaterEqual:
+                mask_greater = ISA::Or(mask_greater, ISA::CmpGt(mask_equal, byteslice1, byteslice2));
+                mask_equal = ISA::CmpEq(mask_equal, byteslice1, byteslice2);
+                break;
+            case Comparator::kGreater:
+                mask_greater = ISA::Or(mask_greater, ISA::CmpGt(mask_equal, byteslice1, byteslice2));
+                break;
+        }
+    }
+    //otherwise, do nothing
+
+}
+
+
+//Aggregation
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+WordUnit ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::Sum(const BitVectorBlock* filter) const{
+    assert(nullptr == filter || filter->num() == num_tuples_);
+    switch(GetSimdLevel()){
+        case SimdLevel::kAVX512:
+            return SumAvx512(filter);
+        case SimdLevel::kAVX2:
+            return SumAvx2(filter);
+        case SimdLevel::kSSE42:
+            return SumSse42(filter);
+    }
+    return 0;
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+WordUnit ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::SumSse42(const BitVectorBlock* filter) const{
+    return SumLoop<Sse42Isa>(filter);
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+WordUnit ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::SumAvx2(const BitVectorBlock* filter) const{
+    return SumLoop<Avx2Isa>(filter);
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+WordUnit ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::SumAvx512(const BitVectorBlock* filter) const{
+    return SumLoop<Avx512Isa>(filter);
+}
+
+//Sum of values = sum over slices of (sum of bytes in slice) * 256^(weight),
+//shifted back by the padding bits (which are zero in storage).
+//Byte sums use SAD into 64-bit lanes, which cannot overflow within a block.
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+template <class ISA>
+WordUnit ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::SumLoop(const BitVectorBlock* filter) const{
+    typename ISA::WordVec acc[kNumBytesPerCode];
+    for(size_t byte_id = 0; byte_id < kNumBytesPerCode; byte_id++){
+        acc[byte_id] = ISA::ZeroWords();
+    }
+
+    const size_t num_words = CEIL(num_tuples_, kNumWordBits);
+    for(size_t w = 0; w < num_words; w++){
+        WordUnit word = (nullptr == filter) ? -1ULL : filter->GetWordUnit(w);
+        if(w == num_words - 1 && 0 != num_tuples_ % kNumWordBits){
+            word &= (1ULL << (num_tuples_ % kNumWordBits)) - 1;
+        }
+        if(0 == word){
+            continue;
+        }
+        const size_t offset = w * kNumWordBits;
+        for(size_t i = 0; i < kNumWordBits; i += ISA::kNumLanes){
+            const typename ISA::Mask k = ISA::FromBits(word >> i);
+            for(size_t byte_id = 0; byte_id < kNumBytesPerCode; byte_id++){
+                acc[byte_id] = ISA::AddWords(acc[byte_id],
+                        ISA::SumBytes(k, ISA::Load(data_[byte_id] + offset + i)));
+            }
+        }
+    }
+
+    WordUnit sum = 0;
+    for(size_t byte_id = 0; byte_id < kNumBytesPerCode; byte_id++){
+        sum += ISA::ReduceWords(acc[byte_id]) << 8*(kNumBytesPerCode - 1 - byte_id);
+    }
+    if(Direction::kRight == PDIRECTION){
+        sum >>= kNumPaddingBits;
+    }
+    return sum;
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::LoadCandidates(const BitVectorBlock* filter,
+                                                        std::vector<WordUnit> &words) const{
+    assert(nullptr == filter || filter->num() == num_tuples_);
+    const size_t num_words = CEIL(num_tuples_, kNumWordBits);
+    words.resize(num_words);
+    for(size_t w = 0; w < num_words; w++){
+        words[w] = (nullptr == filter) ? -1ULL : filter->GetWordUnit(w);
+    }
+    if(0 != num_tuples_ % kNumWordBits){
+        words[num_words - 1] &= (1ULL << (num_tuples_ % kNumWordBits)) - 1;
+    }
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+bool ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::Min(const BitVectorBlock* filter,
+                                                        WordUnit &result) const{
+    switch(GetSimdLevel()){
+        case SimdLevel::kAVX512:
+            return ExtremeAvx512<false>(filter, result);
+        case SimdLevel::kAVX2:
+            return ExtremeAvx2<false>(filter, result);
+        case SimdLevel::kSSE42:
+            return ExtremeSse42<false>(filter, result);
+    }
+    return false;
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+bool ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::Max(const BitVectorBlock* filter,
+                                                        WordUnit &result) const{
+    switch(GetSimdLevel()){
+        case SimdLevel::kAVX512:
+            return ExtremeAvx512<true>(filter, result);
+        case SimdLevel::kAVX2:
+            return ExtremeAvx2<true>(filter, result);
+        case SimdLevel::kSSE42:
+            return ExtremeSse42<true>(filter, result);
+    }
+    return false;
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+template <bool MAX>
+bool ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ExtremeSse42(const BitVectorBlock* filter,
+                                                        WordUnit &result) const{
+    return ExtremeLoop<Sse42Isa, MAX>(filter, result);
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+template <bool MAX>
+bool ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ExtremeAvx2(const BitVectorBlock* filter,
+                                                        WordUnit &result) const{
+    return ExtremeLoop<Avx2Isa, MAX>(filter, result);
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+template <bool MAX>
+bool ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ExtremeAvx512(const BitVectorBlock* filter,
+                                                        WordUnit &result) const{
+    return ExtremeLoop<Avx512Isa, MAX>(filter, result);
+}
+
+//Pass j finds the extreme byte of slice j among the candidates. Pass j+1
+//first narrows the candidates to the lanes holding that byte in slice j,
+//so words without candidates left are never loaded again.
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+template <class ISA, bool MAX>
+bool ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::ExtremeLoop(const BitVectorBlock* filter,
+                                                        WordUnit &result) const{
+    typedef typename ISA::Vec Vec;
+    typedef typename ISA::Mask Mask;
+
+    std::vector<WordUnit> candidates;
+    LoadCandidates(filter, candidates);
+    if(std::all_of(candidates.begin(), candidates.end(),
+                [](WordUnit word){ return 0 == word; })){
+        return false;
+    }
+
+    //non-candidate lanes never win
+    const ByteUnit neutral_byte = MAX ? FLIP(static_cast<ByteUnit>(0)) :
+                                        FLIP(static_cast<ByteUnit>(0xFF));
+    const Vec neutral = ISA::Set1(neutral_byte);
+    WordUnit value = 0;
+    ByteUnit extreme = 0;   //FLIPPED
+    for(size_t byte_id = 0; byte_id < kNumBytesPerCode; byte_id++){
+        const Vec prev_extreme = ISA::Set1(extreme);
+        Vec best = neutral;
+        for(size_t w = 0; w < candidates.size(); w++){
+            const WordUnit word = candidates[w];
+            if(0 == word){
+                continue;
+            }
+            const size_t offset = w * kNumWordBits;
+            WordUnit narrowed = 0;
+            for(size_t i = 0; i < kNumWordBits; i += ISA::kNumLanes){
+                Mask k = ISA::FromBits(word >> i);
+                if(byte_id > 0){
+                    k = ISA::CmpEq(k, ISA::Load(data_[byte_id - 1] + offset + i), prev_extreme);
+                    narrowed |= ISA::ToBits(k) << i;
+                }
+                const Vec x = ISA::Select(k, ISA::Load(data_[byte_id] + offset + i), neutral);
+                best = MAX ? ISA::MaxBytes(best, x) : ISA::MinBytes(best, x);
+            }
+            if(byte_id > 0){
+                candidates[w] = narrowed;
+            }
+        }
+
+        ByteUnit lanes[ISA::kNumLanes];
+        ISA::Store(lanes, best);
+        extreme = neutral_byte;
+        for(size_t l = 0; l < ISA::kNumLanes; l++){
+            const int8_t x = static_cast<int8_t>(lanes[l]);
+            if(MAX ? x > static_cast<int8_t>(extreme) : x < static_cast<int8_t>(extreme)){
+                extreme = lanes[l];
+            }
+        }
+        value = (value << 8) | FLIP(extreme);
+    }
+
+    if(Direction::kRight == PDIRECTION){
+        value >>= kNumPaddingBits;
+    }
+    result = value;
+    return true;
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::TopK(const BitVectorBlock* filter,
+                                    size_t k, bool largest, std::vector<WordUnit> &result) const{
+    switch(GetSimdLevel()){
+        case SimdLevel::kAVX512:
+            return largest ? TopKAvx512<true>(filter, k, result) :
+                                TopKAvx512<false>(filter, k, result);
+        case SimdLevel::kAVX2:
+            return largest ? TopKAvx2<true>(filter, k, result) :
+                                TopKAvx2<false>(filter, k, result);
+        case SimdLevel::kSSE42:
+            return largest ? TopKSse42<true>(filter, k, result) :
+                                TopKSse42<false>(filter, k, result);
+    }
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+template <bool LARGEST>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::TopKSse42(const BitVectorBlock* filter,
+                                    size_t k, std::vector<WordUnit> &result) const{
+    TopKLoop<Sse42Isa, LARGEST>(filter, k, result);
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+template <bool LARGEST>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::TopKAvx2(const BitVectorBlock* filter,
+                                    size_t k, std::vector<WordUnit> &result) const{
+    TopKLoop<Avx2Isa, LARGEST>(filter, k, result);
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+template <bool LARGEST>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::TopKAvx512(const BitVectorBlock* filter,
+                                    size_t k, std::vector<WordUnit> &result) const{
+    TopKLoop<Avx512Isa, LARGEST>(filter, k, result);
+}
+
+//Per slice, a histogram of the candidates' bytes locates the byte b of the
+//k-th value. Candidates before b are in the result for sure, those at b
+//remain candidates for the next slice, the rest drop out. After the last
+//slice the remaining candidates are ties, any of them will do.
+//Only the (at most k) selected tuples are materialized.
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+template <class ISA, bool LARGEST>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::TopKLoop(const BitVectorBlock* filter,
+                                    size_t k, std::vector<WordUnit> &result) const{
+    typedef typename ISA::Vec Vec;
+    typedef typename ISA::Mask Mask;
+
+    result.clear();
+    if(0 == k){
+        return;
+    }
+    std::vector<WordUnit> candidates;
+    LoadCandidates(filter, candidates);
+    std::vector<WordUnit> selected(candidates.size(), 0);
+
+    size_t remaining = k;
+    for(size_t byte_id = 0; byte_id < kNumBytesPerCode; byte_id++){
+        const ByteUnit* slice = data_[byte_id];
+        size_t histogram[256] = {0};
+        for(size_t w = 0; w < candidates.size(); w++){
+            for(WordUnit word = candidates[w]; 0 != word; word &= word - 1){
+                histogram[FLIP(slice[w * kNumWordBits + __builtin_ctzll(word)])]++;
+            }
+        }
+
+        size_t num_before = 0;
+        size_t bucket = 0;
+        bool found = false;
+        for(size_t b = 0; b < 256; b++){
+            bucket = LARGEST ? 255 - b : b;
+            if(num_before + histogram[bucket] >= remaining){
+                found = true;
+                break;
+            }
+            num_before += histogram[bucket];
+        }
+        if(!found){
+            //fewer candidates than wanted: take them all
+            for(size_t w = 0; w < candidates.size(); w++){
+                selected[w] |= candidates[w];
+            }
+            remaining = 0;
+            break;
+        }
+
+        const Vec bound = ISA::Set1(FLIP(static_cast<ByteUnit>(bucket)));
+        for(size_t w = 0; w < candidates.size(); w++){
+            const WordUnit word = candidates[w];
+            if(0 == word){
+                continue;
+            }
+            const size_t offset = w * kNumWordBits;
+            WordUnit before = 0, equal = 0;
+            for(size_t i = 0; i < kNumWordBits; i += ISA::kNumLanes){
+                const Mask m = ISA::FromBits(word >> i);
+                const Vec x = ISA::Load(slice + offset + i);
+                before |= ISA::ToBits(LARGEST ? ISA::CmpGt(m, x, bound) :
+                                                ISA::CmpLt(m, x, bound)) << i;
+                equal |= ISA::ToBits(ISA::CmpEq(m, x, bound)) << i;
+            }
+            selected[w] |= before;
+            candidates[w] = equal;
+        }
+        remaining -= num_before;
+    }
+
+    for(size_t w = 0; w < candidates.size() && remaining > 0; w++){
+        for(WordUnit word = candidates[w]; 0 != word && remaining > 0; word &= word - 1){
+            selected[w] |= word & (~word + 1);
+            remaining--;
+        }
+    }
+
+    for(size_t w = 0; w < selected.size(); w++){
+        for(WordUnit word = selected[w]; 0 != word; word &= word - 1){
+            result.push_back(GetTuple(w * kNumWordBits + __builtin_ctzll(word)));
+        }
+    }
+    if(LARGEST){
+        std::sort(result.begin(), result.end(), std::greater<WordUnit>());
+    }
+    else{
+        std::sort(result.begin(), result.end());
+    }
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::RadixHistogram(const BitVectorBlock* filter,
+                            size_t byte_id, WordUnit prefix, size_t* histogram) const{
+    assert(byte_id < kNumBytesPerCode);
+    switch(GetSimdLevel()){
+        case SimdLevel::kAVX512:
+            return RadixHistogramAvx512(filter, byte_id, prefix, histogram);
+        case SimdLevel::kAVX2:
+            return RadixHistogramAvx2(filter, byte_id, prefix, histogram);
+        case SimdLevel::kSSE42:
+            return RadixHistogramSse42(filter, byte_id, prefix, histogram);
+    }
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::RadixHistogramSse42(const BitVectorBlock* filter,
+                            size_t byte_id, WordUnit prefix, size_t* histogram) const{
+    RadixHistogramLoop<Sse42Isa>(filter, byte_id, prefix, histogram);
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::RadixHistogramAvx2(const BitVectorBlock* filter,
+                            size_t byte_id, WordUnit prefix, size_t* histogram) const{
+    RadixHistogramLoop<Avx2Isa>(filter, byte_id, prefix, histogram);
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::RadixHistogramAvx512(const BitVectorBlock* filter,
+                            size_t byte_id, WordUnit prefix, size_t* histogram) const{
+    RadixHistogramLoop<Avx512Isa>(filter, byte_id, prefix, histogram);
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+template <class ISA>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::RadixHistogramLoop(const BitVectorBlock* filter,
+                            size_t byte_id, WordUnit prefix, size_t* histogram) const{
+    std::vector<WordUnit> candidates;
+    LoadCandidates(filter, candidates);
+
+    if(Direction::kLeft == PDIRECTION && 0 != kNumPaddingBits){
+        //slices do not hold the digits: go through the values
+        const size_t digit_shift = 8 * (kNumBytesPerCode - 1 - byte_id);
+        for(size_t w = 0; w < candidates.size(); w++){
+            for(WordUnit word = candidates[w]; 0 != word; word &= word - 1){
+                const WordUnit code = GetTuple(w * kNumWordBits + __builtin_ctzll(word))
+                                        << kNumPaddingBits;
+                if(((code >> digit_shift) >> 8) == prefix){
+                    histogram[(code >> digit_shift) & 0xFF]++;
+                }
+            }
+        }
+        return;
+    }
+
+    typename ISA::Vec prefix_bytes[4];
+    for(size_t j = 0; j < byte_id; j++){
+        prefix_bytes[j] = ISA::Set1(FLIP(static_cast<ByteUnit>(prefix >> 8*(byte_id - 1 - j))));
+    }
+    const ByteUnit* slice = data_[byte_id];
+    for(size_t w = 0; w < candidates.size(); w++){
+        WordUnit word = candidates[w];
+        const size_t offset = w * kNumWordBits;
+        //lower prefix slices are only read while some lane still matches
+        for(size_t j = 0; j < byte_id && 0 != word; j++){
+            WordUnit matched = 0;
+            for(size_t i = 0; i < kNumWordBits; i += ISA::kNumLanes){
+                matched |= ISA::ToBits(ISA::CmpEq(ISA::FromBits(word >> i),
+                            ISA::Load(data_[j] + offset + i), prefix_bytes[j])) << i;
+            }
+            word = matched;
+        }
+        for(; 0 != word; word &= word - 1){
+            histogram[FLIP(slice[offset + __builtin_ctzll(word)])]++;
+        }
+    }
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::BulkLoadArray(const WordUnit* codes,
+                                                        size_t num, size_t start_pos){
+    assert(start_pos + num <= num_tuples_);
+    assert(!mapped_);
+    switch(GetSimdLevel()){
+        case SimdLevel::kAVX512:
+            return BulkLoadAvx512(codes, num, start_pos);
+        case SimdLevel::kAVX2:
+            return BulkLoadAvx2(codes, num, start_pos);
+        case SimdLevel::kSSE42:
+            return BulkLoadSse42(codes, num, start_pos);
+    }
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::BulkLoadSse42(const WordUnit* codes,
+                                                        size_t num, size_t start_pos){
+    BulkLoadLoop<Sse42Isa>(codes, num, start_pos);
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::BulkLoadAvx2(const WordUnit* codes,
+                                                        size_t num, size_t start_pos){
+    BulkLoadLoop<Avx2Isa>(codes, num, start_pos);
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::BulkLoadAvx512(const WordUnit* codes,
+                                                        size_t num, size_t start_pos){
+    BulkLoadLoop<Avx512Isa>(codes, num, start_pos);
+}
+
+//Full batches are split into byte slices in registers and stored as whole
+//vectors, instead of kNumBytesPerCode scattered byte stores per code.
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+template <class ISA>
+void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::BulkLoadLoop(const WordUnit* codes,
+                                                        size_t num, size_t start_pos){
+    const size_t shift = (Direction::kRight == PDIRECTION) ? kNumPaddingBits : 0;
+    size_t i = 0;
+    for(; i + ISA::kNumLanes <= num; i += ISA::kNumLanes){
+        typename ISA::Vec bytes[4];
+        ISA::SplitBytes(codes + i, shift, bytes);
+        for(size_t byte_id = 0; byte_id < kNumBytesPerCode; byte_id++){
+            ISA::Store(data_[byte_id] + start_pos + i, bytes[kNumBytesPerCode - 1 - byte_id]);
+        }
+    }
+    for(; i < num; i++){
+        StoreTuple(start_pos+i, codes[i]);
+    }
+
+    //compiled (and auto-vectorized) once per instruction set
+    WordUnit min_value = kStoredMask;
+    WordUnit max_value = 0;
+    for(size_t pos = 0; pos < num; pos++){
+        WordUnit code = codes[pos] & kStoredMask;
+        min_value = std::min(min_value, code);
+        max_value = std::max(max_value, code);
+    }
+    if(0 == start_pos && num == num_tuples_){
+        SetZoneMap(min_value, max_value);
+    }
+    else{
+        ExtendZoneMap(min_value, max_value);
+    }
+    if(nullptr != imprints_){
+        ComputeImprints(start_pos, start_pos + num);
     }
 }
 
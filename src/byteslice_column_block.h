@@ -9,8 +9,11 @@
 #ifndef BYTESLICE_COLUMN_BLOCK_H
 #define BYTESLICE_COLUMN_BLOCK_H
 
+#include    <vector>
+
 #include "../src/avx-utility.h"
 #include "../src/column_block.h"
+#include "../src/simd_isa.h"
 
 namespace byteslice{
 
@@ -26,7 +29,8 @@ static constexpr size_t kMemSizePerByteSlice =
 template <size_t BIT_WIDTH, Direction PDIRECTION = Direction::kRight>
 class ByteSliceColumnBlock: public ColumnBlock{
 public:
-    ByteSliceColumnBlock(size_t num=kNumTuplesPerBlock);
+    //data on a NUMA node (see numa_placement.h)
+    ByteSliceColumnBlock(size_t num=kNumTuplesPerBlock, size_t node=kAnyNode);
     virtual ~ByteSliceColumnBlock();
 
     WordUnit GetTuple(size_t pos) const override;
@@ -36,21 +40,70 @@ public:
             Bitwise bit_opt = Bitwise::kSet) const override;
     void Scan(Comparator comparator, const ColumnBlock* other_block,
             BitVectorBlock* bvblock, Bitwise bit_opt = Bitwise::kSet) const override;
+    void ScanBetween(WordUnit lower, WordUnit upper, BitVectorBlock* bvblock,
+            Bitwise bit_opt = Bitwise::kSet) const override;
+    void ScanIn(const WordUnit* values, size_t num_values, BitVectorBlock* bvblock,
+            Bitwise bit_opt = Bitwise::kSet) const override;
+    void FilterWords(Comparator comparator, WordUnit literal,
+            WordUnit* words, size_t begin_word, size_t num_words,
+            EarlyStopState* early_stop = nullptr) const override;
+
+    WordUnit Sum(const BitVectorBlock* filter) const override;
+    bool Min(const BitVectorBlock* filter, WordUnit &result) const override;
+    bool Max(const BitVectorBlock* filter, WordUnit &result) const override;
+    void TopK(const BitVectorBlock* filter, size_t k, bool largest,
+            std::vector<WordUnit> &result) const override;
+    void RadixHistogram(const BitVectorBlock* filter, size_t byte_id,
+            WordUnit prefix, size_t* histogram) const override;
 
     void BulkLoadArray(const WordUnit* codes, size_t num, size_t start_pos = 0) override;
 
-    void SerToFile(SequentialWriteBinaryFile &file) const override;
+    void SerToFile(SequentialWriteBinaryFile &file,
+            Compression compression = Compression::kNone) const override;
     void DeserFromFile(const SequentialReadBinaryFile &file) override;
+    bool MapFromBuffer(const char* buffer, size_t size, size_t &offset) override;
+    ColumnBlock* Clone(size_t node) const override;
     bool Resize(size_t size) override;
 
     Direction GetPadDirection();
+
+    /**
+     * Imprints: for every 64 tuples, one bit per bucket of the leading byte
+     * (64 buckets of 4 byte values) that occurs among them. Literal scans
+     * skip or accept such strides without reading them. Once built, the
+     * imprints are kept up to date and serialized with the block.
+     */
+    void BuildImprints() override;
+    bool HasImprints() const;
+    WordUnit GetImprint(size_t stride_id) const;
     
 private:
+    //IN-list prepared for scan: distinct codes in order, split into byte slices
+    struct InList{
+        std::vector<WordUnit> codes;        //sorted, distinct, within kCodeMask
+        std::vector<ByteUnit> bytes[4];     //bytes[i][v]: FLIPPED byte slice i of codes[v]
+        //run_end[i][v]: end of the codes sharing byte slices 0..i with codes[v]
+        std::vector<size_t> run_end[4];
+        //diverge[v]: first byte slice in which codes[v] differs from codes[v-1]
+        std::vector<uint8_t> diverge;
+        size_t group_begin[256];            //first code of each byte slice 0 in the list
+        size_t num_groups;                  //codes sharing byte slice 0
+        bool use_lut;                       //too many groups: filter slice 0 by table
+        ByteUnit lut[2][16];                //membership of byte slice 0 (see simd_isa.h)
+    };
+    //Groups of slice-0 prefixes compared one by one; more go through the table
+    static constexpr size_t kInListMaxGroups = 8;
+    //Lanes left in a prefix that are looked up one by one
+    static constexpr size_t kInListMaxScalarLanes = 2;
+
     //Scan Helper: literal
+    //words[w] is bit vector word (begin_word + w) of this block
     template <Comparator CMP>
-    void ScanHelper1(WordUnit literal, BitVectorBlock* bvblock, Bitwise bit_opt) const;
+    void ScanHelper1(WordUnit literal, WordUnit* words, size_t begin_word,
+                            size_t num_words, Bitwise bit_opt, EarlyStopState &early_stop) const;
     template <Comparator CMP, Bitwise OPT>
-    void ScanHelper2(WordUnit literal, BitVectorBlock* bvblock) const;
+    void ScanHelper2(WordUnit literal, WordUnit* words, size_t begin_word,
+                            size_t num_words, EarlyStopState &early_stop) const;
 
     //Scan Helper: other block
     template <Comparator CMP>
@@ -61,20 +114,162 @@ private:
                             BitVectorBlock* bvblock) const;
 
 
-    //Scan Kernel
-    template <Comparator CMP>
-    inline void ScanKernel(const AvxUnit &byteslice1, const AvxUnit &byteslice2,
-            AvxUnit &mask_less, AvxUnit &mask_greater, AvxUnit &mask_equal) const;
-    template <Comparator CMP, size_t BYTE_ID>
-    inline void ScanKernel2(const AvxUnit &byteslice1, const AvxUnit &byteslice2,
-            AvxUnit &mask_less, AvxUnit &mask_greater, AvxUnit &mask_equal) const;
+    //Scan Helper: range
+    template <Bitwise OPT>
+    void ScanBetweenHelper(WordUnit lower, WordUnit upper, BitVectorBlock* bvblock) const;
+
+    //Scan Helper: IN-list
+    template <Bitwise OPT>
+    void ScanInHelper(const InList &list, BitVectorBlock* bvblock) const;
+
+    //Scan entries per instruction set, selected at runtime
+    template <Comparator CMP, Bitwise OPT>
+    TARGET_SSE42 void ScanSse42(WordUnit literal, WordUnit* words, size_t begin_word,
+                            size_t num_words, EarlyStopState &early_stop) const;
+    template <Comparator CMP, Bitwise OPT>
+    TARGET_AVX2 void ScanAvx2(WordUnit literal, WordUnit* words, size_t begin_word,
+                            size_t num_words, EarlyStopState &early_stop) const;
+    template <Comparator CMP, Bitwise OPT>
+    TARGET_AVX512 void ScanAvx512(WordUnit literal, WordUnit* words, size_t begin_word,
+                            size_t num_words, EarlyStopState &early_stop) const;
+    template <Comparator CMP, Bitwise OPT>
+    TARGET_SSE42 void ScanSse42(const ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>* other_block,
+                            BitVectorBlock* bvblock) const;
+    template <Comparator CMP, Bitwise OPT>
+    TARGET_AVX2 void ScanAvx2(const ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>* other_block,
+                            BitVectorBlock* bvblock) const;
+    template <Comparator CMP, Bitwise OPT>
+    TARGET_AVX512 void ScanAvx512(const ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>* other_block,
+                            BitVectorBlock* bvblock) const;
+
+    template <Bitwise OPT>
+    TARGET_SSE42 void ScanBetweenSse42(WordUnit lower, WordUnit upper,
+                            BitVectorBlock* bvblock) const;
+    template <Bitwise OPT>
+    TARGET_AVX2 void ScanBetweenAvx2(WordUnit lower, WordUnit upper,
+                            BitVectorBlock* bvblock) const;
+    template <Bitwise OPT>
+    TARGET_AVX512 void ScanBetweenAvx512(WordUnit lower, WordUnit upper,
+                            BitVectorBlock* bvblock) const;
+
+    template <Bitwise OPT>
+    TARGET_SSE42 void ScanInSse42(const InList &list, BitVectorBlock* bvblock) const;
+    template <Bitwise OPT>
+    TARGET_AVX2 void ScanInAvx2(const InList &list, BitVectorBlock* bvblock) const;
+    template <Bitwise OPT>
+    TARGET_AVX512 void ScanInAvx512(const InList &list, BitVectorBlock* bvblock) const;
+
+    //Scan loops, written once for all instruction sets (see simd_isa.h)
+    template <class ISA, Comparator CMP, Bitwise OPT>
+    FORCE_INLINE void ScanLoop(WordUnit literal, WordUnit* words, size_t begin_word,
+                            size_t num_words, EarlyStopState &early_stop) const;
+    template <class ISA, Comparator CMP, Bitwise OPT>
+    FORCE_INLINE void ScanLoop(const ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>* other_block,
+                            BitVectorBlock* bvblock) const;
+
+    template <class ISA, Comparator CMP, Bitwise OPT, bool EARLY_STOP>
+    FORCE_INLINE WordUnit ScanWord(const typename ISA::Vec* mask_literal, size_t offset,
+                            WordUnit word, size_t &num_checks, size_t &num_stops) const;
+    template <class ISA, Bitwise OPT, bool EARLY_STOP>
+    FORCE_INLINE bool KeepScanning(const typename ISA::Mask &m_equal, WordUnit input_mask,
+                            size_t &num_checks, size_t &num_stops) const;
+
+    template <class ISA, Bitwise OPT>
+    FORCE_INLINE void ScanBetweenLoop(WordUnit lower, WordUnit upper,
+                            BitVectorBlock* bvblock) const;
+
+    template <class ISA, Bitwise OPT>
+    FORCE_INLINE void ScanInLoop(const InList &list, BitVectorBlock* bvblock) const;
+    template <class ISA>
+    FORCE_INLINE typename ISA::Mask ScanInGroup(const InList &list, size_t pos,
+            WordUnit input_mask, size_t begin, typename ISA::Mask m_prefix,
+            WordUnit &scalar_bits) const;
+
+    //Scan Kernel: compare one byte slice
+    template <class ISA, Comparator CMP, size_t BYTE_ID>
+    FORCE_INLINE void ScanKernel(const typename ISA::Vec &byteslice1,
+            const typename ISA::Vec &byteslice2,
+            typename ISA::Mask &mask_less, typename ISA::Mask &mask_greater,
+            typename ISA::Mask &mask_equal) const;
+
+    //Scan Kernel for range: compare one byte slice against both bounds
+    template <class ISA, size_t BYTE_ID>
+    FORCE_INLINE void ScanBetweenKernel(const typename ISA::Vec &byteslice,
+            const typename ISA::Vec &lower, const typename ISA::Vec &upper,
+            typename ISA::Mask &mask_greater_lower, typename ISA::Mask &mask_equal_lower,
+            typename ISA::Mask &mask_less_upper, typename ISA::Mask &mask_equal_upper) const;
+
+    //SetTuple without maintaining the zone map and imprints
+    void StoreTuple(size_t pos, WordUnit value);
+    //recompute imprints of the strides covering tuples [begin, end)
+    void ComputeImprints(size_t begin, size_t end);
+
+    //Aggregation: every byte slice is summed on its own, then weighted
+    TARGET_SSE42 WordUnit SumSse42(const BitVectorBlock* filter) const;
+    TARGET_AVX2 WordUnit SumAvx2(const BitVectorBlock* filter) const;
+    TARGET_AVX512 WordUnit SumAvx512(const BitVectorBlock* filter) const;
+    template <class ISA>
+    FORCE_INLINE WordUnit SumLoop(const BitVectorBlock* filter) const;
+
+    //Extremes: settled one byte slice at a time over a shrinking set of
+    //candidate lanes; lower slices are only read where candidates remain
+    template <bool MAX>
+    TARGET_SSE42 bool ExtremeSse42(const BitVectorBlock* filter, WordUnit &result) const;
+    template <bool MAX>
+    TARGET_AVX2 bool ExtremeAvx2(const BitVectorBlock* filter, WordUnit &result) const;
+    template <bool MAX>
+    TARGET_AVX512 bool ExtremeAvx512(const BitVectorBlock* filter, WordUnit &result) const;
+    template <class ISA, bool MAX>
+    FORCE_INLINE bool ExtremeLoop(const BitVectorBlock* filter, WordUnit &result) const;
+
+    //Top-K: radix selection over the byte slices, same narrowing as above
+    template <bool LARGEST>
+    TARGET_SSE42 void TopKSse42(const BitVectorBlock* filter, size_t k,
+                            std::vector<WordUnit> &result) const;
+    template <bool LARGEST>
+    TARGET_AVX2 void TopKAvx2(const BitVectorBlock* filter, size_t k,
+                            std::vector<WordUnit> &result) const;
+    template <bool LARGEST>
+    TARGET_AVX512 void TopKAvx512(const BitVectorBlock* filter, size_t k,
+                            std::vector<WordUnit> &result) const;
+    template <class ISA, bool LARGEST>
+    FORCE_INLINE void TopKLoop(const BitVectorBlock* filter, size_t k,
+                            std::vector<WordUnit> &result) const;
+
+    //Radix histogram: digits are the byte slices under right padding;
+    //the prefix slices are matched word by word before the digit is counted
+    TARGET_SSE42 void RadixHistogramSse42(const BitVectorBlock* filter, size_t byte_id,
+                            WordUnit prefix, size_t* histogram) const;
+    TARGET_AVX2 void RadixHistogramAvx2(const BitVectorBlock* filter, size_t byte_id,
+                            WordUnit prefix, size_t* histogram) const;
+    TARGET_AVX512 void RadixHistogramAvx512(const BitVectorBlock* filter, size_t byte_id,
+                            WordUnit prefix, size_t* histogram) const;
+    template <class ISA>
+    FORCE_INLINE void RadixHistogramLoop(const BitVectorBlock* filter, size_t byte_id,
+                            WordUnit prefix, size_t* histogram) const;
+
+    //words of filter (all ones if NULL) over this block, tail bits cleared
+    void LoadCandidates(const BitVectorBlock* filter, std::vector<WordUnit> &words) const;
+
+    //Bulk load entries per instruction set
+    TARGET_SSE42 void BulkLoadSse42(const WordUnit* codes, size_t num, size_t start_pos);
+    TARGET_AVX2 void BulkLoadAvx2(const WordUnit* codes, size_t num, size_t start_pos);
+    TARGET_AVX512 void BulkLoadAvx512(const WordUnit* codes, size_t num, size_t start_pos);
+    //kNumLanes codes at a time are transposed into byte slices (see simd_isa.h)
+    template <class ISA>
+    FORCE_INLINE void BulkLoadLoop(const WordUnit* codes, size_t num, size_t start_pos);
 
     static constexpr size_t kNumBytesPerCode = CEIL(BIT_WIDTH, 8);
     static constexpr size_t kNumPaddingBits = kNumBytesPerCode * 8 - BIT_WIDTH;
     static constexpr Direction kPadDirection = PDIRECTION;
     static constexpr WordUnit kCodeMask = (1ULL << BIT_WIDTH) - 1;
+    //bits of a value that survive SetTuple
+    static constexpr WordUnit kStoredMask = (Direction::kRight == PDIRECTION) ?
+        kCodeMask : (1ULL << (8 * kNumBytesPerCode)) - 1;
 
     ByteUnit* data_[4];
+    WordUnit* imprints_ = nullptr;  //one word per stride of kNumWordBits tuples
+    static constexpr size_t kNumImprints = kNumTuplesPerBlock / kNumWordBits;
 
 
 };
@@ -114,6 +309,27 @@ inline WordUnit ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::GetTuple(size_t pos
 
 template <size_t BIT_WIDTH, Direction PDIRECTION>
 inline void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::SetTuple(size_t pos, WordUnit value){
+    assert(!mapped_);
+    StoreTuple(pos, value);
+    const WordUnit code = value & kStoredMask;
+    ExtendZoneMap(code, code);
+    if(nullptr != imprints_){
+        imprints_[pos / kNumWordBits] |= 1ULL << (FLIP(data_[0][pos]) >> 2);
+    }
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+inline bool ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::HasImprints() const{
+    return nullptr != imprints_;
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+inline WordUnit ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::GetImprint(size_t stride_id) const{
+    return imprints_[stride_id];
+}
+
+template <size_t BIT_WIDTH, Direction PDIRECTION>
+inline void ByteSliceColumnBlock<BIT_WIDTH, PDIRECTION>::StoreTuple(size_t pos, WordUnit value){
     switch(PDIRECTION){
         case Direction::kRight:
             value <<= kNumPaddingBits;
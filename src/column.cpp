@@ -9,12 +9,29 @@
 #include 	"column.h"
 
 #include    <algorithm>
+#include    <cerrno>
+#include    <condition_variable>
+#include    <cstring>
 #include    <fstream>
+#include    <functional>
 #include    <iostream>
+#include    <limits>
+#include    <memory>
+#include    <mutex>
+#include    <numeric>
+#include    <thread>
 #include    <omp.h>
+#include    <fcntl.h>
+#include    <sys/mman.h>
+#include    <sys/stat.h>
+#include    <unistd.h>
 
 #include 	"byteslice_column_block.h"
+#include 	"compressed_bitvector.h"
 #include 	"naive_column_block.h"
+#include 	"numa_placement.h"
+#include 	"position_list.h"
+#include 	"text_parser.h"
 
 namespace byteslice {
 
@@ -22,10 +39,12 @@ Column::Column(ColumnType type, size_t bit_width, size_t num) :
 		type_(type), bit_width_(bit_width), num_tuples_(num) {
 
 	for (size_t count = 0; count < num; count += kNumTuplesPerBlock) {
-		ColumnBlock* new_block = CreateNewBlock();
+		ColumnBlock* new_block = CreateNewBlock(GetBlockNode(blocks_.size()));
 		new_block->Resize(std::min(kNumTuplesPerBlock, num - count));
 		blocks_.push_back(new_block);
+		block_owners_.emplace_back(new_block);
 	}
+	Publish();
 }
 
 Column::~Column() {
@@ -33,16 +52,55 @@ Column::~Column() {
 }
 
 void Column::Destroy() {
-	while (!blocks_.empty()) {
-		delete blocks_.back();
-		blocks_.pop_back();
+	//blocks still in a snapshot go with it
+	blocks_.clear();
+	block_owners_.clear();
+	if (nullptr != mapping_) {
+		munmap(mapping_, mapping_size_);
+		mapping_ = nullptr;
+		mapping_size_ = 0;
 	}
+	num_tuples_ = 0;
+	DiscardUpdates();
+}
+
+//Pending updates of a block, NULL if none
+static const BlockDelta* GetBlockDelta(const DeltaTable* deltas, size_t block_id) {
+	if (nullptr == deltas || block_id >= deltas->size()) {
+		return nullptr;
+	}
+	return (*deltas)[block_id].get();
+}
+
+//Pending update of a tuple, if any
+static bool FindUpdate(const DeltaTable* deltas, size_t block_id, size_t pos_in_block,
+		WordUnit &value) {
+	const BlockDelta* block_delta = GetBlockDelta(deltas, block_id);
+	if (nullptr == block_delta) {
+		return false;
+	}
+	const BlockDelta &delta = *block_delta;
+	const auto it = std::lower_bound(delta.begin(), delta.end(),
+			std::make_pair(pos_in_block, WordUnit(0)));
+	if (delta.end() == it || it->first != pos_in_block) {
+		return false;
+	}
+	value = it->second;
+	return true;
 }
 
 WordUnit Column::GetTuple(size_t id) const {
 	assert(id < num_tuples_);
 	size_t block_id = id / kNumTuplesPerBlock;
 	size_t pos_in_block = id % kNumTuplesPerBlock;
+	if (0 < num_deltas_.load(std::memory_order_acquire)) {
+		const std::shared_ptr<const ColumnVersion> version = std::atomic_load(&version_);
+		WordUnit value;
+		if (FindUpdate(version->deltas.get(), block_id, pos_in_block, value)) {
+			return value;
+		}
+		return version->blocks[block_id]->GetTuple(pos_in_block);
+	}
 	return blocks_[block_id]->GetTuple(pos_in_block);
 }
 
@@ -50,25 +108,82 @@ void Column::SetTuple(size_t id, WordUnit value) {
 	size_t block_id = id / kNumTuplesPerBlock;
 	size_t pos_in_block = id % kNumTuplesPerBlock;
 	blocks_[block_id]->SetTuple(pos_in_block, value);
+	DropUpdates(id, id + 1);
 }
 
+//Text is split into pieces of about this size, ending between values
+static constexpr size_t kTextPieceSize = 1 << 20;
+
 size_t Column::LoadTextFile(std::string filepath) {
-	std::ifstream infile;
-	infile.open(filepath, std::ifstream::in);
-	if (!infile.good()) {
+	const int fd = open(filepath.c_str(), O_RDONLY);
+	struct stat file_stat;
+	if (fd < 0 || 0 != fstat(fd, &file_stat)) {
 		std::cerr << "Can't open file: " << filepath << std::endl;
+		if (fd >= 0) {
+			close(fd);
+		}
+		return -1;
+	}
+	const size_t size = file_stat.st_size;
+	if (0 == size) {
+		close(fd);
+		return 0;
+	}
+	void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (MAP_FAILED == addr) {
+		std::cerr << "Can't map file: " << filepath << std::endl;
 		return -1;
 	}
-	WordUnit val;
-	size_t id = 0;
-	for (id = 0; (id < GetNumTuples()) && (infile >> val); id++) {
-		SetTuple(id, val);
+	madvise(addr, size, MADV_WILLNEED);
+	const char* text = static_cast<const char*>(addr);
+	const char* text_end = text + size;
+
+	const size_t num_pieces = CEIL(size, kTextPieceSize);
+	std::vector<const char*> piece_begin(num_pieces + 1, text_end);
+	for (size_t piece = 0; piece < num_pieces; piece++) {
+		const char* p = text + piece * kTextPieceSize;
+		while (p > text && p < text_end && static_cast<unsigned char>(p[-1] - '0') < 10) {
+			p++;
+		}
+		piece_begin[piece] = p;
+	}
+
+	//first_id[i]: id of the first value in piece i
+	std::vector<size_t> first_id(num_pieces + 1, 0);
+#pragma omp parallel for schedule(dynamic)
+	for (size_t piece = 0; piece < num_pieces; piece++) {
+		first_id[piece + 1] = CountIntegers(piece_begin[piece], piece_begin[piece + 1]);
+	}
+	std::partial_sum(first_id.begin(), first_id.end(), first_id.begin());
+	const size_t num_loaded = std::min(first_id.back(), num_tuples_);
+
+	//every block is parsed and loaded by one thread
+#pragma omp parallel for schedule(dynamic)
+	for (size_t block_id = 0; block_id < blocks_.size(); block_id++) {
+		const size_t begin_id = block_id * kNumTuplesPerBlock;
+		if (begin_id >= num_loaded) {
+			continue;
+		}
+		const size_t num = std::min(blocks_[block_id]->num_tuples(), num_loaded - begin_id);
+		const size_t piece = std::upper_bound(first_id.begin(), first_id.end(), begin_id)
+				- first_id.begin() - 1;
+		const char* begin = SkipIntegers(piece_begin[piece], text_end,
+				begin_id - first_id[piece]);
+		std::vector<WordUnit> codes(num);
+		const char* stop;
+		ParseIntegers(begin, text_end, codes.data(), num, &stop);
+		blocks_[block_id]->BulkLoadArray(codes.data(), num, 0);
 	}
-	infile.close();
-	return id;
+	DropUpdates(0, num_loaded);
+
+	munmap(addr, size);
+	return num_loaded;
 }
 
 void Column::Resize(size_t num) {
+	//blocks may go away
+	Merge();
 	num_tuples_ = num;
 	const size_t new_num_blocks = CEIL(num, kNumTuplesPerBlock);
 	const size_t old_num_blocks = blocks_.size();
@@ -77,14 +192,15 @@ void Column::Resize(size_t num) {
 		blocks_[old_num_blocks - 1]->Resize(kNumTuplesPerBlock);
 		// append new blocks
 		for (size_t bid = old_num_blocks; bid < new_num_blocks; bid++) {
-			ColumnBlock* new_block = CreateNewBlock();
+			ColumnBlock* new_block = CreateNewBlock(GetBlockNode(blocks_.size()));
 			new_block->Resize(kNumTuplesPerBlock);
 			blocks_.push_back(new_block);
+			block_owners_.emplace_back(new_block);
 		}
 	} else if (new_num_blocks < old_num_blocks) {   // need to remove blocks
 		for (size_t bid = old_num_blocks - 1; bid > new_num_blocks; bid--) {
-			delete blocks_.back();
 			blocks_.pop_back();
+			block_owners_.pop_back();
 		}
 	}
 	// now the number of block is desired
@@ -95,11 +211,248 @@ void Column::Resize(size_t num) {
 	}
 
 	assert(blocks_.size() == new_num_blocks);
+	Publish();
+}
+
+void Column::Publish() {
+	const std::shared_ptr<const ColumnVersion> current = version_;
+	if (nullptr == current || current->blocks != block_owners_ || current->deltas != deltas_) {
+		std::shared_ptr<ColumnVersion> version = std::make_shared<ColumnVersion>();
+		version->blocks = block_owners_;
+		version->deltas = deltas_;
+		std::atomic_store(&version_, std::shared_ptr<const ColumnVersion>(version));
+	}
+	//the version above covers every published tuple
+	num_published_.store(num_tuples_, std::memory_order_release);
+}
+
+size_t Column::Append(const WordUnit* codes, size_t num) {
+	std::lock_guard<std::mutex> lock(write_mutex_);
+	assert(nullptr == mapping_);
+	const size_t first_id = num_tuples_;
+	size_t done = 0;
+	while (done < num) {
+		const size_t pos_in_block = num_tuples_ % kNumTuplesPerBlock;
+		if (num_tuples_ == blocks_.size() * kNumTuplesPerBlock) {
+			//tail block is full; the new one is published with the tuples below
+			ColumnBlock* new_block = CreateNewBlock(GetBlockNode(blocks_.size()));
+			new_block->Resize(0);
+			blocks_.push_back(new_block);
+			block_owners_.emplace_back(new_block);
+		}
+		//snapshots don't read past their tuples, so the tail grows in place
+		const size_t count = std::min(num - done, kNumTuplesPerBlock - pos_in_block);
+		blocks_.back()->Resize(pos_in_block + count);
+		blocks_.back()->BulkLoadArray(codes + done, count, pos_in_block);
+		num_tuples_ += count;
+		done += count;
+	}
+	Publish();
+	return first_id;
+}
+
+void Column::Update(size_t id, WordUnit value) {
+	Update(&id, &value, 1);
+}
+
+void Column::Update(const size_t* ids, const WordUnit* values, size_t num) {
+	std::lock_guard<std::mutex> lock(write_mutex_);
+	//by tuple id; the last update of a tuple wins
+	std::vector<size_t> order(num);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(),
+			[ids](size_t a, size_t b) { return ids[a] < ids[b]; });
+
+	//copy on write: snapshots and scans keep the table they loaded
+	std::shared_ptr<DeltaTable> table = std::make_shared<DeltaTable>(
+			nullptr == deltas_ ? DeltaTable() : *deltas_);
+	table->resize(std::max(table->size(), blocks_.size()));
+	size_t num_pending = num_deltas_.load(std::memory_order_relaxed);
+	for (size_t i = 0; i < num;) {
+		assert(ids[order[i]] < num_tuples_);
+		assert(values[order[i]] < (1ULL << bit_width_));
+		const size_t block_id = ids[order[i]] / kNumTuplesPerBlock;
+		size_t end = i;
+		while (end < num && block_id == ids[order[end]] / kNumTuplesPerBlock) {
+			end++;
+		}
+		static const BlockDelta kEmpty;
+		const BlockDelta &old_delta = nullptr == (*table)[block_id] ?
+				kEmpty : *(*table)[block_id];
+		std::shared_ptr<BlockDelta> delta = std::make_shared<BlockDelta>();
+		delta->reserve(old_delta.size() + end - i);
+		size_t old_pos = 0;
+		while (old_pos < old_delta.size() || i < end) {
+			const size_t pos = i < end ? ids[order[i]] % kNumTuplesPerBlock : kNumTuplesPerBlock;
+			if (old_pos < old_delta.size() && old_delta[old_pos].first < pos) {
+				delta->push_back(old_delta[old_pos++]);
+				continue;
+			}
+			while (i + 1 < end && ids[order[i + 1]] == ids[order[i]]) {
+				i++;
+			}
+			delta->emplace_back(pos, values[order[i++]]);
+			if (old_pos < old_delta.size() && old_delta[old_pos].first == pos) {
+				old_pos++;
+			}
+		}
+		num_pending += delta->size() - old_delta.size();
+		(*table)[block_id] = delta;
+	}
+	deltas_ = table;
+	Publish();
+	num_deltas_.store(num_pending, std::memory_order_release);
+}
+
+size_t Column::GetNumPendingUpdates() const {
+	return num_deltas_.load(std::memory_order_acquire);
+}
+
+//Updates of consecutive tuples at least this long are merged by bulk load
+static constexpr size_t kMinBulkMergeRun = 64;
+
+//Writes the pending updates of a block into it
+static void MergeDelta(const BlockDelta &delta, ColumnBlock* block) {
+	std::vector<WordUnit> run;
+	for (size_t i = 0; i < delta.size();) {
+		size_t end = i + 1;
+		while (end < delta.size() && delta[end].first == delta[end - 1].first + 1) {
+			end++;
+		}
+		if (end - i < kMinBulkMergeRun) {
+			for (; i < end; i++) {
+				block->SetTuple(delta[i].first, delta[i].second);
+			}
+			continue;
+		}
+		//transposed into the slices with SIMD
+		run.clear();
+		for (size_t k = i; k < end; k++) {
+			run.push_back(delta[k].second);
+		}
+		block->BulkLoadArray(run.data(), run.size(), delta[i].first);
+		i = end;
+	}
+}
+
+//Block block_id of a version with its pending updates: the block itself,
+//or a merged copy kept in copy
+static const ColumnBlock* GetMergedBlock(const ColumnVersion &version, size_t block_id,
+		std::unique_ptr<ColumnBlock> &copy) {
+	const ColumnBlock* block = version.blocks[block_id].get();
+	const BlockDelta* delta = GetBlockDelta(version.deltas.get(), block_id);
+	if (nullptr == delta) {
+		return block;
+	}
+	copy.reset(block->Clone(kAnyNode));
+	MergeDelta(*delta, copy.get());
+	return copy.get();
+}
+
+void Column::Merge() {
+	std::lock_guard<std::mutex> lock(write_mutex_);
+	const std::shared_ptr<const DeltaTable> table = deltas_;
+	if (nullptr == table) {
+		return;
+	}
+
+	//Into copies: scans and snapshots that started earlier keep reading the
+	//old blocks with the old deltas, and never see part of a merge.
+	std::vector<std::shared_ptr<ColumnBlock>> merged(table->size());
+#pragma omp parallel for schedule(dynamic)
+	for (size_t block_id = 0; block_id < table->size(); block_id++) {
+		if (nullptr == (*table)[block_id]) {
+			continue;
+		}
+		merged[block_id].reset(blocks_[block_id]->Clone(GetBlockNode(block_id)));
+		MergeDelta(*(*table)[block_id], merged[block_id].get());
+	}
+	for (size_t block_id = 0; block_id < merged.size(); block_id++) {
+		if (nullptr != merged[block_id]) {
+			blocks_[block_id] = merged[block_id].get();
+			block_owners_[block_id] = std::move(merged[block_id]);
+		}
+	}
+	DiscardUpdates();
+}
+
+void Column::DiscardUpdates() {
+	deltas_.reset();
+	num_deltas_.store(0, std::memory_order_release);
+	Publish();
+}
+
+void Column::DropUpdates(size_t begin, size_t end) {
+	if (0 == num_deltas_.load(std::memory_order_acquire) || begin >= end) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(write_mutex_);
+	//copy on write, as in Update, once a block has updates to drop
+	std::shared_ptr<DeltaTable> table;
+	size_t num_pending = num_deltas_.load(std::memory_order_relaxed);
+	const size_t last_block = std::min(deltas_->size(), CEIL(end, kNumTuplesPerBlock));
+	for (size_t block_id = begin / kNumTuplesPerBlock; block_id < last_block; block_id++) {
+		const BlockDelta* old_delta = (*deltas_)[block_id].get();
+		if (nullptr == old_delta) {
+			continue;
+		}
+		const size_t block_begin = block_id * kNumTuplesPerBlock;
+		const size_t first = std::max(begin, block_begin) - block_begin;
+		const size_t last = std::min(end - block_begin, kNumTuplesPerBlock);
+		std::shared_ptr<BlockDelta> delta = std::make_shared<BlockDelta>();
+		for (const auto &update : *old_delta) {
+			if (update.first < first || update.first >= last) {
+				delta->push_back(update);
+			}
+		}
+		if (delta->size() == old_delta->size()) {
+			continue;
+		}
+		if (nullptr == table) {
+			table = std::make_shared<DeltaTable>(*deltas_);
+		}
+		num_pending -= old_delta->size() - delta->size();
+		(*table)[block_id] = delta->empty() ? nullptr : delta;
+	}
+	if (nullptr == table) {
+		return;
+	}
+	if (0 == num_pending) {
+		deltas_.reset();
+	}
+	else {
+		deltas_ = table;
+	}
+	Publish();
+	num_deltas_.store(num_pending, std::memory_order_release);
+}
+
+ColumnSnapshot Column::Snapshot() const {
+	//the count first: the list loaded after it covers the counted tuples
+	const size_t num = num_published_.load(std::memory_order_acquire);
+	return ColumnSnapshot(std::atomic_load(&version_), num);
+}
+
+ColumnSnapshot::ColumnSnapshot(std::shared_ptr<const ColumnVersion> version,
+		size_t num_tuples) :
+		version_(std::move(version)), num_tuples_(num_tuples) {
+}
+
+WordUnit ColumnSnapshot::GetTuple(size_t id) const {
+	assert(id < num_tuples_);
+	WordUnit value;
+	if (FindUpdate(version_->deltas.get(), id / kNumTuplesPerBlock,
+			id % kNumTuplesPerBlock, value)) {
+		return value;
+	}
+	return version_->blocks[id / kNumTuplesPerBlock]->GetTuple(id % kNumTuplesPerBlock);
 }
 
 void Column::SerToFile(SequentialWriteBinaryFile &file) const {
-	for (auto block : blocks_) {
-		block->SerToFile(file);
+	const std::shared_ptr<const ColumnVersion> version = std::atomic_load(&version_);
+	for (size_t block_id = 0; block_id < version->blocks.size(); block_id++) {
+		std::unique_ptr<ColumnBlock> merged;
+		GetMergedBlock(*version, block_id, merged)->SerToFile(file);
 	}
 }
 
@@ -107,36 +460,586 @@ void Column::DeserFromFile(const SequentialReadBinaryFile &file) {
 	for (auto block : blocks_) {
 		block->DeserFromFile(file);
 	}
+	DiscardUpdates();
+}
+
+bool Column::MapFile(const std::string &filename, MapHint hint, size_t offset) {
+	if (nullptr != mapping_) {
+		std::cerr << "Column is already mapped" << std::endl;
+		return false;
+	}
+	const int fd = open(filename.c_str(), O_RDONLY);
+	struct stat file_stat;
+	if (fd < 0 || 0 != fstat(fd, &file_stat)) {
+		std::cerr << "Can't open file: " << filename << std::endl;
+		if (fd >= 0) {
+			close(fd);
+		}
+		return false;
+	}
+	const size_t size = file_stat.st_size;
+	const int flags = MAP_SHARED | (MapHint::kPopulate == hint ? MAP_POPULATE : 0);
+	void* addr = 0 == size ? MAP_FAILED : mmap(nullptr, size, PROT_READ, flags, fd, 0);
+	close(fd);
+	if (MAP_FAILED == addr) {
+		std::cerr << "Can't map file: " << filename << std::endl;
+		return false;
+	}
+	switch (hint) {
+	case MapHint::kWillNeed:
+		madvise(addr, size, MADV_WILLNEED);
+		break;
+	case MapHint::kRandom:
+		madvise(addr, size, MADV_RANDOM);
+		break;
+	default:
+		break;
+	}
+
+	//records are aligned relative to the file start
+	const char* buffer = static_cast<const char*>(addr);
+	bool ok = 0 == offset % ColumnBlock::kRecordAlignment;
+	for (size_t block_id = 0; ok && block_id < blocks_.size(); block_id++) {
+		ok = blocks_[block_id]->MapFromBuffer(buffer, size, offset);
+	}
+	DiscardUpdates();
+	//kept even on failure: some blocks may point into it already
+	mapping_ = addr;
+	mapping_size_ = size;
+	if (!ok) {
+		std::cerr << "Corrupted column file: " << filename << std::endl;
+	}
+	return ok;
+}
+
+//Column file layout, see SaveToFile
+static const char kColumnFileMagic[8] = {'B', 'Y', 'T', 'E', 'S', 'L', 'C', 'E'};
+//2: block records carry their compression
+static constexpr uint32_t kColumnFileVersion = 2;
+
+struct ColumnFileHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t type;
+	uint64_t bit_width;
+	uint64_t num_tuples;
+	uint64_t num_blocks;
+	uint64_t directory_offset;
+	uint64_t compression;
+};
+
+struct ColumnFileEntry {
+	uint64_t offset;
+	uint64_t length;
+};
+
+//Reads and checks the header and the directory; leaves the file position undefined
+static bool ReadColumnFileHeader(const SequentialReadBinaryFile &file,
+		const std::string &filename, ColumnFileHeader &header,
+		std::vector<ColumnFileEntry> &directory) {
+	if (sizeof(header) != file.Read(&header, sizeof(header))
+			|| 0 != memcmp(header.magic, kColumnFileMagic, sizeof(kColumnFileMagic))) {
+		std::cerr << "Not a column file: " << filename << std::endl;
+		return false;
+	}
+	if (kColumnFileVersion != header.version) {
+		std::cerr << "Unsupported column file version " << header.version
+				<< ": " << filename << std::endl;
+		return false;
+	}
+	const ColumnType type = static_cast<ColumnType>(header.type);
+	if ((ColumnType::kNaive != type && ColumnType::kByteSlicePadRight != type)
+			|| 0 == header.bit_width || 32 < header.bit_width
+			|| CEIL(header.num_tuples, kNumTuplesPerBlock) != header.num_blocks) {
+		std::cerr << "Corrupted column file: " << filename << std::endl;
+		return false;
+	}
+	directory.resize(header.num_blocks);
+	const size_t size = sizeof(ColumnFileEntry) * header.num_blocks;
+	if (!file.Seek(header.directory_offset)
+			|| size != file.Read(directory.data(), size)) {
+		std::cerr << "Corrupted column file: " << filename << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool Column::SaveToFile(const std::string &filename, Compression compression) const {
+	SequentialWriteBinaryFile file;
+	if (!file.Open(filename)) {
+		return false;
+	}
+	//pending updates are written as merged
+	const std::shared_ptr<const ColumnVersion> version = std::atomic_load(&version_);
+	ColumnFileHeader header;
+	memcpy(header.magic, kColumnFileMagic, sizeof(kColumnFileMagic));
+	header.version = kColumnFileVersion;
+	header.type = static_cast<uint32_t>(type_);
+	header.bit_width = bit_width_;
+	header.num_tuples = num_tuples_;
+	header.num_blocks = version->blocks.size();
+	header.directory_offset = 0;
+	header.compression = static_cast<uint64_t>(compression);
+	file.Append(&header, sizeof(header));
+	file.Align(ColumnBlock::kRecordAlignment);
+
+	std::vector<ColumnFileEntry> directory(version->blocks.size());
+	for (size_t block_id = 0; block_id < version->blocks.size(); block_id++) {
+		directory[block_id].offset = file.Tell();
+		std::unique_ptr<ColumnBlock> merged;
+		GetMergedBlock(*version, block_id, merged)->SerToFile(file, compression);
+		directory[block_id].length = file.Tell() - directory[block_id].offset;
+	}
+	header.directory_offset = file.Tell();
+	file.Append(directory.data(), sizeof(ColumnFileEntry) * directory.size());
+
+	//the header is complete now
+	bool ok = file.Seek(0) && sizeof(header) == file.Append(&header, sizeof(header));
+	ok = file.Flush() && ok;
+	return file.Close() && ok;
+}
+
+Column* Column::LoadFromFile(const std::string &filename) {
+	SequentialReadBinaryFile file;
+	if (!file.Open(filename)) {
+		return nullptr;
+	}
+	ColumnFileHeader header;
+	std::vector<ColumnFileEntry> directory;
+	if (!ReadColumnFileHeader(file, filename, header, directory)) {
+		file.Close();
+		return nullptr;
+	}
+	Column* column = new Column(static_cast<ColumnType>(header.type), header.bit_width,
+			header.num_tuples);
+	for (size_t block_id = 0; block_id < column->blocks_.size(); block_id++) {
+		file.Seek(directory[block_id].offset);
+		column->blocks_[block_id]->DeserFromFile(file);
+	}
+	file.Close();
+	return column;
+}
+
+Column* Column::MapFromFile(const std::string &filename, MapHint hint) {
+	SequentialReadBinaryFile file;
+	if (!file.Open(filename)) {
+		return nullptr;
+	}
+	ColumnFileHeader header;
+	std::vector<ColumnFileEntry> directory;
+	const bool ok = ReadColumnFileHeader(file, filename, header, directory);
+	file.Close();
+	if (!ok) {
+		return nullptr;
+	}
+	if (static_cast<uint64_t>(Compression::kNone) != header.compression) {
+		std::cerr << "Compressed column file can't be mapped: " << filename << std::endl;
+		return nullptr;
+	}
+	Column* column = new Column(static_cast<ColumnType>(header.type), header.bit_width,
+			header.num_tuples);
+	//records follow each other from the first one
+	if (!column->MapFile(filename, hint, directory.empty() ? 0 : directory[0].offset)) {
+		delete column;
+		return nullptr;
+	}
+	return column;
+}
+
+bool Column::LoadBlockFromFile(const std::string &filename, size_t block_id) {
+	assert(block_id < blocks_.size());
+	SequentialReadBinaryFile file;
+	if (!file.Open(filename)) {
+		return false;
+	}
+	ColumnFileHeader header;
+	std::vector<ColumnFileEntry> directory;
+	bool ok = ReadColumnFileHeader(file, filename, header, directory);
+	if (ok && (static_cast<ColumnType>(header.type) != type_
+			|| header.bit_width != bit_width_ || header.num_tuples != num_tuples_)) {
+		std::cerr << "Column file of another schema: " << filename << std::endl;
+		ok = false;
+	}
+	if (ok && !blocks_[block_id]->mapped()) {
+		file.Seek(directory[block_id].offset);
+		blocks_[block_id]->DeserFromFile(file);
+		DropUpdates(block_id * kNumTuplesPerBlock, (block_id + 1) * kNumTuplesPerBlock);
+	}
+	file.Close();
+	return ok && !blocks_[block_id]->mapped();
 }
 
 void Column::BulkLoadArray(const WordUnit* codes, size_t num, size_t pos) {
 	assert(pos + num <= num_tuples_);
-	size_t block_id = pos / kNumTuplesPerBlock;
-	size_t pos_in_block = pos % kNumTuplesPerBlock;
-	size_t num_remain_tuples = num;
-	const WordUnit* data_ptr = codes;
-	while (num_remain_tuples > 0) {
-		size_t size = std::min(blocks_[block_id]->num_tuples() - pos_in_block,
-				num_remain_tuples);
-		blocks_[block_id]->BulkLoadArray(data_ptr, size, pos_in_block);
-		data_ptr += size;
-		num_remain_tuples -= size;
-		pos_in_block = 0;
-		block_id++;
+	if (0 == num) {
+		return;
+	}
+	const size_t first_block = pos / kNumTuplesPerBlock;
+	const size_t last_block = (pos + num - 1) / kNumTuplesPerBlock;
+
+	//blocks are filled independently
+#pragma omp parallel for schedule(dynamic)
+	for (size_t block_id = first_block; block_id <= last_block; block_id++) {
+		const size_t begin = std::max(pos, block_id * kNumTuplesPerBlock);
+		const size_t end = std::min(pos + num, (block_id + 1) * kNumTuplesPerBlock);
+		blocks_[block_id]->BulkLoadArray(codes + (begin - pos), end - begin,
+				begin % kNumTuplesPerBlock);
+	}
+	DropUpdates(pos, pos + num);
+}
+
+void Column::BuildImprints() {
+#pragma omp parallel for schedule(dynamic)
+	for (size_t block_id = 0; block_id < blocks_.size(); block_id++) {
+		blocks_[block_id]->BuildImprints();
+	}
+}
+
+//Bit vector words kept in L1 by chunked scans (4096 tuples)
+static constexpr size_t kNumChunkWords = 64;
+
+//Result of a block decided by its zone map, without reading the block
+static void FillBVBlock(BitVectorBlock* bvblock, BlockMatch match, Bitwise bit_opt) {
+	assert(BlockMatch::kSome != match);
+	if (BlockMatch::kAll == match && Bitwise::kAnd != bit_opt) {
+		bvblock->SetOnes();
+	}
+	else if (BlockMatch::kNone == match && Bitwise::kOr != bit_opt) {
+		bvblock->SetZeros();
+	}
+}
+
+static bool EvaluateComparator(WordUnit value, Comparator comparator, WordUnit literal) {
+	switch (comparator) {
+	case Comparator::kLess:
+		return value < literal;
+	case Comparator::kGreater:
+		return value > literal;
+	case Comparator::kLessEqual:
+		return value <= literal;
+	case Comparator::kGreaterEqual:
+		return value >= literal;
+	case Comparator::kEqual:
+		return value == literal;
+	case Comparator::kInequal:
+		return value != literal;
+	}
+	return false;
+}
+
+//Runs scan on a block, then sets the bit of tuple pos(i) to pred(i) for
+//i < num: the block scan saw the old values of these updated tuples.
+template <typename SCAN, typename POS, typename PRED>
+static void ScanAndPatch(size_t num, BitVectorBlock* bvblock, Bitwise bit_opt,
+		SCAN scan, POS pos, PRED pred) {
+	std::vector<bool> before(num);
+	for (size_t i = 0; Bitwise::kSet != bit_opt && i < num; i++) {
+		before[i] = bvblock->GetBit(pos(i));
+	}
+	scan();
+	for (size_t i = 0; i < num; i++) {
+		bool bit = pred(i);
+		if (Bitwise::kAnd == bit_opt) {
+			bit = bit && before[i];
+		}
+		else if (Bitwise::kOr == bit_opt) {
+			bit = bit || before[i];
+		}
+		if (bit) {
+			bvblock->SetBit(pos(i));
+		}
+		else {
+			bvblock->UnsetBit(pos(i));
+		}
 	}
 }
 
+//Runs scan on a block, then sets the bits of its pending updates to
+//pred(new value): the block scan saw the old values.
+template <typename SCAN, typename PRED>
+static void ScanWithDelta(const DeltaTable* deltas, size_t block_id,
+		BitVectorBlock* bvblock, Bitwise bit_opt, SCAN scan, PRED pred) {
+	const BlockDelta* block_delta = GetBlockDelta(deltas, block_id);
+	if (nullptr == block_delta) {
+		scan();
+		return;
+	}
+	const BlockDelta &delta = *block_delta;
+	//updates past the tuples of bvblock (e.g. a snapshot's tail) don't apply
+	const size_t num = std::lower_bound(delta.begin(), delta.end(),
+			std::make_pair(bvblock->num(), WordUnit(0))) - delta.begin();
+	ScanAndPatch(num, bvblock, bit_opt, scan, [&](size_t i) {
+		return delta[i].first;
+	}, [&](size_t i) {
+		return pred(delta[i].second);
+	});
+}
+
 void Column::Scan(Comparator comparator, WordUnit literal, BitVector* bitvector,
 		Bitwise bit_opt) const {
 
 	assert(num_tuples_ == bitvector->num());
+	const std::shared_ptr<const ColumnVersion> version = std::atomic_load(&version_);
+	const DeltaTable* deltas = version->deltas.get();
 
-#pragma omp parallel for schedule(dynamic)
-	for (size_t block_id = 0; block_id < blocks_.size(); block_id++) {
+	ForEachBlock(version->blocks.size(), [&](size_t block_id) {
+		const ColumnBlock* block = version->blocks[block_id].get();
+		BitVectorBlock* bvblock = bitvector->GetBVBlock(block_id);
+		ScanWithDelta(deltas, block_id, bvblock, bit_opt, [&]() {
+			BlockMatch match = block->Match(comparator, literal);
+			if (BlockMatch::kSome != match) {
+				FillBVBlock(bvblock, match, bit_opt);
+				return;
+			}
+			block->Scan(comparator, literal, bvblock, bit_opt);
+		}, [&](WordUnit value) {
+			return EvaluateComparator(value, comparator, literal);
+		});
+	});
+}
+
+void Column::Scan(Comparator comparator, WordUnit literal, CompressedBitVector* bitvector,
+		Bitwise bit_opt) const {
+
+	assert(num_tuples_ == bitvector->num());
+	const std::shared_ptr<const ColumnVersion> version = std::atomic_load(&version_);
+	const DeltaTable* deltas = version->deltas.get();
+
+	ForEachBlock(version->blocks.size(), [&](size_t block_id) {
+		const ColumnBlock* block = version->blocks[block_id].get();
+		const BlockMatch match = block->Match(comparator, literal);
+		const bool updated = nullptr != GetBlockDelta(deltas, block_id);
+		if (BlockMatch::kSome != match && !updated) {
+			if (BlockMatch::kAll == match && Bitwise::kAnd != bit_opt) {
+				bitvector->FillBlock(block_id, true);
+			}
+			else if (BlockMatch::kNone == match && Bitwise::kOr != bit_opt) {
+				bitvector->FillBlock(block_id, false);
+			}
+			return;
+		}
+		BitVectorBlock bvblock(block->num_tuples());
+		if (Bitwise::kSet != bit_opt) {
+			bitvector->GetBlock(block_id, &bvblock);
+		}
+		ScanWithDelta(deltas, block_id, &bvblock, bit_opt, [&]() {
+			if (BlockMatch::kSome != match) {
+				FillBVBlock(&bvblock, match, bit_opt);
+				return;
+			}
+			block->Scan(comparator, literal, &bvblock, bit_opt);
+		}, [&](WordUnit value) {
+			return EvaluateComparator(value, comparator, literal);
+		});
+		bitvector->SetBlock(block_id, &bvblock);
+	});
+}
+
+void ColumnSnapshot::Scan(Comparator comparator, WordUnit literal, BitVector* bitvector,
+		Bitwise bit_opt) const {
+
+	assert(num_tuples_ == bitvector->num());
+	const size_t num_blocks = GetNumBlocks();
+
+	ForEachBlock(num_blocks, [&](size_t block_id) {
+		const ColumnBlock* block = version_->blocks[block_id].get();
+		BitVectorBlock* bvblock = bitvector->GetBVBlock(block_id);
+		ScanWithDelta(version_->deltas.get(), block_id, bvblock, bit_opt, [&]() {
+			if (kNumTuplesPerBlock == bvblock->num()) {
+				//full blocks are no longer appended to
+				BlockMatch match = block->Match(comparator, literal);
+				if (BlockMatch::kSome != match) {
+					FillBVBlock(bvblock, match, bit_opt);
+					return;
+				}
+				block->Scan(comparator, literal, bvblock, bit_opt);
+				return;
+			}
+			//The tail block may be growing: Append rewrites the zone map and the
+			//imprint, data and size of the partially filled last word. Only the
+			//full words go through the block scan; the rest is read tuple by tuple.
+			const size_t num_full_words = bvblock->num() / kNumWordBits;
+			const size_t num_tail_bits = bvblock->num() % kNumWordBits;
+			auto filter_words = [&](WordUnit* words) {
+				if (0 < num_full_words) {
+					//FilterWords cannot check against num_tuples(), which Append
+					//may be writing; the snapshot size bounds the words here
+					assert(num_full_words * kNumWordBits <= bvblock->num());
+					block->FilterWords(comparator, literal, words, 0, num_full_words);
+				}
+				for (size_t i = 0; i < num_tail_bits; i++) {
+					const WordUnit value = block->GetTuple(num_full_words * kNumWordBits + i);
+					if (!EvaluateComparator(value, comparator, literal)) {
+						words[num_full_words] &= ~(1ULL << i);
+					}
+				}
+			};
+			if (Bitwise::kAnd == bit_opt) {
+				filter_words(bvblock->data());
+				bvblock->ClearTail();
+				return;
+			}
+			BitVectorBlock filter(bvblock->num());
+			filter.SetOnes();
+			filter_words(filter.data());
+			if (Bitwise::kSet == bit_opt) {
+				bvblock->Set(&filter);
+			}
+			else {
+				bvblock->Or(&filter);
+			}
+		}, [&](WordUnit value) {
+			return EvaluateComparator(value, comparator, literal);
+		});
+	});
+}
+
+//O_DIRECT transfers start, end and land on this alignment
+static constexpr size_t kDirectIOAlignment = 4096;
+
+//Reads [begin, end) of fd into buffer; a short read is only allowed at the file end
+static bool ReadRange(int fd, char* buffer, size_t begin, size_t end, size_t needed) {
+	size_t done = 0;
+	while (begin + done < end) {
+		const ssize_t count = pread(fd, buffer + done, end - begin - done, begin + done);
+		if (count < 0 && EINTR == errno) {
+			continue;
+		}
+		if (count <= 0) {
+			break;
+		}
+		done += count;
+	}
+	return done >= needed;
+}
+
+bool Column::ScanFile(const std::string &filename, Comparator comparator,
+		WordUnit literal, BitVector* bitvector, Bitwise bit_opt, size_t depth) {
+	assert(0 < depth);
+	SequentialReadBinaryFile file;
+	if (!file.Open(filename)) {
+		return false;
+	}
+	ColumnFileHeader header;
+	std::vector<ColumnFileEntry> directory;
+	const bool ok = ReadColumnFileHeader(file, filename, header, directory);
+	file.Close();
+	if (!ok) {
+		return false;
+	}
+	if (static_cast<uint64_t>(Compression::kNone) != header.compression
+			|| header.num_tuples != bitvector->num()) {
+		std::cerr << "Can't stream column file: " << filename << std::endl;
+		return false;
+	}
+	const size_t num_blocks = directory.size();
+	depth = std::max<size_t>(1, std::min(depth, num_blocks));
+
+	//page cache bypassed where supported (not e.g. on tmpfs)
+	int fd = open(filename.c_str(), O_RDONLY | O_DIRECT);
+	if (fd < 0) {
+		fd = open(filename.c_str(), O_RDONLY);
+	}
+	if (fd < 0) {
+		std::cerr << "Can't open file: " << filename << std::endl;
+		return false;
+	}
+
+	//a slot holds block k % depth: its aligned buffer and a block mapping it
+	size_t buffer_size = 0;
+	for (const ColumnFileEntry &entry : directory) {
+		const size_t begin = entry.offset / kDirectIOAlignment * kDirectIOAlignment;
+		const size_t end = CEIL(entry.offset + entry.length, kDirectIOAlignment)
+				* kDirectIOAlignment;
+		buffer_size = std::max(buffer_size, end - begin);
+	}
+	const Column schema(static_cast<ColumnType>(header.type), header.bit_width);
+	std::vector<char*> buffers(depth, nullptr);
+	std::vector<ColumnBlock*> slot_blocks(depth, nullptr);
+	std::vector<size_t> ready(depth, num_blocks);  //block held by the slot
+	std::vector<bool> read_ok(depth, false);
+	bool alloc_ok = true;
+	for (size_t slot = 0; slot < depth; slot++) {
+		void* buffer = nullptr;
+		alloc_ok = alloc_ok && 0 == posix_memalign(&buffer, kDirectIOAlignment, buffer_size);
+		buffers[slot] = static_cast<char*>(buffer);
+		slot_blocks[slot] = schema.CreateNewBlock();
+	}
 
-		blocks_[block_id]->Scan(comparator, literal,
-				bitvector->GetBVBlock(block_id), bit_opt);
+	std::mutex mutex;
+	std::condition_variable cond;
+	size_t num_consumed = 0;
+	bool abort = !alloc_ok;
+
+	//reader r fetches blocks r, r + depth, ... once their slot is free
+	std::vector<std::thread> readers;
+	for (size_t r = 0; alloc_ok && r < depth; r++) {
+		readers.emplace_back([&, r]() {
+			for (size_t block_id = r; block_id < num_blocks; block_id += depth) {
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					cond.wait(lock, [&]() {
+						return abort || block_id < num_consumed + depth;
+					});
+					if (abort) {
+						return;
+					}
+				}
+				const ColumnFileEntry &entry = directory[block_id];
+				const size_t begin = entry.offset / kDirectIOAlignment * kDirectIOAlignment;
+				const size_t end = CEIL(entry.offset + entry.length, kDirectIOAlignment)
+						* kDirectIOAlignment;
+				const bool done = ReadRange(fd, buffers[r], begin, end,
+						entry.offset + entry.length - begin);
+				std::lock_guard<std::mutex> lock(mutex);
+				ready[r] = block_id;
+				read_ok[r] = done;
+				cond.notify_all();
+			}
+		});
+	}
+
+	bool scan_ok = alloc_ok;
+	for (size_t block_id = 0; scan_ok && block_id < num_blocks; block_id++) {
+		const size_t slot = block_id % depth;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			cond.wait(lock, [&]() { return block_id == ready[slot]; });
+			scan_ok = read_ok[slot];
+		}
+		//the record is scanned in place, in the buffer
+		const ColumnFileEntry &entry = directory[block_id];
+		size_t offset = entry.offset % kDirectIOAlignment;
+		ColumnBlock* block = slot_blocks[slot];
+		scan_ok = scan_ok && block->MapFromBuffer(buffers[slot], offset + entry.length, offset)
+				&& bitvector->GetBVBlock(block_id)->num() == block->num_tuples();
+		if (scan_ok) {
+			const BlockMatch match = block->Match(comparator, literal);
+			if (BlockMatch::kSome != match) {
+				FillBVBlock(bitvector->GetBVBlock(block_id), match, bit_opt);
+			}
+			else {
+				block->Scan(comparator, literal, bitvector->GetBVBlock(block_id), bit_opt);
+			}
+		}
+		std::lock_guard<std::mutex> lock(mutex);
+		num_consumed = block_id + 1;
+		abort = !scan_ok;
+		cond.notify_all();
+	}
+
+	for (std::thread &reader : readers) {
+		reader.join();
+	}
+	for (size_t slot = 0; slot < depth; slot++) {
+		delete slot_blocks[slot];
+		free(buffers[slot]);
+	}
+	close(fd);
+	if (!scan_ok) {
+		std::cerr << "Corrupted column file: " << filename << std::endl;
 	}
+	return scan_ok;
 }
 
 void Column::Scan(Comparator comparator, const Column* other_column,
@@ -146,15 +1049,454 @@ void Column::Scan(Comparator comparator, const Column* other_column,
 	assert(bit_width_ == other_column->GetBitWidth());
 	assert(num_tuples_ == other_column->GetNumTuples());
 
+	const std::shared_ptr<const ColumnVersion> version = std::atomic_load(&version_);
+	const std::shared_ptr<const ColumnVersion> other_version =
+			std::atomic_load(&other_column->version_);
+	ForEachBlock(version->blocks.size(), [&](size_t block_id) {
+		const ColumnBlock* block = version->blocks[block_id].get();
+		const ColumnBlock* other_block = other_version->blocks[block_id].get();
+		BitVectorBlock* bvblock = bitvector->GetBVBlock(block_id);
+		//tuples with a pending update in either column
+		std::vector<size_t> updated;
+		for (const DeltaTable* deltas : {version->deltas.get(), other_version->deltas.get()}) {
+			const BlockDelta* delta = GetBlockDelta(deltas, block_id);
+			for (size_t i = 0; nullptr != delta && i < delta->size(); i++) {
+				updated.push_back((*delta)[i].first);
+			}
+		}
+		std::sort(updated.begin(), updated.end());
+		updated.erase(std::unique(updated.begin(), updated.end()), updated.end());
+
+		ScanAndPatch(updated.size(), bvblock, bit_opt, [&]() {
+			block->Scan(comparator, other_block, bvblock, bit_opt);
+		}, [&](size_t i) {
+			return updated[i];
+		}, [&](size_t i) {
+			WordUnit value, other_value;
+			if (!FindUpdate(version->deltas.get(), block_id, updated[i], value)) {
+				value = block->GetTuple(updated[i]);
+			}
+			if (!FindUpdate(other_version->deltas.get(), block_id, updated[i], other_value)) {
+				other_value = other_block->GetTuple(updated[i]);
+			}
+			return EvaluateComparator(value, comparator, other_value);
+		});
+	});
+
+}
+
+void Column::ScanBetween(WordUnit lower, WordUnit upper, BitVector* bitvector,
+		Bitwise bit_opt) const {
+
+	assert(num_tuples_ == bitvector->num());
+	const std::shared_ptr<const ColumnVersion> version = std::atomic_load(&version_);
+	const DeltaTable* deltas = version->deltas.get();
+
+	ForEachBlock(version->blocks.size(), [&](size_t block_id) {
+		const ColumnBlock* block = version->blocks[block_id].get();
+		BitVectorBlock* bvblock = bitvector->GetBVBlock(block_id);
+		ScanWithDelta(deltas, block_id, bvblock, bit_opt, [&]() {
+			BlockMatch match = block->MatchBetween(lower, upper);
+			if (BlockMatch::kSome != match) {
+				FillBVBlock(bvblock, match, bit_opt);
+				return;
+			}
+			block->ScanBetween(lower, upper, bvblock, bit_opt);
+		}, [&](WordUnit value) {
+			return lower <= value && value <= upper;
+		});
+	});
+}
+
+void Column::ScanIn(const WordUnit* values, size_t num_values, BitVector* bitvector,
+		Bitwise bit_opt) const {
+
+	assert(num_tuples_ == bitvector->num());
+	const std::shared_ptr<const ColumnVersion> version = std::atomic_load(&version_);
+	const DeltaTable* deltas = version->deltas.get();
+
+	ForEachBlock(version->blocks.size(), [&](size_t block_id) {
+		const ColumnBlock* block = version->blocks[block_id].get();
+		BitVectorBlock* bvblock = bitvector->GetBVBlock(block_id);
+		ScanWithDelta(deltas, block_id, bvblock, bit_opt, [&]() {
+			block->ScanIn(values, num_values, bvblock, bit_opt);
+		}, [&](WordUnit value) {
+			return values + num_values != std::find(values, values + num_values, value);
+		});
+	});
+}
+
+
+//One block of ScanConjunction, on the blocks as they are
+static void ScanConjunctionBlock(const std::vector<ScanTerm> &terms,
+		const std::vector<std::shared_ptr<const ColumnVersion>> &versions, size_t block_id,
+		BitVectorBlock* bvblock, Bitwise bit_opt) {
+	const size_t num_words = CEIL(bvblock->num(), kNumWordBits);
+	WordUnit words[kNumChunkWords];
+
+	//terms the zone maps cannot decide for this block
+	std::vector<std::pair<const ScanTerm*, const ColumnBlock*>> block_terms;
+	BlockMatch block_match = BlockMatch::kAll;
+	for (size_t t = 0; t < terms.size(); t++) {
+		const ColumnBlock* block = versions[t]->blocks[block_id].get();
+		BlockMatch match = block->Match(terms[t].comparator, terms[t].literal);
+		if (BlockMatch::kNone == match) {
+			block_match = BlockMatch::kNone;
+			break;
+		}
+		if (BlockMatch::kSome == match) {
+			block_match = BlockMatch::kSome;
+			block_terms.push_back(std::make_pair(&terms[t], block));
+		}
+	}
+	if (BlockMatch::kSome != block_match) {
+		FillBVBlock(bvblock, block_match, bit_opt);
+		return;
+	}
+	//each term filters the block chunk by chunk, as one scan
+	std::vector<EarlyStopState> early_stops(block_terms.size());
+
+	for (size_t begin = 0; begin < num_words; begin += kNumChunkWords) {
+		const size_t n = std::min(kNumChunkWords, num_words - begin);
+		//alive tuples: everyone for kSet, those not yet set for kOr
+		for (size_t w = 0; w < n; w++) {
+			switch (bit_opt) {
+			case Bitwise::kSet:
+				words[w] = -1ULL;
+				break;
+			case Bitwise::kAnd:
+				words[w] = bvblock->GetWordUnit(begin + w);
+				break;
+			case Bitwise::kOr:
+				words[w] = ~bvblock->GetWordUnit(begin + w);
+				break;
+			}
+		}
+		for (size_t t = 0; t < block_terms.size(); t++) {
+			WordUnit alive = 0;
+			for (size_t w = 0; w < n; w++) {
+				alive |= words[w];
+			}
+			if (0 == alive) {
+				break;
+			}
+			const ScanTerm* term = block_terms[t].first;
+			block_terms[t].second->FilterWords(term->comparator, term->literal,
+					words, begin, n, &early_stops[t]);
+		}
+		for (size_t w = 0; w < n; w++) {
+			WordUnit x = words[w];
+			if (Bitwise::kOr == bit_opt) {
+				x |= bvblock->GetWordUnit(begin + w);
+			}
+			bvblock->SetWordUnit(x, begin + w);
+		}
+	}
+	bvblock->ClearTail();
+}
+
+void ScanConjunction(const std::vector<ScanTerm> &terms, BitVector* bitvector,
+		Bitwise bit_opt) {
+
+	//blocks and pending updates of every term, as Column::Scan loads them
+	std::vector<std::shared_ptr<const ColumnVersion>> versions;
+	for (const ScanTerm &term : terms) {
+		assert(term.column->GetNumTuples() == bitvector->num());
+		versions.push_back(std::atomic_load(&term.column->version_));
+	}
+
+	ForEachBlock(bitvector->GetNumBlocks(), [&](size_t block_id) {
+		BitVectorBlock* bvblock = bitvector->GetBVBlock(block_id);
+		//tuples with a pending update in any of the columns
+		std::vector<size_t> updated;
+		for (const auto &version : versions) {
+			const BlockDelta* delta = GetBlockDelta(version->deltas.get(), block_id);
+			for (size_t i = 0; nullptr != delta && i < delta->size(); i++) {
+				updated.push_back((*delta)[i].first);
+			}
+		}
+		std::sort(updated.begin(), updated.end());
+		updated.erase(std::unique(updated.begin(), updated.end()), updated.end());
+
+		ScanAndPatch(updated.size(), bvblock, bit_opt, [&]() {
+			ScanConjunctionBlock(terms, versions, block_id, bvblock, bit_opt);
+		}, [&](size_t i) {
+			return updated[i];
+		}, [&](size_t i) {
+			for (size_t t = 0; t < terms.size(); t++) {
+				WordUnit value;
+				if (!FindUpdate(versions[t]->deltas.get(), block_id, updated[i], value)) {
+					value = versions[t]->blocks[block_id]->GetTuple(updated[i]);
+				}
+				if (!EvaluateComparator(value, terms[t].comparator, terms[t].literal)) {
+					return false;
+				}
+			}
+			return true;
+		});
+	});
+}
+
+
+std::vector<size_t> Column::ScanToPositions(Comparator comparator, WordUnit literal,
+		uint32_t* positions) const {
+	return ScanToPositionsHelper(comparator, literal, positions);
+}
+
+std::vector<size_t> Column::ScanToPositions(Comparator comparator, WordUnit literal,
+		uint64_t* positions) const {
+	return ScanToPositionsHelper(comparator, literal, positions);
+}
+
+//The bit vector of a chunk only lives in L1 before it is expanded
+template <typename T>
+std::vector<size_t> Column::ScanToPositionsHelper(Comparator comparator,
+		WordUnit literal, T* positions) const {
+	const std::shared_ptr<const ColumnVersion> version = std::atomic_load(&version_);
+	std::vector<size_t> counts(version->blocks.size(), 0);
+
+	ForEachBlock(version->blocks.size(), [&](size_t block_id) {
+		const ColumnBlock* block = version->blocks[block_id].get();
+		const BlockDelta* delta = GetBlockDelta(version->deltas.get(), block_id);
+		const size_t block_offset = block_id * kNumTuplesPerBlock;
+		T* block_positions = positions + block_offset;
+		BlockMatch match = block->Match(comparator, literal);
+		if (BlockMatch::kNone == match && nullptr == delta) {
+			return;
+		}
+
+		const size_t num_words = CEIL(block->num_tuples(), kNumWordBits);
+		WordUnit words[kNumChunkWords];
+		EarlyStopState early_stop;
+		size_t count = 0;
+		size_t next_update = 0;
+		for (size_t begin = 0; begin < num_words; begin += kNumChunkWords) {
+			const size_t n = std::min(kNumChunkWords, num_words - begin);
+			for (size_t w = 0; w < n; w++) {
+				words[w] = (BlockMatch::kNone == match) ? 0 : -1ULL;
+			}
+			if (BlockMatch::kSome == match) {
+				block->FilterWords(comparator, literal, words, begin, n, &early_stop);
+			}
+			//pending updates of the chunk: the block holds their old values
+			const size_t chunk_end = (begin + n) * kNumWordBits;
+			for (; nullptr != delta && next_update < delta->size()
+					&& (*delta)[next_update].first < chunk_end; next_update++) {
+				const size_t bit = (*delta)[next_update].first - begin * kNumWordBits;
+				const WordUnit mask = 1ULL << (bit % kNumWordBits);
+				if (EvaluateComparator((*delta)[next_update].second, comparator, literal)) {
+					words[bit / kNumWordBits] |= mask;
+				}
+				else {
+					words[bit / kNumWordBits] &= ~mask;
+				}
+			}
+			const size_t num_bits = std::min(n * kNumWordBits,
+					block->num_tuples() - begin * kNumWordBits);
+			count += ExtractPositions(words, num_bits,
+					block_offset + begin * kNumWordBits, block_positions + count);
+		}
+		counts[block_id] = count;
+	});
+	return counts;
+}
+
+//Runs the aggregate f(block, filter block) of a block with its pending
+//updates: the updated tuples are taken out of the filter, and their new
+//values that the filter selects are added to updated.
+template <typename F>
+static void AggregateWithDelta(const ColumnVersion &version, size_t block_id,
+		const BitVector* filter, std::vector<WordUnit> &updated, F f) {
+	const ColumnBlock* block = version.blocks[block_id].get();
+	const BitVectorBlock* bvblock = nullptr == filter ? nullptr : filter->GetBVBlock(block_id);
+	const BlockDelta* delta = GetBlockDelta(version.deltas.get(), block_id);
+	if (nullptr == delta) {
+		f(block, bvblock);
+		return;
+	}
+	BitVectorBlock rest(block->num_tuples());
+	if (nullptr != bvblock) {
+		rest.Set(bvblock);
+	}
+	for (const auto &update : *delta) {
+		const size_t pos = update.first;
+		if ((rest.GetWordUnit(pos / kNumWordBits) >> (pos % kNumWordBits)) & 1ULL) {
+			updated.push_back(update.second);
+			rest.UnsetBit(pos);
+		}
+	}
+	f(block, &rest);
+}
+
+WordUnit Column::Sum(const BitVector* filter) const {
+	assert(nullptr == filter || num_tuples_ == filter->num());
+	const std::shared_ptr<const ColumnVersion> version = std::atomic_load(&version_);
+	WordUnit sum = 0;
+
+#pragma omp parallel for schedule(dynamic) reduction(+:sum)
+	for (size_t block_id = 0; block_id < version->blocks.size(); block_id++) {
+		std::vector<WordUnit> updated;
+		AggregateWithDelta(*version, block_id, filter, updated,
+				[&](const ColumnBlock* block, const BitVectorBlock* bvblock) {
+			sum += block->Sum(bvblock);
+		});
+		for (WordUnit value : updated) {
+			sum += value;
+		}
+	}
+	return sum;
+}
+
+size_t Column::Count(const BitVector* filter) const {
+	assert(nullptr == filter || num_tuples_ == filter->num());
+	return nullptr == filter ? num_tuples_ : filter->CountOnes();
+}
+
+double Column::Avg(const BitVector* filter) const {
+	const size_t count = Count(filter);
+	return 0 == count ? 0.0 : static_cast<double>(Sum(filter)) / count;
+}
+
+bool Column::Min(WordUnit &result, const BitVector* filter) const {
+	assert(nullptr == filter || num_tuples_ == filter->num());
+	const std::shared_ptr<const ColumnVersion> version = std::atomic_load(&version_);
+	bool found = false;
+	WordUnit min_value = std::numeric_limits<WordUnit>::max();
+
+#pragma omp parallel for schedule(dynamic) reduction(||:found) reduction(min:min_value)
+	for (size_t block_id = 0; block_id < version->blocks.size(); block_id++) {
+		std::vector<WordUnit> updated;
+		AggregateWithDelta(*version, block_id, filter, updated,
+				[&](const ColumnBlock* block, const BitVectorBlock* bvblock) {
+			WordUnit value;
+			if (block->Min(bvblock, value)) {
+				min_value = std::min(min_value, value);
+				found = true;
+			}
+		});
+		for (WordUnit value : updated) {
+			min_value = std::min(min_value, value);
+			found = true;
+		}
+	}
+	if (found) {
+		result = min_value;
+	}
+	return found;
+}
+
+bool Column::Max(WordUnit &result, const BitVector* filter) const {
+	assert(nullptr == filter || num_tuples_ == filter->num());
+	const std::shared_ptr<const ColumnVersion> version = std::atomic_load(&version_);
+	bool found = false;
+	WordUnit max_value = 0;
+
+#pragma omp parallel for schedule(dynamic) reduction(||:found) reduction(max:max_value)
+	for (size_t block_id = 0; block_id < version->blocks.size(); block_id++) {
+		std::vector<WordUnit> updated;
+		AggregateWithDelta(*version, block_id, filter, updated,
+				[&](const ColumnBlock* block, const BitVectorBlock* bvblock) {
+			WordUnit value;
+			if (block->Max(bvblock, value)) {
+				max_value = std::max(max_value, value);
+				found = true;
+			}
+		});
+		for (WordUnit value : updated) {
+			max_value = std::max(max_value, value);
+			found = true;
+		}
+	}
+	if (found) {
+		result = max_value;
+	}
+	return found;
+}
+
+std::vector<WordUnit> Column::TopK(size_t k, bool largest, const BitVector* filter) const {
+	assert(nullptr == filter || num_tuples_ == filter->num());
+	const std::shared_ptr<const ColumnVersion> version = std::atomic_load(&version_);
+	//every block contributes its own top k and its updated values, merged afterwards
+	std::vector<std::vector<WordUnit>> partial(version->blocks.size());
+
 #pragma omp parallel for schedule(dynamic)
-	for (size_t block_id = 0; block_id < blocks_.size(); block_id++) {
-		blocks_[block_id]->Scan(comparator, other_column->blocks_[block_id],
-				bitvector->GetBVBlock(block_id), bit_opt);
+	for (size_t block_id = 0; block_id < version->blocks.size(); block_id++) {
+		std::vector<WordUnit> updated;
+		AggregateWithDelta(*version, block_id, filter, updated,
+				[&](const ColumnBlock* block, const BitVectorBlock* bvblock) {
+			block->TopK(bvblock, k, largest, partial[block_id]);
+		});
+		partial[block_id].insert(partial[block_id].end(), updated.begin(), updated.end());
+	}
+
+	std::vector<WordUnit> result;
+	for (const auto &values : partial) {
+		result.insert(result.end(), values.begin(), values.end());
+	}
+	k = std::min(k, result.size());
+	if (largest) {
+		std::partial_sort(result.begin(), result.begin() + k, result.end(),
+				std::greater<WordUnit>());
+	} else {
+		std::partial_sort(result.begin(), result.begin() + k, result.end());
+	}
+	result.resize(k);
+	return result;
+}
+
+bool Column::Quantile(double fraction, WordUnit &result, const BitVector* filter) const {
+	assert(nullptr == filter || num_tuples_ == filter->num());
+	const size_t count = Count(filter);
+	if (0 == count) {
+		return false;
 	}
+	fraction = std::min(1.0, std::max(0.0, fraction));
+	size_t rank = std::min(count - 1, static_cast<size_t>(fraction * (count - 1)));
+
+	//digits follow the blocks' bit width, which may exceed the column's
+	const std::shared_ptr<const ColumnVersion> version = std::atomic_load(&version_);
+	const size_t block_bit_width = version->blocks[0]->bit_width();
+	const size_t num_bytes = CEIL(block_bit_width, 8);
+	const size_t num_padding_bits = num_bytes * 8 - block_bit_width;
+	WordUnit prefix = 0;
+	for (size_t byte_id = 0; byte_id < num_bytes; byte_id++) {
+		size_t histogram[256] = {0};
+		const size_t digit_shift = 8 * (num_bytes - 1 - byte_id);
+
+#pragma omp parallel for schedule(dynamic) reduction(+:histogram[:256])
+		for (size_t block_id = 0; block_id < version->blocks.size(); block_id++) {
+			std::vector<WordUnit> updated;
+			AggregateWithDelta(*version, block_id, filter, updated,
+					[&](const ColumnBlock* block, const BitVectorBlock* bvblock) {
+				block->RadixHistogram(bvblock, byte_id, prefix, histogram);
+			});
+			//as RadixHistogram reads the digits of a value
+			for (WordUnit value : updated) {
+				const WordUnit code = value << num_padding_bits;
+				if (((code >> digit_shift) >> 8) == prefix) {
+					histogram[(code >> digit_shift) & 0xFF]++;
+				}
+			}
+		}
+
+		//the bucket holding the rank becomes the next digit
+		size_t digit = 0;
+		while (rank >= histogram[digit]) {
+			rank -= histogram[digit];
+			digit++;
+		}
+		assert(digit < 256);
+		prefix = (prefix << 8) | digit;
+	}
+	result = prefix >> (num_bytes * 8 - block_bit_width);
+	return true;
+}
 
+bool Column::Median(WordUnit &result, const BitVector* filter) const {
+	return Quantile(0.5, result, filter);
 }
 
-ColumnBlock* Column::CreateNewBlock() const {
+ColumnBlock* Column::CreateNewBlock(size_t node) const {
 	assert(0 < bit_width_ && 32 >= bit_width_);
 	if (!(0 < bit_width_ && 32 >= bit_width_)) {
 		std::cerr << "[FATAL] Incorrect bit width: " << bit_width_ << std::endl;
@@ -165,80 +1507,80 @@ ColumnBlock* Column::CreateNewBlock() const {
 	case ColumnType::kNaive:
 		switch (CEIL(bit_width_, 8)) {
 		case 1:
-			return new NaiveColumnBlock<uint8_t>();
+			return new NaiveColumnBlock<uint8_t>(kNumTuplesPerBlock, node);
 		case 2:
-			return new NaiveColumnBlock<uint16_t>();
+			return new NaiveColumnBlock<uint16_t>(kNumTuplesPerBlock, node);
 		case 3:
 		case 4:
-			return new NaiveColumnBlock<uint32_t>();
+			return new NaiveColumnBlock<uint32_t>(kNumTuplesPerBlock, node);
 		}
 		break;
 	case ColumnType::kByteSlicePadRight:
 		switch (bit_width_) {
 		case 1:
-			return new ByteSliceColumnBlock<1>();
+			return new ByteSliceColumnBlock<1>(kNumTuplesPerBlock, node);
 		case 2:
-			return new ByteSliceColumnBlock<2>();
+			return new ByteSliceColumnBlock<2>(kNumTuplesPerBlock, node);
 		case 3:
-			return new ByteSliceColumnBlock<3>();
+			return new ByteSliceColumnBlock<3>(kNumTuplesPerBlock, node);
 		case 4:
-			return new ByteSliceColumnBlock<4>();
+			return new ByteSliceColumnBlock<4>(kNumTuplesPerBlock, node);
 		case 5:
-			return new ByteSliceColumnBlock<5>();
+			return new ByteSliceColumnBlock<5>(kNumTuplesPerBlock, node);
 		case 6:
-			return new ByteSliceColumnBlock<6>();
+			return new ByteSliceColumnBlock<6>(kNumTuplesPerBlock, node);
 		case 7:
-			return new ByteSliceColumnBlock<7>();
+			return new ByteSliceColumnBlock<7>(kNumTuplesPerBlock, node);
 		case 8:
-			return new ByteSliceColumnBlock<8>();
+			return new ByteSliceColumnBlock<8>(kNumTuplesPerBlock, node);
 		case 9:
-			return new ByteSliceColumnBlock<9>();
+			return new ByteSliceColumnBlock<9>(kNumTuplesPerBlock, node);
 		case 10:
-			return new ByteSliceColumnBlock<10>();
+			return new ByteSliceColumnBlock<10>(kNumTuplesPerBlock, node);
 		case 11:
-			return new ByteSliceColumnBlock<11>();
+			return new ByteSliceColumnBlock<11>(kNumTuplesPerBlock, node);
 		case 12:
-			return new ByteSliceColumnBlock<12>();
+			return new ByteSliceColumnBlock<12>(kNumTuplesPerBlock, node);
 		case 13:
-			return new ByteSliceColumnBlock<13>();
+			return new ByteSliceColumnBlock<13>(kNumTuplesPerBlock, node);
 		case 14:
-			return new ByteSliceColumnBlock<14>();
+			return new ByteSliceColumnBlock<14>(kNumTuplesPerBlock, node);
 		case 15:
-			return new ByteSliceColumnBlock<15>();
+			return new ByteSliceColumnBlock<15>(kNumTuplesPerBlock, node);
 		case 16:
-			return new ByteSliceColumnBlock<16>();
+			return new ByteSliceColumnBlock<16>(kNumTuplesPerBlock, node);
 		case 17:
-			return new ByteSliceColumnBlock<17>();
+			return new ByteSliceColumnBlock<17>(kNumTuplesPerBlock, node);
 		case 18:
-			return new ByteSliceColumnBlock<18>();
+			return new ByteSliceColumnBlock<18>(kNumTuplesPerBlock, node);
 		case 19:
-			return new ByteSliceColumnBlock<19>();
+			return new ByteSliceColumnBlock<19>(kNumTuplesPerBlock, node);
 		case 20:
-			return new ByteSliceColumnBlock<20>();
+			return new ByteSliceColumnBlock<20>(kNumTuplesPerBlock, node);
 		case 21:
-			return new ByteSliceColumnBlock<21>();
+			return new ByteSliceColumnBlock<21>(kNumTuplesPerBlock, node);
 		case 22:
-			return new ByteSliceColumnBlock<22>();
+			return new ByteSliceColumnBlock<22>(kNumTuplesPerBlock, node);
 		case 23:
-			return new ByteSliceColumnBlock<23>();
+			return new ByteSliceColumnBlock<23>(kNumTuplesPerBlock, node);
 		case 24:
-			return new ByteSliceColumnBlock<24>();
+			return new ByteSliceColumnBlock<24>(kNumTuplesPerBlock, node);
 		case 25:
-			return new ByteSliceColumnBlock<25>();
+			return new ByteSliceColumnBlock<25>(kNumTuplesPerBlock, node);
 		case 26:
-			return new ByteSliceColumnBlock<26>();
+			return new ByteSliceColumnBlock<26>(kNumTuplesPerBlock, node);
 		case 27:
-			return new ByteSliceColumnBlock<27>();
+			return new ByteSliceColumnBlock<27>(kNumTuplesPerBlock, node);
 		case 28:
-			return new ByteSliceColumnBlock<28>();
+			return new ByteSliceColumnBlock<28>(kNumTuplesPerBlock, node);
 		case 29:
-			return new ByteSliceColumnBlock<29>();
+			return new ByteSliceColumnBlock<29>(kNumTuplesPerBlock, node);
 		case 30:
-			return new ByteSliceColumnBlock<30>();
+			return new ByteSliceColumnBlock<30>(kNumTuplesPerBlock, node);
 		case 31:
-			return new ByteSliceColumnBlock<31>();
+			return new ByteSliceColumnBlock<31>(kNumTuplesPerBlock, node);
 		case 32:
-			return new ByteSliceColumnBlock<32>();
+			return new ByteSliceColumnBlock<32>(kNumTuplesPerBlock, node);
 		}
 		break;
 	default:
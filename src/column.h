@@ -10,7 +10,12 @@
 #define COLUMN_H
 
 
+#include    <atomic>
+#include    <cstdint>
+#include    <memory>
+#include    <mutex>
 #include    <string>
+#include    <utility>
 #include    <vector>
 
 #include 	"bitvector.h"
@@ -22,6 +27,40 @@
 namespace byteslice{
 
 class BitVector;
+class Column;
+class ColumnSnapshot;
+class CompressedBitVector;
+
+//Updates of a block that are not merged yet: (position in block, new value),
+//ordered by position; a table has one (possibly null) entry per block
+typedef std::vector<std::pair<size_t, WordUnit>> BlockDelta;
+typedef std::vector<std::shared_ptr<const BlockDelta>> DeltaTable;
+
+//What scans and snapshots work on: the blocks, shared so that a block
+//replaced by Column::Merge lives on while in use, and the pending updates
+struct ColumnVersion{
+    std::vector<std::shared_ptr<ColumnBlock>> blocks;
+    std::shared_ptr<const DeltaTable> deltas;
+};
+
+/**
+ * @brief One predicate of a conjunction: value (comparator) literal.
+ */
+struct ScanTerm{
+    const Column* column;
+    Comparator comparator;
+    WordUnit literal;
+};
+
+/**
+ * @brief Paging hints for a mapped column file.
+ */
+enum class MapHint{
+    kNone,      //fault pages in on first use
+    kPopulate,  //read the whole file during mapping (MAP_POPULATE)
+    kWillNeed,  //start reading the whole file in the background
+    kRandom     //no read-ahead, for selective access
+};
 
 class Column{
 public:
@@ -33,26 +72,172 @@ public:
     void SetTuple(size_t id, WordUnit value);
     void Resize(size_t num);
 
+    /**
+     * @brief Ingestion alongside queries. Append adds num values after the
+     * last tuple, filling the tail block and adding blocks as needed, and
+     * then publishes them; it returns the id of the first one. Appends are
+     * serialized among themselves only. A snapshot sees the tuples published
+     * when it was taken, however many are appended later; scans through it
+     * take no locks and never see partly written tuples or blocks.
+     * Other methods (Resize, SetTuple, Column::Scan...) are not safe
+     * alongside Append. Snapshots may outlive an unmapped column.
+     */
+    size_t Append(const WordUnit* codes, size_t num);
+    ColumnSnapshot Snapshot() const;
+
+    /**
+     * @brief Updates that leave the byte slices alone: new values go to a
+     * per-block delta that scans, aggregates, GetTuple, snapshots,
+     * SerToFile and SaveToFile apply on top of the blocks. Merge folds the
+     * deltas into copies of the updated blocks in bulk and swaps the copies
+     * in. Scans, aggregates, snapshots and file writes keep the blocks and
+     * updates current when they started, so they may run alongside Update
+     * and Merge (e.g. a background merge); GetTuple may not. SetTuple and
+     * the loads overwrite pending updates of the tuples they write. Update,
+     * Append and Merge are serialized; batches are cheaper than single calls.
+     */
+    void Update(size_t id, WordUnit value);
+    void Update(const size_t* ids, const WordUnit* values, size_t num);
+    size_t GetNumPendingUpdates() const;
+    void Merge();
+
     void SerToFile(SequentialWriteBinaryFile &file) const;
     void DeserFromFile(const SequentialReadBinaryFile &file);
 
+    /**
+     * @brief Zero-copy alternative to DeserFromFile: map a file written by
+     * SerToFile (the column starting at offset) and let the blocks use the
+     * mapping in place. Startup costs no copy, and processes mapping the
+     * same file share its page cache. The column becomes read-only until
+     * destroyed; hint tells the kernel how the file will be read.
+     */
+    bool MapFile(const std::string &filename, MapHint hint = MapHint::kNone,
+            size_t offset = 0);
+
+    /**
+     * @brief Self-describing column file (kColumnFileVersion):
+     * a header with magic, version, type, bit width, tuple and block counts,
+     * the block records of SerToFile (back to back, their data 64-byte
+     * aligned and trimmed to the tuples of each block), then a directory
+     * of record offsets and lengths.
+     * With Compression::kAuto, byte slices are stored with the cheapest
+     * codec of slice_codec.h; such files load but cannot be mapped.
+     * LoadFromFile and MapFromFile create a column of the stored schema
+     * (NULL on error); LoadBlockFromFile reads one block of such a file
+     * into this column, which must have the same schema.
+     */
+    bool SaveToFile(const std::string &filename,
+            Compression compression = Compression::kNone) const;
+    static Column* LoadFromFile(const std::string &filename);
+    static Column* MapFromFile(const std::string &filename, MapHint hint = MapHint::kNone);
+    bool LoadBlockFromFile(const std::string &filename, size_t block_id);
+
+    /**
+     * @brief Streaming scan of an uncompressed column file: the column is
+     * never resident. Up to depth blocks are read ahead by as many reader
+     * threads (O_DIRECT into aligned buffers where the file system allows)
+     * while the earliest one is scanned in place, so the scan runs at the
+     * speed of the disk rather than load time plus scan time. bitvector
+     * must be sized for the stored column. False on I/O or format errors.
+     */
+    static bool ScanFile(const std::string &filename, Comparator comparator,
+            WordUnit literal, BitVector* bitvector, Bitwise bit_opt = Bitwise::kSet,
+            size_t depth = 4);
+
     /**
      * @brief Load the column from a projection file in text format.
-     * One integer per line.
+     * One integer per line (any non-digit separates values).
+     * The file is memory-mapped; pieces of it are counted and parsed,
+     * and blocks filled, by parallel threads.
+     * Returns the number of values loaded.
      */
     size_t LoadTextFile(std::string filepath);
 
     /**
-     * @brief Load the column from a C-array.
+     * @brief Load the column from a C-array. Blocks are loaded in parallel.
      */
     void BulkLoadArray(const WordUnit* codes, size_t num, size_t pos=0);
 
+    /**
+     * @brief Build imprints in every block that supports them (ByteSlice).
+     * They are maintained by later loads and updates. Blocks added by a
+     * later Resize() start without imprints.
+     */
+    void BuildImprints();
+
     void Scan(Comparator comparator, WordUnit literal,
             BitVector* bitvector, Bitwise bit_opt = Bitwise::kSet) const;
     void Scan(Comparator comparator, const Column* other_column, 
             BitVector* bitvector, Bitwise bit_opt = Bitwise::kSet) const;
+    /**
+     * @brief Scan into a compressed bit vector, for selective predicates.
+     * Blocks settled by their zone maps only touch the containers; others
+     * are scanned into a dense block buffer that is then compressed.
+     */
+    void Scan(Comparator comparator, WordUnit literal,
+            CompressedBitVector* bitvector, Bitwise bit_opt = Bitwise::kSet) const;
 
-    ColumnBlock* CreateNewBlock() const;
+    /**
+     * @brief Range predicate lower <= value <= upper, evaluated in one pass.
+     */
+    void ScanBetween(WordUnit lower, WordUnit upper,
+            BitVector* bitvector, Bitwise bit_opt = Bitwise::kSet) const;
+
+    /**
+     * @brief Set membership predicate value IN (values...).
+     * The column is read once regardless of the number of values.
+     */
+    void ScanIn(const WordUnit* values, size_t num_values,
+            BitVector* bitvector, Bitwise bit_opt = Bitwise::kSet) const;
+
+    /**
+     * @brief Scan into position lists (row ids) instead of a bit vector.
+     * Block b writes the ids of its matches, in order, starting at
+     * positions[b * kNumTuplesPerBlock]; positions must hold
+     * GetNumTuples() entries. Returns the number of matches per block,
+     * e.g. to prefix-sum them into a dense list.
+     */
+    std::vector<size_t> ScanToPositions(Comparator comparator, WordUnit literal,
+            uint32_t* positions) const;
+    std::vector<size_t> ScanToPositions(Comparator comparator, WordUnit literal,
+            uint64_t* positions) const;
+
+    /**
+     * @brief Aggregates over the tuples whose bit is set in filter,
+     * or over all tuples if filter is NULL. ByteSlice columns sum
+     * byte slices without reassembling values.
+     */
+    WordUnit Sum(const BitVector* filter = nullptr) const;
+    size_t Count(const BitVector* filter = nullptr) const;
+    double Avg(const BitVector* filter = nullptr) const;
+
+    /**
+     * @brief MIN/MAX over the same tuples as Sum(); false if none qualifies.
+     * ByteSlice blocks settle one byte slice at a time, narrowing the
+     * candidate lanes, so lower slices are mostly left unread.
+     * Blocks are processed in parallel and their results merged.
+     */
+    bool Min(WordUnit &result, const BitVector* filter = nullptr) const;
+    bool Max(WordUnit &result, const BitVector* filter = nullptr) const;
+    /**
+     * @brief The k smallest (or largest) qualifying values, in order.
+     */
+    std::vector<WordUnit> TopK(size_t k, bool largest = false,
+            const BitVector* filter = nullptr) const;
+
+    /**
+     * @brief The qualifying value of rank floor(fraction * (count - 1))
+     * in ascending order, i.e. what nth_element would place there;
+     * false if no tuple qualifies. Radix selection: one 256-bucket
+     * histogram per byte slice, built across blocks in parallel, picks
+     * the next byte of the answer. Values are never materialized.
+     */
+    bool Quantile(double fraction, WordUnit &result,
+            const BitVector* filter = nullptr) const;
+    bool Median(WordUnit &result, const BitVector* filter = nullptr) const;
+
+    //with its data on a NUMA node (see numa_placement.h)
+    ColumnBlock* CreateNewBlock(size_t node = kAnyNode) const;
 
     size_t GetNumTuples() const { return num_tuples_;}
     size_t GetBitWidth() const { return bit_width_;}
@@ -61,12 +246,71 @@ public:
     ColumnBlock* GetBlock(size_t block_id) const {return blocks_[block_id];}
 
 private:
+    friend void ScanConjunction(const std::vector<ScanTerm> &terms, BitVector* bitvector,
+            Bitwise bit_opt);
+
+    template <typename T>
+    std::vector<size_t> ScanToPositionsHelper(Comparator comparator, WordUnit literal,
+            T* positions) const;
+
+    //make blocks_, deltas_ and num_tuples_ visible to scans and snapshots
+    void Publish();
+    //forget pending updates, when the blocks get new contents
+    void DiscardUpdates();
+    //forget pending updates of tuples [begin, end), which got new values
+    void DropUpdates(size_t begin, size_t end);
+
     ColumnType type_;
     size_t bit_width_;
     size_t num_tuples_;
     std::vector<ColumnBlock*> blocks_;
+    //owners of blocks_, shared with versions
+    std::vector<std::shared_ptr<ColumnBlock>> block_owners_;
+    //pending updates, replaced as a whole by Update and Merge
+    std::shared_ptr<const DeltaTable> deltas_;
+    std::atomic<size_t> num_deltas_{0};
+    //what scans and snapshots see, and the number of tuples, stored after it
+    std::shared_ptr<const ColumnVersion> version_;
+    std::atomic<size_t> num_published_{0};
+    std::mutex write_mutex_;
+    //file mapping used by the blocks, if any
+    void* mapping_ = nullptr;
+    size_t mapping_size_ = 0;
+};
+
+/**
+ * @brief Read-only view of the first GetNumTuples() tuples of a column
+ * and of its updates at the time, see Column::Append. Cheap to copy.
+ */
+class ColumnSnapshot{
+public:
+    size_t GetNumTuples() const { return num_tuples_;}
+    size_t GetNumBlocks() const {
+        return (num_tuples_ + kNumTuplesPerBlock - 1) / kNumTuplesPerBlock;
+    }
+    WordUnit GetTuple(size_t id) const;
+    //bitvector must hold GetNumTuples() bits
+    void Scan(Comparator comparator, WordUnit literal,
+            BitVector* bitvector, Bitwise bit_opt = Bitwise::kSet) const;
+
+private:
+    friend class Column;
+    ColumnSnapshot(std::shared_ptr<const ColumnVersion> version, size_t num_tuples);
+
+    std::shared_ptr<const ColumnVersion> version_;
+    size_t num_tuples_;
 };
 
+/**
+ * @brief Conjunction of predicates over columns of the same length,
+ * e.g. a < 5 AND b > 7 AND c = 3, evaluated in one pass.
+ * The bit vector of a few thousand tuples stays in L1 across all terms;
+ * a term only looks at tuples that are still alive after the previous ones,
+ * and the result is written once. Put the most selective term first.
+ */
+void ScanConjunction(const std::vector<ScanTerm> &terms, BitVector* bitvector,
+        Bitwise bit_opt = Bitwise::kSet);
+
 
 }   // namespace
 
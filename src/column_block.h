@@ -9,14 +9,26 @@
 #ifndef     COLUMN_BLOCK_H
 #define     COLUMN_BLOCK_H
 
+#include    <cstring>
+#include    <vector>
+
 #include "../src/bitvector_block.h"
+#include "../src/early_stop.h"
 #include "../src/macros.h"
+#include "../src/numa_placement.h"
 #include "../src/param.h"
 #include "../src/sequential_binary_file.h"
 #include "../src/types.h"
 
 namespace byteslice{
 
+//What the zone map tells about a predicate on a whole block
+enum class BlockMatch{
+    kNone,      //no tuple qualifies
+    kAll,       //every tuple qualifies
+    kSome       //undecided, the block has to be scanned
+};
+
 class ColumnBlock{
 public:
     virtual ~ColumnBlock(){
@@ -26,25 +38,90 @@ public:
     virtual void SetTuple(size_t pos_in_block, WordUnit value) = 0;
     virtual void Scan(Comparator comparator, WordUnit literal, BitVectorBlock* bv_block, Bitwise bit_opt=Bitwise::kSet) const = 0;
     virtual void Scan(Comparator comparator, const ColumnBlock* column_block, BitVectorBlock* bv_block, Bitwise bit_opti=Bitwise::kSet) const = 0;
+    //lower <= value <= upper, in one pass
+    virtual void ScanBetween(WordUnit lower, WordUnit upper, BitVectorBlock* bv_block, Bitwise bit_opt=Bitwise::kSet) const = 0;
+    //value IN (values[0], ..., values[num_values-1]), in one pass
+    virtual void ScanIn(const WordUnit* values, size_t num_values, BitVectorBlock* bv_block, Bitwise bit_opt=Bitwise::kSet) const = 0;
+    //words[w] &= (value cmp literal) for the 64 tuples of bit vector word (begin_word + w);
+    //words that are already zero are not evaluated. Calls on the pieces of one
+    //scan share early_stop (see early_stop.h); NULL for a call on its own.
+    virtual void FilterWords(Comparator comparator, WordUnit literal, WordUnit* words, size_t begin_word, size_t num_words, EarlyStopState* early_stop = nullptr) const = 0;
+    //sum of the values whose bit is set in filter (all values if filter is NULL)
+    virtual WordUnit Sum(const BitVectorBlock* filter) const = 0;
+    //smallest/largest value whose bit is set in filter (all values if filter is NULL);
+    //false if there is none
+    virtual bool Min(const BitVectorBlock* filter, WordUnit &result) const = 0;
+    virtual bool Max(const BitVectorBlock* filter, WordUnit &result) const = 0;
+    //the k smallest (or largest) such values, in order; fewer if fewer qualify
+    virtual void TopK(const BitVectorBlock* filter, size_t k, bool largest,
+            std::vector<WordUnit> &result) const = 0;
+    //Radix selection: a value is read as CEIL(bit_width, 8) digits of 8 bits,
+    //most significant first, after shifting it left to a byte boundary.
+    //Counts into histogram[d] the tuples in filter whose first byte_id digits
+    //form prefix and whose digit byte_id is d.
+    virtual void RadixHistogram(const BitVectorBlock* filter, size_t byte_id,
+            WordUnit prefix, size_t* histogram) const = 0;
     virtual void BulkLoadArray(const WordUnit* codes, size_t num, size_t start_pos=0) = 0;
-    virtual void SerToFile(SequentialWriteBinaryFile &file) const = 0;
+    //compression is a request; blocks without codecs write plain records
+    virtual void SerToFile(SequentialWriteBinaryFile &file,
+            Compression compression = Compression::kNone) const = 0;
     virtual void DeserFromFile(const SequentialReadBinaryFile &file) = 0;
+    //Records hold the data of num_tuples() tuples only (see SerHeader).
+    //Zero-copy counterpart of DeserFromFile: point the block at the record
+    //starting at offset in a buffer (a file mapping) of size bytes written by
+    //SerToFile, and advance offset past it. The buffer must outlive the
+    //block, which becomes read-only. False if the record does not fit.
+    virtual bool MapFromBuffer(const char* buffer, size_t size, size_t &offset) = 0;
+    //Deep copy that owns its data, also when this block is mapped, with the
+    //data on a NUMA node (see numa_placement.h)
+    virtual ColumnBlock* Clone(size_t node) const = 0;
+    //block records start at multiples of this in a file
+    static constexpr size_t kRecordAlignment = 64;
+    //Tuples added by growing read as 0, and the zone map widens to cover them
     virtual bool Resize(size_t size) = 0;
+    //Build an optional in-block index; blocks without one ignore this
+    virtual void BuildImprints(){
+    }
 
     //accessors
     ColumnType type() const;
     size_t bit_width() const;
     size_t num_tuples() const;
+    bool mapped() const;
+
+    //Zone map: every tuple value lies in [min_value(), max_value()].
+    //A load of the whole block sets the exact bounds; other updates only
+    //widen them, so they may be loose but never wrong.
+    WordUnit min_value() const;
+    WordUnit max_value() const;
+    BlockMatch Match(Comparator comparator, WordUnit literal) const;
+    BlockMatch MatchBetween(WordUnit lower, WordUnit upper) const;
 
 
 protected:
+    //Storage starts zeroed, so [0, 0] holds until the block is loaded
     ColumnBlock(ColumnType type, size_t bit_width, size_t num):
-        type_(type), bit_width_(bit_width), num_tuples_(num){
+        type_(type), bit_width_(bit_width), num_tuples_(num),
+        min_value_(0), max_value_(0), mapped_(false){
     }
+    void SetZoneMap(WordUnit min_value, WordUnit max_value);
+    void ExtendZoneMap(WordUnit min_value, WordUnit max_value);
+    //values as stored: truncated to the bit width
+    WordUnit CodeMask() const;
+    //Block records: header, then data aligned for SIMD loads and mappings
+    void SerHeader(SequentialWriteBinaryFile &file,
+            Compression compression = Compression::kNone) const;
+    Compression DeserHeader(const SequentialReadBinaryFile &file);
+    bool MapHeader(const char* buffer, size_t size, size_t &offset);
+    //size rounded up to kRecordAlignment, for data trimmed to num_tuples_
+    static size_t AlignedSize(size_t size);
+
     const ColumnType type_;
     const size_t bit_width_;
     size_t num_tuples_;
-    
+    WordUnit min_value_;
+    WordUnit max_value_;
+    bool mapped_;   //data lives in a buffer the block does not own
 
 };
 
@@ -60,6 +137,121 @@ inline size_t ColumnBlock::num_tuples() const{
     return num_tuples_;
 }
 
+inline bool ColumnBlock::mapped() const{
+    return mapped_;
+}
+
+inline WordUnit ColumnBlock::min_value() const{
+    return min_value_;
+}
+
+inline WordUnit ColumnBlock::max_value() const{
+    return max_value_;
+}
+
+inline WordUnit ColumnBlock::CodeMask() const{
+    return bit_width_ >= 64 ? -1ULL : (1ULL << bit_width_) - 1;
+}
+
+inline size_t ColumnBlock::AlignedSize(size_t size){
+    return (size + kRecordAlignment - 1) / kRecordAlignment * kRecordAlignment;
+}
+
+//num_tuples, the zone map and the compression of the data, then padding
+inline void ColumnBlock::SerHeader(SequentialWriteBinaryFile &file,
+                                    Compression compression) const{
+    const uint64_t encoding = static_cast<uint64_t>(compression);
+    file.Append(&num_tuples_, sizeof(num_tuples_));
+    file.Append(&min_value_, sizeof(min_value_));
+    file.Append(&max_value_, sizeof(max_value_));
+    file.Append(&encoding, sizeof(encoding));
+    file.Align(kRecordAlignment);
+}
+
+inline Compression ColumnBlock::DeserHeader(const SequentialReadBinaryFile &file){
+    uint64_t encoding = 0;
+    file.Read(&num_tuples_, sizeof(num_tuples_));
+    file.Read(&min_value_, sizeof(min_value_));
+    file.Read(&max_value_, sizeof(max_value_));
+    file.Read(&encoding, sizeof(encoding));
+    file.Align(kRecordAlignment);
+    return static_cast<Compression>(encoding);
+}
+
+//Compressed records cannot be used in place
+inline bool ColumnBlock::MapHeader(const char* buffer, size_t size, size_t &offset){
+    uint64_t encoding = 0;
+    const size_t header_size = sizeof(num_tuples_) + sizeof(min_value_) +
+                                sizeof(max_value_) + sizeof(encoding);
+    if(offset + header_size > size){
+        return false;
+    }
+    const char* p = buffer + offset;
+    memcpy(&num_tuples_, p, sizeof(num_tuples_));
+    p += sizeof(num_tuples_);
+    memcpy(&min_value_, p, sizeof(min_value_));
+    p += sizeof(min_value_);
+    memcpy(&max_value_, p, sizeof(max_value_));
+    p += sizeof(max_value_);
+    memcpy(&encoding, p, sizeof(encoding));
+    offset = AlignedSize(offset + header_size);
+    return static_cast<uint64_t>(Compression::kNone) == encoding;
+}
+
+inline void ColumnBlock::SetZoneMap(WordUnit min_value, WordUnit max_value){
+    min_value_ = min_value;
+    max_value_ = max_value;
+}
+
+inline void ColumnBlock::ExtendZoneMap(WordUnit min_value, WordUnit max_value){
+    if(min_value < min_value_){
+        min_value_ = min_value;
+    }
+    if(max_value > max_value_){
+        max_value_ = max_value;
+    }
+}
+
+//The literal is truncated to the bit width, as the scans do
+inline BlockMatch ColumnBlock::Match(Comparator comparator, WordUnit literal) const{
+    literal &= CodeMask();
+    switch(comparator){
+        case Comparator::kLess:
+            return max_value_ < literal ? BlockMatch::kAll :
+                (min_value_ >= literal ? BlockMatch::kNone : BlockMatch::kSome);
+        case Comparator::kLessEqual:
+            return max_value_ <= literal ? BlockMatch::kAll :
+                (min_value_ > literal ? BlockMatch::kNone : BlockMatch::kSome);
+        case Comparator::kGreater:
+            return min_value_ > literal ? BlockMatch::kAll :
+                (max_value_ <= literal ? BlockMatch::kNone : BlockMatch::kSome);
+        case Comparator::kGreaterEqual:
+            return min_value_ >= literal ? BlockMatch::kAll :
+                (max_value_ < literal ? BlockMatch::kNone : BlockMatch::kSome);
+        case Comparator::kEqual:
+            if(literal < min_value_ || literal > max_value_){
+                return BlockMatch::kNone;
+            }
+            return min_value_ == max_value_ ? BlockMatch::kAll : BlockMatch::kSome;
+        case Comparator::kInequal:
+            if(literal < min_value_ || literal > max_value_){
+                return BlockMatch::kAll;
+            }
+            return min_value_ == max_value_ ? BlockMatch::kNone : BlockMatch::kSome;
+    }
+    return BlockMatch::kSome;
+}
+
+inline BlockMatch ColumnBlock::MatchBetween(WordUnit lower, WordUnit upper) const{
+    if(lower > upper || upper < min_value_ || lower > max_value_){
+        return BlockMatch::kNone;
+    }
+    if(lower <= min_value_ && max_value_ <= upper){
+        return BlockMatch::kAll;
+    }
+    return BlockMatch::kSome;
+}
+
 }
 
 #endif  //COLUMN_BLOCK_H
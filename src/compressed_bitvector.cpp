@@ -0,0 +1,384 @@
+/*******************************************************************************
+ * Copyright (c) 2015
+ * The Hong Kong Polytechnic University, Database Group
+ *
+ * Author: Ziqiang Feng (cszqfeng AT comp DOT polyu.edu.hk)
+ *
+ * See file LICENSE.md for details.
+ *******************************************************************************/
+#include "compressed_bitvector.h"
+
+#include    <algorithm>
+#include    <cassert>
+#include    <cstring>
+#include    <iterator>
+
+#include "macros.h"
+
+namespace byteslice{
+
+constexpr size_t CompressedBitVector::kNumContainerBits;
+constexpr size_t CompressedBitVector::kNumContainerWords;
+constexpr size_t CompressedBitVector::kMaxArraySize;
+constexpr size_t CompressedBitVector::kNumContainersPerBlock;
+
+static_assert(0 == kNumTuplesPerBlock % CompressedBitVector::kNumContainerBits,
+        "containers must not straddle blocks");
+
+CompressedBitVector::CompressedBitVector(size_t num):
+    containers_((num + kNumContainerBits - 1) / kNumContainerBits),
+    num_(num){
+}
+
+CompressedBitVector::CompressedBitVector(const BitVector* bitvector):
+    CompressedBitVector(bitvector->num()){
+
+#   pragma omp parallel for schedule(dynamic)
+    for(size_t block_id=0; block_id < bitvector->GetNumBlocks(); block_id++){
+        SetBlock(block_id, bitvector->GetBVBlock(block_id));
+    }
+}
+
+size_t CompressedBitVector::NumContainerWords(size_t container_id) const{
+    const size_t num_bits = std::min(kNumContainerBits, num_ - container_id * kNumContainerBits);
+    return CEIL(num_bits, kNumWordBits);
+}
+
+//Picks the form of a container from its words
+void CompressedBitVector::Compress(size_t container_id, const WordUnit* words){
+    Container &container = containers_[container_id];
+    const size_t num_words = NumContainerWords(container_id);
+    size_t cardinality = 0;
+    for(size_t i=0; i < num_words; i++){
+        cardinality += POPCNT64(words[i]);
+    }
+    container.cardinality = cardinality;
+    container.array.clear();
+    container.bitmap.clear();
+    if(cardinality > kMaxArraySize){
+        container.bitmap.assign(words, words + num_words);
+        return;
+    }
+    container.array.reserve(cardinality);
+    for(size_t i=0; i < num_words; i++){
+        for(WordUnit word = words[i]; 0 != word; word &= word - 1){
+            container.array.push_back(i * kNumWordBits + __builtin_ctzll(word));
+        }
+    }
+}
+
+void CompressedBitVector::Expand(size_t container_id, WordUnit* words) const{
+    const Container &container = containers_[container_id];
+    const size_t num_words = NumContainerWords(container_id);
+    if(!container.bitmap.empty()){
+        memcpy(words, container.bitmap.data(), sizeof(WordUnit) * num_words);
+        return;
+    }
+    memset(words, 0, sizeof(WordUnit) * num_words);
+    for(uint16_t offset : container.array){
+        words[offset / kNumWordBits] |= 1ULL << (offset % kNumWordBits);
+    }
+}
+
+void CompressedBitVector::AndWords(size_t container_id, const WordUnit* words){
+    Container &container = containers_[container_id];
+    if(container.bitmap.empty()){
+        //only the ones of the array are looked up
+        std::vector<uint16_t> &array = container.array;
+        array.erase(std::remove_if(array.begin(), array.end(), [words](uint16_t offset){
+                    return 0 == ((words[offset / kNumWordBits] >> (offset % kNumWordBits)) & 1ULL);
+                    }), array.end());
+        container.cardinality = array.size();
+        return;
+    }
+    std::vector<WordUnit> bitmap;
+    bitmap.swap(container.bitmap);
+    for(size_t i=0; i < bitmap.size(); i++){
+        bitmap[i] &= words[i];
+    }
+    Compress(container_id, bitmap.data());
+}
+
+void CompressedBitVector::OrWords(size_t container_id, const WordUnit* words){
+    std::vector<WordUnit> bitmap(NumContainerWords(container_id));
+    Expand(container_id, bitmap.data());
+    for(size_t i=0; i < bitmap.size(); i++){
+        bitmap[i] |= words[i];
+    }
+    Compress(container_id, bitmap.data());
+}
+
+void CompressedBitVector::SetOnes(){
+    std::vector<WordUnit> ones(kNumContainerWords, -1ULL);
+    for(size_t c=0; c < containers_.size(); c++){
+        const size_t num_words = NumContainerWords(c);
+        const size_t num_bits = std::min(kNumContainerBits, num_ - c * kNumContainerBits);
+        if(0 != num_bits % kNumWordBits){
+            ones[num_words - 1] = (1ULL << (num_bits % kNumWordBits)) - 1;
+        }
+        Compress(c, ones.data());
+    }
+}
+
+void CompressedBitVector::SetZeros(){
+    for(Container &container : containers_){
+        container = Container();
+    }
+}
+
+size_t CompressedBitVector::CountOnes() const{
+    size_t count = 0;
+    for(const Container &container : containers_){
+        count += container.cardinality;
+    }
+    return count;
+}
+
+void CompressedBitVector::And(const CompressedBitVector* bitvector){
+    assert(num_ == bitvector->num_);
+
+#   pragma omp parallel for schedule(dynamic)
+    for(size_t c=0; c < containers_.size(); c++){
+        Container &container = containers_[c];
+        const Container &other = bitvector->containers_[c];
+        if(0 == container.cardinality || 0 == other.cardinality){
+            container = Container();
+        }
+        else if(!other.bitmap.empty()){
+            AndWords(c, other.bitmap.data());
+        }
+        else if(!container.bitmap.empty()){
+            //the result is at most as large as the other array
+            Container result;
+            for(uint16_t offset : other.array){
+                if((container.bitmap[offset / kNumWordBits] >> (offset % kNumWordBits)) & 1ULL){
+                    result.array.push_back(offset);
+                }
+            }
+            result.cardinality = result.array.size();
+            container = std::move(result);
+        }
+        else{
+            std::vector<uint16_t> result;
+            std::set_intersection(container.array.begin(), container.array.end(),
+                    other.array.begin(), other.array.end(), std::back_inserter(result));
+            container.array.swap(result);
+            container.cardinality = container.array.size();
+        }
+    }
+}
+
+void CompressedBitVector::Or(const CompressedBitVector* bitvector){
+    assert(num_ == bitvector->num_);
+
+#   pragma omp parallel for schedule(dynamic)
+    for(size_t c=0; c < containers_.size(); c++){
+        Container &container = containers_[c];
+        const Container &other = bitvector->containers_[c];
+        if(0 == other.cardinality){
+            continue;
+        }
+        if(0 == container.cardinality){
+            container = other;
+        }
+        else if(!other.bitmap.empty()){
+            OrWords(c, other.bitmap.data());
+        }
+        else if(!container.bitmap.empty()){
+            for(uint16_t offset : other.array){
+                WordUnit &word = container.bitmap[offset / kNumWordBits];
+                const WordUnit mask = 1ULL << (offset % kNumWordBits);
+                container.cardinality += 0 == (word & mask);
+                word |= mask;
+            }
+        }
+        else if(container.array.size() + other.array.size() <= kMaxArraySize){
+            std::vector<uint16_t> result;
+            std::set_union(container.array.begin(), container.array.end(),
+                    other.array.begin(), other.array.end(), std::back_inserter(result));
+            container.array.swap(result);
+            container.cardinality = container.array.size();
+        }
+        else{
+            //may or may not need a bitmap
+            std::vector<WordUnit> words(NumContainerWords(c));
+            bitvector->Expand(c, words.data());
+            OrWords(c, words.data());
+        }
+    }
+}
+
+void CompressedBitVector::And(const BitVector* bitvector){
+    assert(num_ == bitvector->num());
+
+#   pragma omp parallel for schedule(dynamic)
+    for(size_t c=0; c < containers_.size(); c++){
+        if(0 == containers_[c].cardinality){
+            continue;
+        }
+        const BitVectorBlock* bvblock = bitvector->GetBVBlock(c / kNumContainersPerBlock);
+        AndWords(c, bvblock->data() + c % kNumContainersPerBlock * kNumContainerWords);
+    }
+}
+
+void CompressedBitVector::Or(const BitVector* bitvector){
+    assert(num_ == bitvector->num());
+
+#   pragma omp parallel for schedule(dynamic)
+    for(size_t c=0; c < containers_.size(); c++){
+        const BitVectorBlock* bvblock = bitvector->GetBVBlock(c / kNumContainersPerBlock);
+        OrWords(c, bvblock->data() + c % kNumContainersPerBlock * kNumContainerWords);
+    }
+}
+
+bool CompressedBitVector::GetBit(size_t pos) const{
+    assert(pos < num_);
+    const Container &container = containers_[pos / kNumContainerBits];
+    const size_t offset = pos % kNumContainerBits;
+    if(!container.bitmap.empty()){
+        return (container.bitmap[offset / kNumWordBits] >> (offset % kNumWordBits)) & 1ULL;
+    }
+    return std::binary_search(container.array.begin(), container.array.end(), offset);
+}
+
+void CompressedBitVector::SetBit(size_t pos){
+    assert(pos < num_);
+    const size_t container_id = pos / kNumContainerBits;
+    Container &container = containers_[container_id];
+    const size_t offset = pos % kNumContainerBits;
+    if(!container.bitmap.empty()){
+        WordUnit &word = container.bitmap[offset / kNumWordBits];
+        const WordUnit mask = 1ULL << (offset % kNumWordBits);
+        container.cardinality += 0 == (word & mask);
+        word |= mask;
+        return;
+    }
+    auto it = std::lower_bound(container.array.begin(), container.array.end(), offset);
+    if(container.array.end() != it && offset == *it){
+        return;
+    }
+    container.array.insert(it, offset);
+    container.cardinality++;
+    if(container.cardinality > kMaxArraySize){
+        std::vector<WordUnit> words(NumContainerWords(container_id));
+        Expand(container_id, words.data());
+        Compress(container_id, words.data());
+    }
+}
+
+void CompressedBitVector::UnsetBit(size_t pos){
+    assert(pos < num_);
+    const size_t container_id = pos / kNumContainerBits;
+    Container &container = containers_[container_id];
+    const size_t offset = pos % kNumContainerBits;
+    if(!container.bitmap.empty()){
+        WordUnit &word = container.bitmap[offset / kNumWordBits];
+        const WordUnit mask = 1ULL << (offset % kNumWordBits);
+        container.cardinality -= 0 != (word & mask);
+        word &= ~mask;
+        if(container.cardinality <= kMaxArraySize){
+            std::vector<WordUnit> bitmap;
+            bitmap.swap(container.bitmap);
+            Compress(container_id, bitmap.data());
+        }
+        return;
+    }
+    auto it = std::lower_bound(container.array.begin(), container.array.end(), offset);
+    if(container.array.end() != it && offset == *it){
+        container.array.erase(it);
+        container.cardinality--;
+    }
+}
+
+void CompressedBitVector::ToBitVector(BitVector* bitvector) const{
+    assert(num_ == bitvector->num());
+
+#   pragma omp parallel for schedule(dynamic)
+    for(size_t block_id=0; block_id < bitvector->GetNumBlocks(); block_id++){
+        GetBlock(block_id, bitvector->GetBVBlock(block_id));
+    }
+}
+
+void CompressedBitVector::GetBlock(size_t block_id, BitVectorBlock* bvblock) const{
+    assert(std::min(kNumTuplesPerBlock, num_ - block_id * kNumTuplesPerBlock) == bvblock->num());
+    WordUnit* words = bvblock->data();
+    size_t num_words = 0;
+    const size_t first = block_id * kNumContainersPerBlock;
+    const size_t last = std::min(first + kNumContainersPerBlock, containers_.size());
+    for(size_t c = first; c < last; c++){
+        Expand(c, words + num_words);
+        num_words += NumContainerWords(c);
+    }
+    //padding words of the block
+    memset(words + num_words, 0, sizeof(WordUnit) * (bvblock->num_word_units() - num_words));
+    bvblock->UpdateSummary();
+}
+
+void CompressedBitVector::SetBlock(size_t block_id, const BitVectorBlock* bvblock){
+    assert(std::min(kNumTuplesPerBlock, num_ - block_id * kNumTuplesPerBlock) == bvblock->num());
+    const size_t first = block_id * kNumContainersPerBlock;
+    const size_t last = std::min(first + kNumContainersPerBlock, containers_.size());
+    for(size_t c = first; c < last; c++){
+        Compress(c, bvblock->data() + (c - first) * kNumContainerWords);
+    }
+}
+
+void CompressedBitVector::FillBlock(size_t block_id, bool bit){
+    const size_t first = block_id * kNumContainersPerBlock;
+    const size_t last = std::min(first + kNumContainersPerBlock, containers_.size());
+    std::vector<WordUnit> ones;
+    for(size_t c = first; c < last; c++){
+        if(!bit){
+            containers_[c] = Container();
+            continue;
+        }
+        const size_t num_bits = std::min(kNumContainerBits, num_ - c * kNumContainerBits);
+        ones.assign(NumContainerWords(c), -1ULL);
+        if(0 != num_bits % kNumWordBits){
+            ones.back() = (1ULL << (num_bits % kNumWordBits)) - 1;
+        }
+        Compress(c, ones.data());
+    }
+}
+
+size_t CompressedBitVector::GetPositions(size_t begin, uint64_t* positions,
+        size_t max_positions) const{
+    size_t count = 0;
+    for(size_t c = begin / kNumContainerBits; c < containers_.size() && count < max_positions; c++){
+        const Container &container = containers_[c];
+        const size_t base = c * kNumContainerBits;
+        const size_t from = begin > base ? begin - base : 0;
+        if(container.bitmap.empty()){
+            auto it = std::lower_bound(container.array.begin(), container.array.end(), from);
+            for(; container.array.end() != it && count < max_positions; ++it){
+                positions[count++] = base + *it;
+            }
+            continue;
+        }
+        for(size_t i = from / kNumWordBits; i < container.bitmap.size() && count < max_positions; i++){
+            WordUnit word = container.bitmap[i];
+            if(i == from / kNumWordBits){
+                word &= -1ULL << (from % kNumWordBits);
+            }
+            for(; 0 != word && count < max_positions; word &= word - 1){
+                positions[count++] = base + i * kNumWordBits + __builtin_ctzll(word);
+            }
+        }
+    }
+    return count;
+}
+
+size_t CompressedBitVector::GetMemorySize() const{
+    size_t size = sizeof(Container) * containers_.size();
+    for(const Container &container : containers_){
+        size += sizeof(uint16_t) * container.array.size()
+            + sizeof(WordUnit) * container.bitmap.size();
+    }
+    return size;
+}
+
+bool CompressedBitVector::IsDense() const{
+    return GetMemorySize() >= num_ / 8;
+}
+
+}   // namespace
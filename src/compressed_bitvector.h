@@ -0,0 +1,104 @@
+/*******************************************************************************
+ * Copyright (c) 2015
+ * The Hong Kong Polytechnic University, Database Group
+ *
+ * Author: Ziqiang Feng (cszqfeng AT comp DOT polyu.edu.hk)
+ *
+ * See file LICENSE.md for details.
+ *******************************************************************************/
+#ifndef COMPRESSED_BITVECTOR_H
+#define COMPRESSED_BITVECTOR_H
+
+#include    <cstdint>
+#include    <vector>
+
+#include "../src/bitvector.h"
+#include "../src/bitvector_block.h"
+#include "../src/param.h"
+#include "../src/types.h"
+
+namespace byteslice{
+
+/**
+  Roaring-style bit vector for sparse results.
+  Bits are grouped into containers of 64K bits. A container with at most
+  kMaxArraySize ones keeps their sorted 16-bit offsets (2 bytes per one),
+  a denser one keeps 1024 words; an empty container costs nothing.
+  Every operation picks the cheaper form for its result, so the memory
+  and the work of And/Or/CountOnes follow the number of ones rather than
+  the number of bits.
+  Containers never straddle column blocks: GetBlock/SetBlock convert one
+  block at a time to and from the dense BitVectorBlock that block scans
+  write (see Column::Scan).
+*/
+class CompressedBitVector{
+public:
+    static constexpr size_t kNumContainerBits = 1 << 16;
+    static constexpr size_t kNumContainerWords = kNumContainerBits / kNumWordBits;
+    //an array of this many offsets is as large as a bitmap
+    static constexpr size_t kMaxArraySize = kNumContainerBits / 16;
+    static constexpr size_t kNumContainersPerBlock = kNumTuplesPerBlock / kNumContainerBits;
+
+    //all zeros
+    CompressedBitVector(size_t num);
+    CompressedBitVector(const BitVector* bitvector);
+
+    void SetOnes();
+    void SetZeros();
+    size_t CountOnes() const;
+
+    //bitwise combination, with either form
+    void And(const CompressedBitVector* bitvector);
+    void Or(const CompressedBitVector* bitvector);
+    void And(const BitVector* bitvector);
+    void Or(const BitVector* bitvector);
+
+    //bit manipulation
+    bool GetBit(size_t pos) const;
+    void SetBit(size_t pos);
+    void UnsetBit(size_t pos);
+
+    //conversion: bitvector must have num() bits
+    void ToBitVector(BitVector* bitvector) const;
+    //one column block worth of bits; blocks can be converted in parallel
+    void GetBlock(size_t block_id, BitVectorBlock* bvblock) const;
+    void SetBlock(size_t block_id, const BitVectorBlock* bvblock);
+    void FillBlock(size_t block_id, bool bit);
+
+    //positions of the ones from begin on, at most max_positions of them,
+    //in increasing order; returns the number written
+    size_t GetPositions(size_t begin, uint64_t* positions, size_t max_positions) const;
+
+    //accessors
+    size_t num() const;
+    //bytes held by the containers
+    size_t GetMemorySize() const;
+    //whether the dense form would be smaller
+    bool IsDense() const;
+
+private:
+    struct Container{
+        //exactly one of them is in use; both empty for no ones
+        std::vector<uint16_t> array;
+        std::vector<WordUnit> bitmap;
+        size_t cardinality = 0;
+    };
+
+    size_t NumContainerWords(size_t container_id) const;
+    void Compress(size_t container_id, const WordUnit* words);
+    void Expand(size_t container_id, WordUnit* words) const;
+    void AndWords(size_t container_id, const WordUnit* words);
+    void OrWords(size_t container_id, const WordUnit* words);
+
+    std::vector<Container> containers_;
+    const size_t num_;
+
+};
+
+inline size_t CompressedBitVector::num() const{
+    return num_;
+}
+
+}   // namespace
+
+#endif  //COMPRESSED_BITVECTOR_H
@@ -0,0 +1,68 @@
+/*******************************************************************************
+ * Copyright (c) 2015
+ * The Hong Kong Polytechnic University, Database Group
+ *
+ * Author: Ziqiang Feng (cszqfeng AT comp DOT polyu.edu.hk)
+ *
+ * See file LICENSE.md for details.
+ *******************************************************************************/
+#include "cpu_features.h"
+
+#include    <cpuid.h>
+#include    <cstdint>
+
+namespace byteslice{
+
+//XCR0: which register states the OS saves on context switch
+static uint64_t ReadXcr0(){
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+}
+
+SimdLevel DetectSimdLevel(){
+    uint32_t eax, ebx, ecx, edx;
+    if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx)){
+        return SimdLevel::kSSE42;
+    }
+    const bool osxsave = ecx & bit_OSXSAVE;
+    const bool avx = ecx & bit_AVX;
+    if(!osxsave || !avx){
+        return SimdLevel::kSSE42;
+    }
+    const uint64_t xcr0 = ReadXcr0();
+    const bool os_ymm = (xcr0 & 0x6) == 0x6;      //SSE and AVX state
+    const bool os_zmm = (xcr0 & 0xe6) == 0xe6;    //plus opmask and ZMM state
+
+    if(!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)){
+        return SimdLevel::kSSE42;
+    }
+    const bool avx2 = ebx & bit_AVX2;
+    const bool avx512 = (ebx & bit_AVX512F) && (ebx & bit_AVX512BW) && (ebx & bit_AVX512VL);
+
+    if(os_zmm && avx2 && avx512){
+        return SimdLevel::kAVX512;
+    }
+    if(os_ymm && avx2){
+        return SimdLevel::kAVX2;
+    }
+    return SimdLevel::kSSE42;
+}
+
+//Selected once during static initialization.
+//kSSE42 is the zero value, so a read before initialization is still safe.
+static SimdLevel selected_level = DetectSimdLevel();
+
+SimdLevel GetSimdLevel(){
+    return selected_level;
+}
+
+bool SetSimdLevel(SimdLevel level){
+    if(level > DetectSimdLevel()){
+        return false;
+    }
+    selected_level = level;
+    return true;
+}
+
+}   // namespace
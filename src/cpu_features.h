@@ -0,0 +1,34 @@
+/*******************************************************************************
+ * Copyright (c) 2015
+ * The Hong Kong Polytechnic University, Database Group
+ *
+ * Author: Ziqiang Feng (cszqfeng AT comp DOT polyu.edu.hk)
+ *
+ * See file LICENSE.md for details.
+ *******************************************************************************/
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+#include "../src/types.h"
+
+namespace byteslice{
+
+/**
+  Runtime selection of the instruction set used by the kernels.
+  The library is compiled for an SSE4.2 baseline; faster kernels are
+  compiled per target and picked once at startup from cpuid.
+*/
+
+// Highest instruction set supported by both the CPU and the OS.
+SimdLevel DetectSimdLevel();
+
+// Instruction set the kernels currently use.
+SimdLevel GetSimdLevel();
+
+// Force kernels to a given instruction set, e.g. to benchmark a fallback.
+// Returns false (and changes nothing) if the machine does not support it.
+bool SetSimdLevel(SimdLevel level);
+
+}   // namespace
+
+#endif  //CPU_FEATURES_H
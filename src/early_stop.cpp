@@ -0,0 +1,53 @@
+/*******************************************************************************
+ * Copyright (c) 2015
+ * The Hong Kong Polytechnic University, Database Group
+ *
+ * Author: Ziqiang Feng (cszqfeng AT comp DOT polyu.edu.hk)
+ *
+ * See file LICENSE.md for details.
+ *******************************************************************************/
+#include "early_stop.h"
+
+#include    <atomic>
+
+namespace byteslice{
+
+static std::atomic<EarlyStop> early_stop(EarlyStop::kAdaptive);
+
+static std::atomic<size_t> num_strides_checked(0);
+static std::atomic<size_t> num_strides_full(0);
+static std::atomic<size_t> num_checks(0);
+static std::atomic<size_t> num_stops(0);
+
+EarlyStop GetEarlyStop(){
+    return early_stop.load(std::memory_order_relaxed);
+}
+
+void SetEarlyStop(EarlyStop policy){
+    early_stop.store(policy, std::memory_order_relaxed);
+}
+
+EarlyStopStats GetEarlyStopStats(){
+    EarlyStopStats stats;
+    stats.num_strides_checked = num_strides_checked.load(std::memory_order_relaxed);
+    stats.num_strides_full = num_strides_full.load(std::memory_order_relaxed);
+    stats.num_checks = num_checks.load(std::memory_order_relaxed);
+    stats.num_stops = num_stops.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void ResetEarlyStopStats(){
+    num_strides_checked.store(0, std::memory_order_relaxed);
+    num_strides_full.store(0, std::memory_order_relaxed);
+    num_checks.store(0, std::memory_order_relaxed);
+    num_stops.store(0, std::memory_order_relaxed);
+}
+
+void AddEarlyStopStats(const EarlyStopStats &stats){
+    num_strides_checked.fetch_add(stats.num_strides_checked, std::memory_order_relaxed);
+    num_strides_full.fetch_add(stats.num_strides_full, std::memory_order_relaxed);
+    num_checks.fetch_add(stats.num_checks, std::memory_order_relaxed);
+    num_stops.fetch_add(stats.num_stops, std::memory_order_relaxed);
+}
+
+}   // namespace
@@ -0,0 +1,59 @@
+/*******************************************************************************
+ * Copyright (c) 2015
+ * The Hong Kong Polytechnic University, Database Group
+ *
+ * Author: Ziqiang Feng (cszqfeng AT comp DOT polyu.edu.hk)
+ *
+ * See file LICENSE.md for details.
+ *******************************************************************************/
+#ifndef EARLY_STOP_H
+#define EARLY_STOP_H
+
+#include "../src/types.h"
+
+namespace byteslice{
+
+/**
+  Early stop in ByteSlice scans: after each byte slice, a chunk of lanes
+  stops if no lane is still equal on the bytes seen so far. On low-entropy
+  data the check rarely fires and only costs branches, so scans can also
+  run all slices branch-free. kAdaptive samples the stop rate on a stride
+  with early stop and uses the branch-free kernel for the next strides
+  while the rate stays low.
+*/
+
+// Policy used by subsequent scans (default: kAdaptive).
+EarlyStop GetEarlyStop();
+void SetEarlyStop(EarlyStop policy);
+
+// Counters accumulated over all scans since the last reset.
+struct EarlyStopStats{
+    size_t num_strides_checked = 0;     // strides scanned with early stop
+    size_t num_strides_full = 0;        // strides scanned branch-free
+    size_t num_checks = 0;              // early-stop checks evaluated
+    size_t num_stops = 0;               // checks that ended a chunk
+};
+
+EarlyStopStats GetEarlyStopStats();
+void ResetEarlyStopStats();
+// Used by the scans to publish their counters.
+void AddEarlyStopStats(const EarlyStopStats &stats);
+
+// State of one scan over a block, which may come in pieces (e.g. FilterWords
+// on chunks of words): the adaptive decision carries over from piece to
+// piece, and the counters are published once, when the state goes away.
+struct EarlyStopState{
+    EarlyStopState() = default;
+    EarlyStopState(const EarlyStopState&) = delete;
+    EarlyStopState& operator=(const EarlyStopState&) = delete;
+    ~EarlyStopState(){
+        AddEarlyStopStats(stats);
+    }
+
+    size_t num_full_strides_left = 0;   // strides still to run branch-free
+    EarlyStopStats stats;
+};
+
+}   // namespace
+
+#endif  //EARLY_STOP_H
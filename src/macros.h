@@ -16,4 +16,12 @@
 
 #define POPCNT64(X) (_mm_popcnt_u64(X))
 
+// Kernels that are written once against an instruction set traits class
+// are forced inline into a small wrapper compiled for that instruction set.
+#define FORCE_INLINE inline __attribute__((always_inline))
+
+#define TARGET_SSE42    __attribute__((target("sse4.2,popcnt")))
+#define TARGET_AVX2     __attribute__((target("avx2,popcnt")))
+#define TARGET_AVX512   __attribute__((target("avx512f,avx512bw,avx512vl,avx2,popcnt")))
+
 #endif  // MACROS_H
@@ -8,39 +8,100 @@
  *******************************************************************************/
 #include "naive_column_block.h"
 
+#include    <algorithm>
 #include	<cassert>
 #include    <cstring>
+#include    <functional>
+#include    <limits>
+#include    <vector>
+
+#include "numa_placement.h"
 
 namespace byteslice{
 
 template <typename DTYPE>
-NaiveColumnBlock<DTYPE>::NaiveColumnBlock(size_t num):
+NaiveColumnBlock<DTYPE>::NaiveColumnBlock(size_t num, size_t node):
     ColumnBlock(ColumnType::kNaive, sizeof(DTYPE)*8, num){
         data_ = new DTYPE[kNumTuplesPerBlock];
+        //placed before the first touch below
+        PlaceOnNode(data_, sizeof(DTYPE)*kNumTuplesPerBlock, node);
         memset(data_, 0x0, sizeof(DTYPE)*kNumTuplesPerBlock);
 }
 
 template <typename DTYPE>
 NaiveColumnBlock<DTYPE>::~NaiveColumnBlock(){
-    delete[] data_;
+    if(!mapped_){
+        delete[] data_;
+    }
 }
 
 template <typename DTYPE>
 bool NaiveColumnBlock<DTYPE>::Resize(size_t num){
+    //a mapping only holds the tuples it was written with
+    assert(!mapped_ || num <= num_tuples_);
+    assert(num <= kNumTuplesPerBlock);
+    if(num > num_tuples_){
+        //whatever a shrink left there, the added tuples read as 0
+        memset(data_ + num_tuples_, 0x0, sizeof(DTYPE)*(num - num_tuples_));
+        ExtendZoneMap(0, 0);
+    }
     num_tuples_ = num;
     return true;
 }
 
 template <typename DTYPE>
-void NaiveColumnBlock<DTYPE>::SerToFile(SequentialWriteBinaryFile &file) const{
-    file.Append(&num_tuples_, sizeof(num_tuples_));
-    file.Append(data_, sizeof(DTYPE)*kNumTuplesPerBlock);
+void NaiveColumnBlock<DTYPE>::ComputeZoneMap(size_t begin, size_t end,
+        WordUnit &min_value, WordUnit &max_value) const{
+    DTYPE lo = std::numeric_limits<DTYPE>::max();
+    DTYPE hi = 0;
+    for(size_t pos = begin; pos < end; pos++){
+        lo = std::min(lo, data_[pos]);
+        hi = std::max(hi, data_[pos]);
+    }
+    min_value = lo;
+    max_value = hi;
+}
+
+template <typename DTYPE>
+void NaiveColumnBlock<DTYPE>::SerToFile(SequentialWriteBinaryFile &file,
+                                        Compression /*compression*/) const{
+    SerHeader(file);
+    file.Append(data_, AlignedSize(sizeof(DTYPE)*num_tuples_));
 }
 
 template <typename DTYPE>
 void NaiveColumnBlock<DTYPE>::DeserFromFile(const SequentialReadBinaryFile &file){
-    file.Read(&num_tuples_, sizeof(num_tuples_));
-    file.Read(data_, sizeof(DTYPE)*kNumTuplesPerBlock);
+    assert(!mapped_);
+    const Compression compression = DeserHeader(file);
+    assert(Compression::kNone == compression);
+    (void)compression;
+    assert(num_tuples_ <= kNumTuplesPerBlock);
+    const size_t size = AlignedSize(sizeof(DTYPE)*num_tuples_);
+    file.Read(data_, size);
+    memset(reinterpret_cast<char*>(data_) + size, 0, sizeof(DTYPE)*kNumTuplesPerBlock - size);
+}
+
+template <typename DTYPE>
+bool NaiveColumnBlock<DTYPE>::MapFromBuffer(const char* buffer, size_t size, size_t &offset){
+    if(!MapHeader(buffer, size, offset) || num_tuples_ > kNumTuplesPerBlock ||
+            offset + AlignedSize(sizeof(DTYPE)*num_tuples_) > size){
+        return false;
+    }
+    if(!mapped_){
+        delete[] data_;
+    }
+    data_ = reinterpret_cast<DTYPE*>(const_cast<char*>(buffer + offset));
+    offset += AlignedSize(sizeof(DTYPE)*num_tuples_);
+    mapped_ = true;
+    return true;
+}
+
+template <typename DTYPE>
+ColumnBlock* NaiveColumnBlock<DTYPE>::Clone(size_t node) const{
+    NaiveColumnBlock* block = new NaiveColumnBlock(num_tuples_, node);
+    memcpy(block->data_, data_, sizeof(DTYPE)*num_tuples_);
+    block->SetZoneMap(min_value_, max_value_);
+    return block;
 }
 
 //Scan against a literal
@@ -48,43 +109,87 @@ template <typename DTYPE>
 void NaiveColumnBlock<DTYPE>::Scan(Comparator comparator, WordUnit literal, 
         BitVectorBlock* bv_block, Bitwise bit_opt) const{
     assert(bv_block->num() == num_tuples_);
+    WordUnit* words = bv_block->data();
+    const size_t num_words = CEIL(num_tuples_, kNumWordBits);
+    if(Bitwise::kAnd == bit_opt && bv_block->has_summary()){
+        //only the runs the summary marks live can keep ones
+        bv_block->ForEachLiveRange([&](size_t begin_word, size_t num_live_words){
+            if(begin_word < num_words){
+                const size_t n = std::min(num_live_words, num_words - begin_word);
+                FilterWords(comparator, literal, words + begin_word, begin_word, n);
+                bv_block->UpdateSummary(begin_word, n);
+            }
+        });
+        return;
+    }
     switch(comparator){
         case Comparator::kLess:
-            return ScanHelper1<Comparator::kLess>(literal, bv_block, bit_opt);
+            ScanHelper1<Comparator::kLess>(literal, words, 0, num_words, bit_opt);
+            break;
         case Comparator::kGreater:
-            return ScanHelper1<Comparator::kGreater>(literal, bv_block, bit_opt);
+            ScanHelper1<Comparator::kGreater>(literal, words, 0, num_words, bit_opt);
+            break;
         case Comparator::kLessEqual:
-            return ScanHelper1<Comparator::kLessEqual>(literal, bv_block, bit_opt);
+            ScanHelper1<Comparator::kLessEqual>(literal, words, 0, num_words, bit_opt);
+            break;
         case Comparator::kGreaterEqual:
-            return ScanHelper1<Comparator::kGreaterEqual>(literal, bv_block, bit_opt);
+            ScanHelper1<Comparator::kGreaterEqual>(literal, words, 0, num_words, bit_opt);
+            break;
         case Comparator::kEqual:
-            return ScanHelper1<Comparator::kEqual>(literal, bv_block, bit_opt);
+            ScanHelper1<Comparator::kEqual>(literal, words, 0, num_words, bit_opt);
+            break;
         case Comparator::kInequal:
-            return ScanHelper1<Comparator::kInequal>(literal, bv_block, bit_opt);
+            ScanHelper1<Comparator::kInequal>(literal, words, 0, num_words, bit_opt);
+            break;
     }
+    bv_block->UpdateSummary();
+}
 
+//Conjunctive filter on a range of bit vector words
+template <typename DTYPE>
+void NaiveColumnBlock<DTYPE>::FilterWords(Comparator comparator, WordUnit literal,
+        WordUnit* words, size_t begin_word, size_t num_words, EarlyStopState*) const{
+    switch(comparator){
+        case Comparator::kLess:
+            return ScanHelper2<Comparator::kLess, Bitwise::kAnd>(literal, words, begin_word, num_words);
+        case Comparator::kGreater:
+            return ScanHelper2<Comparator::kGreater, Bitwise::kAnd>(literal, words, begin_word, num_words);
+        case Comparator::kLessEqual:
+            return ScanHelper2<Comparator::kLessEqual, Bitwise::kAnd>(literal, words, begin_word, num_words);
+        case Comparator::kGreaterEqual:
+            return ScanHelper2<Comparator::kGreaterEqual, Bitwise::kAnd>(literal, words, begin_word, num_words);
+        case Comparator::kEqual:
+            return ScanHelper2<Comparator::kEqual, Bitwise::kAnd>(literal, words, begin_word, num_words);
+        case Comparator::kInequal:
+            return ScanHelper2<Comparator::kInequal, Bitwise::kAnd>(literal, words, begin_word, num_words);
+    }
 }
 
 template <typename DTYPE>
 template <Comparator CMP>
-void NaiveColumnBlock<DTYPE>::ScanHelper1(WordUnit literal, BitVectorBlock* bv_block, 
-        Bitwise bit_opt) const{
+void NaiveColumnBlock<DTYPE>::ScanHelper1(WordUnit literal, WordUnit* words,
+        size_t begin_word, size_t num_words, Bitwise bit_opt) const{
     switch(bit_opt){
         case Bitwise::kSet:
-            return ScanHelper2<CMP, Bitwise::kSet>(literal, bv_block);
+            return ScanHelper2<CMP, Bitwise::kSet>(literal, words, begin_word, num_words);
         case Bitwise::kAnd:
-            return ScanHelper2<CMP, Bitwise::kAnd>(literal, bv_block);
+            return ScanHelper2<CMP, Bitwise::kAnd>(literal, words, begin_word, num_words);
         case Bitwise::kOr:
-            return ScanHelper2<CMP, Bitwise::kOr>(literal, bv_block);
+            return ScanHelper2<CMP, Bitwise::kOr>(literal, words, begin_word, num_words);
     }
 }
 
 template <typename DTYPE>
 template <Comparator CMP, Bitwise OPT>
-void NaiveColumnBlock<DTYPE>::ScanHelper2(WordUnit literal, BitVectorBlock* bv_block) const{
+void NaiveColumnBlock<DTYPE>::ScanHelper2(WordUnit literal, WordUnit* words,
+        size_t begin_word, size_t num_words) const{
     //Do the real work here
     DTYPE lit = static_cast<DTYPE>(literal);
-    for(size_t offset = 0; offset < num_tuples_; offset += kNumWordBits){
+    for(size_t w = 0; w < num_words; w++){
+        size_t offset = (begin_word + w) * kNumWordBits;
+        if(OPT == Bitwise::kAnd && 0 == words[w]){
+            continue;
+        }
         WordUnit word = 0;
         for(size_t i = 0; i < kNumWordBits; i++){
             size_t pos = offset + i;
@@ -117,22 +222,21 @@ void NaiveColumnBlock<DTYPE>::ScanHelper2(WordUnit literal, BitVectorBlock* bv_b
             //word |= (bit << (kNumWordBits -1 - i));
             word |= (bit << i);
         }
-        size_t bv_word_id = offset / kNumWordBits;
         WordUnit x;
         switch(OPT){
             case Bitwise::kSet:
                 x = word;
                 break;
             case Bitwise::kAnd:
-                x = bv_block->GetWordUnit(bv_word_id);
+                x = words[w];
                 x &= word;
                 break;
             case Bitwise::kOr:
-                x = bv_block->GetWordUnit(bv_word_id);
+                x = words[w];
                 x |= word;
                 break;
         }
-        bv_block->SetWordUnit(x, bv_word_id);
+        words[w] = x;
     }
 
 }
@@ -233,13 +337,199 @@ void NaiveColumnBlock<DTYPE>::ScanHelper2(const ColumnBlock* colblock,
     }
 }
 
+//Scan against a range
+template <typename DTYPE>
+void NaiveColumnBlock<DTYPE>::ScanBetween(WordUnit lower, WordUnit upper,
+        BitVectorBlock* bv_block, Bitwise bit_opt) const{
+    assert(bv_block->num() == num_tuples_);
+    switch(bit_opt){
+        case Bitwise::kSet:
+            return ScanBetweenHelper<Bitwise::kSet>(lower, upper, bv_block);
+        case Bitwise::kAnd:
+            return ScanBetweenHelper<Bitwise::kAnd>(lower, upper, bv_block);
+        case Bitwise::kOr:
+            return ScanBetweenHelper<Bitwise::kOr>(lower, upper, bv_block);
+    }
+}
+
+template <typename DTYPE>
+template <Bitwise OPT>
+void NaiveColumnBlock<DTYPE>::ScanBetweenHelper(WordUnit lower, WordUnit upper,
+                                        BitVectorBlock* bvblock) const{
+    for(size_t offset = 0; offset < num_tuples_; offset += kNumWordBits){
+        WordUnit word = 0;
+        for(size_t i = 0; i < kNumWordBits; i++){
+            size_t pos = offset + i;
+            if(pos >= num_tuples_){
+                break;
+            }
+            //compare in WordUnit so that bounds out of DTYPE's range work
+            WordUnit value = static_cast<WordUnit>(data_[pos]);
+            WordUnit bit = (lower <= value) & (value <= upper);
+            word |= (bit << i);
+        }
+        size_t bv_word_id = offset / kNumWordBits;
+        WordUnit x;
+        switch(OPT){
+            case Bitwise::kSet:
+                x = word;
+                break;
+            case Bitwise::kAnd:
+                x = bvblock->GetWordUnit(bv_word_id);
+                x &= word;
+                break;
+            case Bitwise::kOr:
+                x = bvblock->GetWordUnit(bv_word_id);
+                x |= word;
+                break;
+        }
+        bvblock->SetWordUnit(x, bv_word_id);
+    }
+}
+
+//Scan against a list of values
+template <typename DTYPE>
+void NaiveColumnBlock<DTYPE>::ScanIn(const WordUnit* values, size_t num_values,
+        BitVectorBlock* bv_block, Bitwise bit_opt) const{
+    assert(bv_block->num() == num_tuples_);
+    std::vector<WordUnit> sorted(values, values + num_values);
+    std::sort(sorted.begin(), sorted.end());
+    for(size_t offset = 0; offset < num_tuples_; offset += kNumWordBits){
+        WordUnit word = 0;
+        for(size_t i = 0; i < kNumWordBits; i++){
+            size_t pos = offset + i;
+            if(pos >= num_tuples_){
+                break;
+            }
+            WordUnit bit = std::binary_search(sorted.begin(), sorted.end(),
+                                static_cast<WordUnit>(data_[pos]));
+            word |= (bit << i);
+        }
+        size_t bv_word_id = offset / kNumWordBits;
+        WordUnit x = word;
+        switch(bit_opt){
+            case Bitwise::kSet:
+                break;
+            case Bitwise::kAnd:
+                x &= bv_block->GetWordUnit(bv_word_id);
+                break;
+            case Bitwise::kOr:
+                x |= bv_block->GetWordUnit(bv_word_id);
+                break;
+        }
+        bv_block->SetWordUnit(x, bv_word_id);
+    }
+}
+
 template <typename DTYPE>
 void NaiveColumnBlock<DTYPE>::BulkLoadArray(const WordUnit* codes, size_t num, 
         size_t start_pos){
     assert(start_pos + num <= num_tuples_);
+    assert(!mapped_);
     for(size_t i = 0; i < num; i++){
         data_[start_pos+i] = static_cast<DTYPE>(codes[i]);
     }
+    WordUnit min_value, max_value;
+    ComputeZoneMap(start_pos, start_pos + num, min_value, max_value);
+    if(0 == start_pos && num == num_tuples_){
+        SetZoneMap(min_value, max_value);
+    }
+    else{
+        ExtendZoneMap(min_value, max_value);
+    }
+}
+
+
+template <typename DTYPE>
+WordUnit NaiveColumnBlock<DTYPE>::Sum(const BitVectorBlock* filter) const{
+    assert(nullptr == filter || filter->num() == num_tuples_);
+    WordUnit sum = 0;
+    for(size_t offset = 0; offset < num_tuples_; offset += kNumWordBits){
+        WordUnit word = (nullptr == filter) ? -1ULL : filter->GetWordUnit(offset / kNumWordBits);
+        if(0 == word){
+            continue;
+        }
+        const size_t end = std::min(num_tuples_, offset + kNumWordBits);
+        for(size_t pos = offset; pos < end; pos++){
+            //branch-free select
+            sum += static_cast<WordUnit>(data_[pos]) & (0 - ((word >> (pos - offset)) & 1ULL));
+        }
+    }
+    return sum;
+}
+
+template <typename DTYPE>
+bool NaiveColumnBlock<DTYPE>::Min(const BitVectorBlock* filter, WordUnit &result) const{
+    assert(nullptr == filter || filter->num() == num_tuples_);
+    bool found = false;
+    DTYPE min_value = std::numeric_limits<DTYPE>::max();
+    for(size_t pos = 0; pos < num_tuples_; pos++){
+        if(nullptr == filter ||
+                ((filter->GetWordUnit(pos / kNumWordBits) >> (pos % kNumWordBits)) & 1ULL)){
+            min_value = std::min(min_value, data_[pos]);
+            found = true;
+        }
+    }
+    result = min_value;
+    return found;
+}
+
+template <typename DTYPE>
+bool NaiveColumnBlock<DTYPE>::Max(const BitVectorBlock* filter, WordUnit &result) const{
+    assert(nullptr == filter || filter->num() == num_tuples_);
+    bool found = false;
+    DTYPE max_value = 0;
+    for(size_t pos = 0; pos < num_tuples_; pos++){
+        if(nullptr == filter ||
+                ((filter->GetWordUnit(pos / kNumWordBits) >> (pos % kNumWordBits)) & 1ULL)){
+            max_value = std::max(max_value, data_[pos]);
+            found = true;
+        }
+    }
+    result = max_value;
+    return found;
+}
+
+template <typename DTYPE>
+void NaiveColumnBlock<DTYPE>::TopK(const BitVectorBlock* filter, size_t k, bool largest,
+                                    std::vector<WordUnit> &result) const{
+    assert(nullptr == filter || filter->num() == num_tuples_);
+    result.clear();
+    for(size_t pos = 0; pos < num_tuples_; pos++){
+        if(nullptr == filter ||
+                ((filter->GetWordUnit(pos / kNumWordBits) >> (pos % kNumWordBits)) & 1ULL)){
+            result.push_back(data_[pos]);
+        }
+    }
+    k = std::min(k, result.size());
+    if(largest){
+        std::partial_sort(result.begin(), result.begin() + k, result.end(),
+                std::greater<WordUnit>());
+    }
+    else{
+        std::partial_sort(result.begin(), result.begin() + k, result.end());
+    }
+    result.resize(k);
+}
+
+template <typename DTYPE>
+void NaiveColumnBlock<DTYPE>::RadixHistogram(const BitVectorBlock* filter, size_t byte_id,
+                                    WordUnit prefix, size_t* histogram) const{
+    assert(nullptr == filter || filter->num() == num_tuples_);
+    const size_t num_bytes = CEIL(bit_width_, 8);
+    assert(byte_id < num_bytes);
+    const size_t num_padding_bits = num_bytes * 8 - bit_width_;
+    const size_t digit_shift = 8 * (num_bytes - 1 - byte_id);
+    for(size_t pos = 0; pos < num_tuples_; pos++){
+        if(nullptr == filter ||
+                ((filter->GetWordUnit(pos / kNumWordBits) >> (pos % kNumWordBits)) & 1ULL)){
+            const WordUnit code = static_cast<WordUnit>(data_[pos]) << num_padding_bits;
+            //shift in two steps: a shift by 64 is undefined
+            if(((code >> digit_shift) >> 8) == prefix){
+                histogram[(code >> digit_shift) & 0xFF]++;
+            }
+        }
+    }
 }
 
 
@@ -19,7 +19,8 @@ namespace byteslice{
 template <typename DTYPE>
 class NaiveColumnBlock: public ColumnBlock{
 public:
-    NaiveColumnBlock(size_t num=kNumTuplesPerBlock);
+    //data on a NUMA node (see numa_placement.h)
+    NaiveColumnBlock(size_t num=kNumTuplesPerBlock, size_t node=kAnyNode);
     virtual ~NaiveColumnBlock();
 
     WordUnit GetTuple(size_t pos_in_block) const override;
@@ -29,24 +30,49 @@ public:
             Bitwise bit_opt=Bitwise::kSet) const override;
     void Scan(Comparator comparator, const ColumnBlock* column_block,
             BitVectorBlock* bv_block, Bitwise bit_opti=Bitwise::kSet) const override;
+    void ScanBetween(WordUnit lower, WordUnit upper, BitVectorBlock* bv_block,
+            Bitwise bit_opt=Bitwise::kSet) const override;
+    void ScanIn(const WordUnit* values, size_t num_values, BitVectorBlock* bv_block,
+            Bitwise bit_opt=Bitwise::kSet) const override;
+    void FilterWords(Comparator comparator, WordUnit literal,
+            WordUnit* words, size_t begin_word, size_t num_words,
+            EarlyStopState* early_stop = nullptr) const override;
+    WordUnit Sum(const BitVectorBlock* filter) const override;
+    bool Min(const BitVectorBlock* filter, WordUnit &result) const override;
+    bool Max(const BitVectorBlock* filter, WordUnit &result) const override;
+    void TopK(const BitVectorBlock* filter, size_t k, bool largest,
+            std::vector<WordUnit> &result) const override;
+    void RadixHistogram(const BitVectorBlock* filter, size_t byte_id,
+            WordUnit prefix, size_t* histogram) const override;
     void BulkLoadArray(const WordUnit* codes, size_t num, size_t start_pos=0) override;
 
-    void SerToFile(SequentialWriteBinaryFile &file) const override;
+    void SerToFile(SequentialWriteBinaryFile &file,
+            Compression compression = Compression::kNone) const override;
     void DeserFromFile(const SequentialReadBinaryFile &file) override;
+    bool MapFromBuffer(const char* buffer, size_t size, size_t &offset) override;
+    ColumnBlock* Clone(size_t node) const override;
     bool Resize(size_t size) override;
 
 private:
     DTYPE* data_;
-    //scan helper: against a given literal
+    //scan helper: against a given literal, on bit vector words [begin_word, begin_word+num_words)
     template <Comparator CMP>
-    void ScanHelper1(WordUnit literal, BitVectorBlock* bv_block, Bitwise bit_opt) const;
+    void ScanHelper1(WordUnit literal, WordUnit* words, size_t begin_word,
+            size_t num_words, Bitwise bit_opt) const;
     template <Comparator CMP, Bitwise OPT>
-    void ScanHelper2(WordUnit literal, BitVectorBlock* bv_block) const;
+    void ScanHelper2(WordUnit literal, WordUnit* words, size_t begin_word,
+            size_t num_words) const;
     //scan helper: against another column_block
     template <Comparator CMP>
     void ScanHelper1(const ColumnBlock* colblock, BitVectorBlock* bvblock, Bitwise bit_opt) const;
     template <Comparator CMP, Bitwise OPT>
     void ScanHelper2(const ColumnBlock* colblock, BitVectorBlock* bvblock) const;
+    //scan helper: range
+    template <Bitwise OPT>
+    void ScanBetweenHelper(WordUnit lower, WordUnit upper, BitVectorBlock* bvblock) const;
+
+    //zone map over tuples [begin, end)
+    void ComputeZoneMap(size_t begin, size_t end, WordUnit &min_value, WordUnit &max_value) const;
 
 };
 
@@ -57,7 +83,10 @@ inline WordUnit NaiveColumnBlock<DTYPE>::GetTuple(size_t pos_in_block) const{
 
 template <typename DTYPE>
 inline void NaiveColumnBlock<DTYPE>::SetTuple(size_t pos_in_block, WordUnit value){
-    data_[pos_in_block] = static_cast<DTYPE>(value);
+    assert(!mapped_);
+    DTYPE code = static_cast<DTYPE>(value);
+    data_[pos_in_block] = code;
+    ExtendZoneMap(code, code);
 }
 
 
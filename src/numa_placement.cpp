@@ -0,0 +1,73 @@
+/*******************************************************************************
+ * Copyright (c) 2015
+ * The Hong Kong Polytechnic University, Database Group
+ *
+ * Author: Ziqiang Feng (cszqfeng AT comp DOT polyu.edu.hk)
+ *
+ * See file LICENSE.md for details.
+ *******************************************************************************/
+#include "numa_placement.h"
+
+#include    <cstdint>
+#include    <sched.h>
+#include    <unistd.h>
+
+#ifdef BYTESLICE_HAS_NUMA
+#include    <numa.h>
+#include    <numaif.h>
+#endif
+
+namespace byteslice{
+
+static size_t DetectNumNodes(){
+#ifdef BYTESLICE_HAS_NUMA
+    if(numa_available() >= 0){
+        return numa_max_node() + 1;
+    }
+#endif
+    return 1;
+}
+
+size_t GetNumNodes(){
+    static const size_t num_nodes = DetectNumNodes();
+    return num_nodes;
+}
+
+size_t GetCurrentNode(){
+#ifdef BYTESLICE_HAS_NUMA
+    if(GetNumNodes() > 1){
+        const int cpu = sched_getcpu();
+        const int node = cpu < 0 ? -1 : numa_node_of_cpu(cpu);
+        if(node >= 0){
+            return node;
+        }
+    }
+#endif
+    return 0;
+}
+
+void PlaceOnNode(void* addr, size_t size, size_t node){
+#ifdef BYTESLICE_HAS_NUMA
+    if(GetNumNodes() <= 1 || kAnyNode == node){
+        return;
+    }
+    const uintptr_t page_size = sysconf(_SC_PAGESIZE);
+    const uintptr_t begin = (reinterpret_cast<uintptr_t>(addr) + page_size - 1) / page_size * page_size;
+    const uintptr_t end = (reinterpret_cast<uintptr_t>(addr) + size) / page_size * page_size;
+    if(begin >= end){
+        return;
+    }
+    struct bitmask* nodes = numa_allocate_nodemask();
+    numa_bitmask_setbit(nodes, node);
+    //preferred rather than bound: a full node falls back to the others
+    mbind(reinterpret_cast<void*>(begin), end - begin, MPOL_PREFERRED,
+            nodes->maskp, nodes->size + 1, MPOL_MF_MOVE);
+    numa_free_nodemask(nodes);
+#else
+    (void)addr;
+    (void)size;
+    (void)node;
+#endif
+}
+
+}   // namespace
@@ -0,0 +1,80 @@
+/*******************************************************************************
+ * Copyright (c) 2015
+ * The Hong Kong Polytechnic University, Database Group
+ *
+ * Author: Ziqiang Feng (cszqfeng AT comp DOT polyu.edu.hk)
+ *
+ * See file LICENSE.md for details.
+ *******************************************************************************/
+#ifndef NUMA_PLACEMENT_H
+#define NUMA_PLACEMENT_H
+
+#include    <atomic>
+#include    <cstddef>
+#include    <vector>
+
+namespace byteslice{
+
+/**
+  NUMA placement of blocks.
+  Block b of every column and of every bit vector lives on node
+  GetBlockNode(b): blocks are dealt round robin, so that a column uses
+  the memory of all nodes, and a scan reads a column block and writes
+  its bit vector block on the same node.
+  ForEachBlock runs a loop over blocks in which every thread first takes
+  the blocks of its own node, then helps with those of the other nodes.
+  Without libnuma, or on a single node, there is nothing to place and
+  ForEachBlock is a dynamically scheduled loop.
+*/
+
+size_t GetNumNodes();
+
+inline size_t GetBlockNode(size_t block_id){
+    return block_id % GetNumNodes();
+}
+
+//Node of the cpu the calling thread runs on
+size_t GetCurrentNode();
+
+//No placement: pages go to the node of the thread that first touches them
+constexpr size_t kAnyNode = static_cast<size_t>(-1);
+
+//Keep the pages of [addr, addr + size) on node. Called on fresh memory
+//before it is written, so that the first touch already allocates the
+//pages there; pages the allocator hands out touched are moved. Pages
+//only partly in the range stay where they are.
+void PlaceOnNode(void* addr, size_t size, size_t node);
+
+//f(block_id) for every block_id < num_blocks, in parallel
+template <typename F>
+void ForEachBlock(size_t num_blocks, F f){
+    const size_t num_nodes = GetNumNodes();
+    if(1 == num_nodes){
+#       pragma omp parallel for schedule(dynamic)
+        for(size_t block_id = 0; block_id < num_blocks; block_id++){
+            f(block_id);
+        }
+        return;
+    }
+
+    //next unclaimed block of every node: node n has n, n + num_nodes, ...
+    std::vector<std::atomic<size_t>> next(num_nodes);
+    for(size_t node = 0; node < num_nodes; node++){
+        next[node].store(node);
+    }
+#   pragma omp parallel
+    {
+        const size_t home = GetCurrentNode();
+        for(size_t k = 0; k < num_nodes; k++){
+            std::atomic<size_t> &cursor = next[(home + k) % num_nodes];
+            for(size_t block_id = cursor.fetch_add(num_nodes); block_id < num_blocks;
+                    block_id = cursor.fetch_add(num_nodes)){
+                f(block_id);
+            }
+        }
+    }
+}
+
+}   // namespace
+
+#endif  //NUMA_PLACEMENT_H
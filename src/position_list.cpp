@@ -0,0 +1,216 @@
+/*******************************************************************************
+ * Copyright (c) 2015
+ * The Hong Kong Polytechnic University, Database Group
+ *
+ * Author: Ziqiang Feng (cszqfeng AT comp DOT polyu.edu.hk)
+ *
+ * See file LICENSE.md for details.
+ *******************************************************************************/
+#include "position_list.h"
+
+#include    <algorithm>
+#include    <cassert>
+
+#include "bitvector.h"
+#include "cpu_features.h"
+#include "macros.h"
+
+namespace byteslice{
+
+//For every byte value, the indices of its set bits, padded to 8 entries
+struct BitIndexTable{
+    BitIndexTable(){
+        for(size_t byte = 0; byte < 256; byte++){
+            size_t n = 0;
+            for(size_t bit = 0; bit < 8; bit++){
+                if(byte & (1 << bit)){
+                    index[byte][n++] = bit;
+                }
+            }
+            for(; n < 8; n++){
+                index[byte][n] = 0;
+            }
+        }
+    }
+    alignas(8) uint8_t index[256][8];
+};
+
+static const BitIndexTable bit_index_table;
+
+//Positions of one word, bit by bit; used for the partial last word
+template <typename T>
+FORCE_INLINE static size_t ExtractWord(WordUnit word, uint64_t base, T* positions){
+    size_t count = 0;
+    while(0 != word){
+        positions[count++] = static_cast<T>(base + __builtin_ctzll(word));
+        word &= word - 1;
+    }
+    return count;
+}
+
+//Expansion of full words, appending at positions + count
+template <typename T>
+TARGET_SSE42 static void ExtractSse42(const WordUnit* words, size_t num_words,
+        uint64_t base, T* positions, size_t &count){
+    for(size_t w = 0; w < num_words; w++){
+        WordUnit word = words[w];
+        if(0 == word){
+            continue;
+        }
+        for(size_t b = 0; b < 8; b++, word >>= 8){
+            const size_t byte = word & 0xff;
+            const __m128i index = _mm_loadl_epi64(
+                    reinterpret_cast<const __m128i*>(bit_index_table.index[byte]));
+            const uint64_t offset = base + w * kNumWordBits + b * 8;
+            if(4 == sizeof(T)){
+                const __m128i vbase = _mm_set1_epi32(static_cast<uint32_t>(offset));
+                __m128i* out = reinterpret_cast<__m128i*>(positions + count);
+                _mm_storeu_si128(out, _mm_add_epi32(_mm_cvtepu8_epi32(index), vbase));
+                _mm_storeu_si128(out + 1, _mm_add_epi32(
+                            _mm_cvtepu8_epi32(_mm_srli_si128(index, 4)), vbase));
+            }
+            else{
+                const __m128i vbase = _mm_set1_epi64x(offset);
+                __m128i* out = reinterpret_cast<__m128i*>(positions + count);
+                _mm_storeu_si128(out, _mm_add_epi64(_mm_cvtepu8_epi64(index), vbase));
+                _mm_storeu_si128(out + 1, _mm_add_epi64(
+                            _mm_cvtepu8_epi64(_mm_srli_si128(index, 2)), vbase));
+                _mm_storeu_si128(out + 2, _mm_add_epi64(
+                            _mm_cvtepu8_epi64(_mm_srli_si128(index, 4)), vbase));
+                _mm_storeu_si128(out + 3, _mm_add_epi64(
+                            _mm_cvtepu8_epi64(_mm_srli_si128(index, 6)), vbase));
+            }
+            count += POPCNT64(byte);
+        }
+    }
+}
+
+template <typename T>
+TARGET_AVX2 static void ExtractAvx2(const WordUnit* words, size_t num_words,
+        uint64_t base, T* positions, size_t &count){
+    for(size_t w = 0; w < num_words; w++){
+        WordUnit word = words[w];
+        if(0 == word){
+            continue;
+        }
+        for(size_t b = 0; b < 8; b++, word >>= 8){
+            const size_t byte = word & 0xff;
+            const __m128i index = _mm_loadl_epi64(
+                    reinterpret_cast<const __m128i*>(bit_index_table.index[byte]));
+            const uint64_t offset = base + w * kNumWordBits + b * 8;
+            if(4 == sizeof(T)){
+                const __m256i vbase = _mm256_set1_epi32(static_cast<uint32_t>(offset));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(positions + count),
+                        _mm256_add_epi32(_mm256_cvtepu8_epi32(index), vbase));
+            }
+            else{
+                const __m256i vbase = _mm256_set1_epi64x(offset);
+                __m256i* out = reinterpret_cast<__m256i*>(positions + count);
+                _mm256_storeu_si256(out, _mm256_add_epi64(_mm256_cvtepu8_epi64(index), vbase));
+                _mm256_storeu_si256(out + 1, _mm256_add_epi64(
+                            _mm256_cvtepu8_epi64(_mm_srli_si128(index, 4)), vbase));
+            }
+            count += POPCNT64(byte);
+        }
+    }
+}
+
+//AVX-512 compresses the selected lanes directly: nothing is written past the result
+template <typename T>
+TARGET_AVX512 static void ExtractAvx512(const WordUnit* words, size_t num_words,
+        uint64_t base, T* positions, size_t &count){
+    const __m512i iota32 = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7,
+                                             8, 9, 10, 11, 12, 13, 14, 15);
+    const __m512i iota64 = _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7);
+    for(size_t w = 0; w < num_words; w++){
+        WordUnit word = words[w];
+        if(0 == word){
+            continue;
+        }
+        const uint64_t offset = base + w * kNumWordBits;
+        if(4 == sizeof(T)){
+            for(size_t k = 0; k < kNumWordBits; k += 16){
+                const __mmask16 m = static_cast<__mmask16>(word >> k);
+                const __m512i v = _mm512_add_epi32(iota32,
+                        _mm512_set1_epi32(static_cast<uint32_t>(offset + k)));
+                _mm512_mask_compressstoreu_epi32(positions + count, m, v);
+                count += POPCNT64(m);
+            }
+        }
+        else{
+            for(size_t k = 0; k < kNumWordBits; k += 8){
+                const __mmask8 m = static_cast<__mmask8>(word >> k);
+                const __m512i v = _mm512_add_epi64(iota64, _mm512_set1_epi64(offset + k));
+                _mm512_mask_compressstoreu_epi64(positions + count, m, v);
+                count += POPCNT64(m);
+            }
+        }
+    }
+}
+
+template <typename T>
+static size_t ExtractPositionsHelper(const WordUnit* words, size_t num_bits, uint64_t base,
+        T* positions){
+    const size_t num_full_words = num_bits / kNumWordBits;
+    size_t count = 0;
+    switch(GetSimdLevel()){
+        case SimdLevel::kAVX512:
+            ExtractAvx512(words, num_full_words, base, positions, count);
+            break;
+        case SimdLevel::kAVX2:
+            ExtractAvx2(words, num_full_words, base, positions, count);
+            break;
+        case SimdLevel::kSSE42:
+            ExtractSse42(words, num_full_words, base, positions, count);
+            break;
+    }
+    const size_t num_tail_bits = num_bits % kNumWordBits;
+    if(num_tail_bits > 0){
+        WordUnit tail = words[num_full_words] & ((1ULL << num_tail_bits) - 1);
+        count += ExtractWord(tail, base + num_full_words * kNumWordBits, positions + count);
+    }
+    return count;
+}
+
+size_t ExtractPositions(const WordUnit* words, size_t num_bits, uint64_t base,
+        uint32_t* positions){
+    return ExtractPositionsHelper(words, num_bits, base, positions);
+}
+
+size_t ExtractPositions(const WordUnit* words, size_t num_bits, uint64_t base,
+        uint64_t* positions){
+    return ExtractPositionsHelper(words, num_bits, base, positions);
+}
+
+template <typename T>
+static std::vector<size_t> ExtractPositionsHelper(const BitVector* bitvector, T* positions){
+    std::vector<size_t> counts(bitvector->GetNumBlocks(), 0);
+
+#   pragma omp parallel for schedule(dynamic)
+    for(size_t block_id = 0; block_id < bitvector->GetNumBlocks(); block_id++){
+        const BitVectorBlock* bvblock = bitvector->GetBVBlock(block_id);
+        const size_t block_offset = block_id * kNumTuplesPerBlock;
+        size_t count = 0;
+        bvblock->ForEachLiveRange([&](size_t begin_word, size_t num_words){
+            if(begin_word * kNumWordBits < bvblock->num()){
+                const size_t num_bits = std::min(num_words * kNumWordBits,
+                        bvblock->num() - begin_word * kNumWordBits);
+                count += ExtractPositionsHelper(bvblock->data() + begin_word, num_bits,
+                        block_offset + begin_word * kNumWordBits, positions + block_offset + count);
+            }
+        });
+        counts[block_id] = count;
+    }
+    return counts;
+}
+
+std::vector<size_t> ExtractPositions(const BitVector* bitvector, uint32_t* positions){
+    assert(bitvector->num() <= (1ULL << 32));
+    return ExtractPositionsHelper(bitvector, positions);
+}
+
+std::vector<size_t> ExtractPositions(const BitVector* bitvector, uint64_t* positions){
+    return ExtractPositionsHelper(bitvector, positions);
+}
+
+}   // namespace
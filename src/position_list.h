@@ -0,0 +1,44 @@
+/*******************************************************************************
+ * Copyright (c) 2015
+ * The Hong Kong Polytechnic University, Database Group
+ *
+ * Author: Ziqiang Feng (cszqfeng AT comp DOT polyu.edu.hk)
+ *
+ * See file LICENSE.md for details.
+ *******************************************************************************/
+#ifndef POSITION_LIST_H
+#define POSITION_LIST_H
+
+#include    <cstdint>
+#include    <vector>
+
+#include "../src/types.h"
+
+namespace byteslice{
+
+/**
+  Turn bit vector words into a position list (selection vector).
+  Writes base + i for every set bit i < num_bits of words, in increasing
+  order, and returns the number of positions written.
+  positions must hold num_bits entries: full words are expanded with
+  vector stores that may write (but not count) entries past the result.
+*/
+size_t ExtractPositions(const WordUnit* words, size_t num_bits, uint64_t base,
+        uint32_t* positions);
+size_t ExtractPositions(const WordUnit* words, size_t num_bits, uint64_t base,
+        uint64_t* positions);
+
+class BitVector;
+
+/**
+  Positions of all the 1's of a bit vector, one block per thread.
+  As Column::ScanToPositions: block b writes its positions (in increasing
+  order) to positions[b * kNumTuplesPerBlock], and its count is entry b of
+  the result; positions must hold bitvector->num() entries.
+*/
+std::vector<size_t> ExtractPositions(const BitVector* bitvector, uint32_t* positions);
+std::vector<size_t> ExtractPositions(const BitVector* bitvector, uint64_t* positions);
+
+}   // namespace
+
+#endif  //POSITION_LIST_H
@@ -8,6 +8,7 @@
  *******************************************************************************/
 #include "sequential_binary_file.h"
 
+#include    <algorithm>
 #include    <cassert>
 #include	<fstream>
 #include    <iostream>
@@ -50,6 +51,19 @@ size_t SequentialReadBinaryFile::Read(void* buf, size_t size) const{
     return count;
 }
 
+bool SequentialReadBinaryFile::Align(size_t alignment) const{
+    const long pos = ftell(file_);
+    if(pos < 0){
+        return false;
+    }
+    const long padding = (alignment - pos % alignment) % alignment;
+    return 0 == fseek(file_, padding, SEEK_CUR);
+}
+
+bool SequentialReadBinaryFile::Seek(size_t offset) const{
+    return 0 == fseek(file_, offset, SEEK_SET);
+}
+
 
 bool SequentialWriteBinaryFile::Open(const std::string filename){
     if(NULL != file_){
@@ -82,6 +96,31 @@ size_t SequentialWriteBinaryFile::Append(const void* data, size_t size){
     return count;
 }
 
+bool SequentialWriteBinaryFile::Align(size_t alignment){
+    const long pos = ftell(file_);
+    if(pos < 0){
+        return false;
+    }
+    static const char zeros[64] = {0};
+    size_t padding = (alignment - pos % alignment) % alignment;
+    while(padding > 0){
+        const size_t size = std::min(padding, sizeof(zeros));
+        if(size != Append(zeros, size)){
+            return false;
+        }
+        padding -= size;
+    }
+    return true;
+}
+
+size_t SequentialWriteBinaryFile::Tell() const{
+    return ftell(file_);
+}
+
+bool SequentialWriteBinaryFile::Seek(size_t offset){
+    return 0 == fseek(file_, offset, SEEK_SET);
+}
+
 bool SequentialWriteBinaryFile::Flush(){
     if(0 != fflush(file_)){
         return false;
@@ -19,6 +19,10 @@ public:
     bool Open(const std::string filename);
     bool Close();
     size_t Read(void* buf, size_t size) const;
+    //skip to the next multiple of alignment bytes from the file start
+    bool Align(size_t alignment) const;
+    //move to offset bytes from the file start
+    bool Seek(size_t offset) const;
     bool IsEnd();
 
 private:
@@ -32,6 +36,12 @@ public:
     bool Open(const std::string filename);
     bool Close();
     size_t Append(const void* data, size_t size);
+    //pad with zeros to the next multiple of alignment bytes from the file start
+    bool Align(size_t alignment);
+    //bytes written so far
+    size_t Tell() const;
+    //move to offset bytes from the file start, e.g. to patch a header
+    bool Seek(size_t offset);
     bool Flush();
 
 private:
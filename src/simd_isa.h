@@ -0,0 +1,548 @@
+/*******************************************************************************
+ * Copyright (c) 2015
+ * The Hong Kong Polytechnic University, Database Group
+ *
+ * Author: Ziqiang Feng (cszqfeng AT comp DOT polyu.edu.hk)
+ *
+ * See file LICENSE.md for details.
+ *******************************************************************************/
+#ifndef SIMD_ISA_H
+#define SIMD_ISA_H
+
+#include "../src/avx-utility.h"
+#include "../src/macros.h"
+#include "../src/types.h"
+
+namespace byteslice{
+
+/**
+  Instruction set traits.
+  A kernel is written once as a FORCE_INLINE template on one of these
+  classes, and instantiated inside a wrapper carrying the matching
+  TARGET_* attribute (see macros.h). The wrapper is what cpu dispatch calls.
+
+  Byte lanes:
+    Vec holds kNumLanes bytes; Mask marks a subset of the lanes.
+    Compare functions only report lanes that are set in the mask k.
+    Bytes are FLIPPED in storage, so signed compares give unsigned order.
+    InByteSet tests membership in a set of 256 byte values given as two
+    16-byte nibble tables: bit (hi & 7) of table_lo[lo] (hi < 8) or
+    table_hi[lo] (hi >= 8) is set iff byte (hi << 4 | lo) is in the set.
+    FromBits is the inverse of ToBits: bit i of the word selects lane i.
+    Select takes the lanes in k from a and the others from b. MinBytes and
+    MaxBytes compare FLIPPED bytes, i.e. in the order of the stored values.
+    SumBytes adds up the (unflipped) bytes of the lanes in k into the
+    64-bit lanes of a WordVec; ReduceWords adds up those lanes.
+    SplitBytes transposes kNumLanes codes: bytes[b] gets byte b (0 is the
+    least significant) of the low 32 bits of code << shift, FLIPPED.
+  Word lanes (bit vector kernels):
+    WordVec holds kNumWordsPerVec WordUnits. AndNotWords(a, b) is a & ~b.
+    CountWords counts the ones of each 64-bit lane (nibble table lookup,
+    no POPCNT per word).
+*/
+
+#pragma GCC push_options
+#pragma GCC target("sse4.2,popcnt")
+struct Sse42Isa{
+    typedef __m128i Vec;
+    typedef __m128i Mask;
+    typedef __m128i WordVec;
+    static constexpr size_t kNumLanes = 16;
+    static constexpr size_t kNumWordsPerVec = 2;
+
+    static inline Vec Load(const ByteUnit* p){
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    }
+    static inline Vec Set1(ByteUnit byte){
+        return _mm_set1_epi8(static_cast<int8_t>(byte));
+    }
+    static inline Mask MaskZero(){
+        return _mm_setzero_si128();
+    }
+    static inline Mask MaskOnes(){
+        return _mm_set1_epi64x(-1LL);
+    }
+    static inline Mask CmpLt(const Mask &k, const Vec &a, const Vec &b){
+        return _mm_and_si128(k, _mm_cmpgt_epi8(b, a));
+    }
+    static inline Mask CmpGt(const Mask &k, const Vec &a, const Vec &b){
+        return _mm_and_si128(k, _mm_cmpgt_epi8(a, b));
+    }
+    static inline Mask CmpEq(const Mask &k, const Vec &a, const Vec &b){
+        return _mm_and_si128(k, _mm_cmpeq_epi8(a, b));
+    }
+    static inline Mask Or(const Mask &a, const Mask &b){
+        return _mm_or_si128(a, b);
+    }
+    static inline Mask And(const Mask &a, const Mask &b){
+        return _mm_and_si128(a, b);
+    }
+    static inline Mask Not(const Mask &a){
+        return _mm_xor_si128(a, MaskOnes());
+    }
+    static inline bool Any(const Mask &k){
+        return !_mm_testz_si128(k, k);
+    }
+    static inline bool AnyIn(const Mask &k, WordUnit bits){
+        return 0 != (bits & ToBits(k));
+    }
+    static inline WordUnit ToBits(const Mask &k){
+        return static_cast<uint32_t>(_mm_movemask_epi8(k));
+    }
+    static inline Vec Broadcast16(const ByteUnit* p){
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    }
+    static inline void Store(ByteUnit* p, const Vec &a){
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), a);
+    }
+    static inline Vec Select(const Mask &k, const Vec &a, const Vec &b){
+        return _mm_blendv_epi8(b, a, k);
+    }
+    static inline Vec MinBytes(const Vec &a, const Vec &b){
+        return _mm_min_epi8(a, b);
+    }
+    static inline Vec MaxBytes(const Vec &a, const Vec &b){
+        return _mm_max_epi8(a, b);
+    }
+    static inline Mask FromBits(WordUnit bits){
+        const __m128i select = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128,
+                                             1, 2, 4, 8, 16, 32, 64, -128);
+        __m128i x = _mm_shuffle_epi8(_mm_cvtsi32_si128(static_cast<int>(bits)),
+                _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1));
+        return _mm_cmpeq_epi8(_mm_and_si128(x, select), select);
+    }
+    static inline WordVec SumBytes(const Mask &k, const Vec &x){
+        const __m128i unflipped = _mm_xor_si128(x, _mm_set1_epi8(-128));
+        return _mm_sad_epu8(_mm_and_si128(k, unflipped), _mm_setzero_si128());
+    }
+    static inline void SplitBytes(const WordUnit* codes, size_t shift, Vec* bytes){
+        //keep the low dword of every code, 4 codes per register
+        __m128i r[4];
+        const __m128i count = _mm_cvtsi32_si128(static_cast<int>(shift));
+        //gather byte b of the 4 codes into dword b
+        const __m128i group = _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13,
+                                            2, 6, 10, 14, 3, 7, 11, 15);
+        for(size_t g = 0; g < 4; g++){
+            const __m128 lo = _mm_castsi128_ps(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(codes + 4*g)));
+            const __m128 hi = _mm_castsi128_ps(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(codes + 4*g + 2)));
+            r[g] = _mm_castps_si128(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)));
+            r[g] = _mm_shuffle_epi8(_mm_sll_epi32(r[g], count), group);
+        }
+        //4x4 transpose of dwords
+        const __m128i t0 = _mm_unpacklo_epi32(r[0], r[1]);
+        const __m128i t1 = _mm_unpacklo_epi32(r[2], r[3]);
+        const __m128i t2 = _mm_unpackhi_epi32(r[0], r[1]);
+        const __m128i t3 = _mm_unpackhi_epi32(r[2], r[3]);
+        const __m128i flip = _mm_set1_epi8(-128);
+        bytes[0] = _mm_xor_si128(_mm_unpacklo_epi64(t0, t1), flip);
+        bytes[1] = _mm_xor_si128(_mm_unpackhi_epi64(t0, t1), flip);
+        bytes[2] = _mm_xor_si128(_mm_unpacklo_epi64(t2, t3), flip);
+        bytes[3] = _mm_xor_si128(_mm_unpackhi_epi64(t2, t3), flip);
+    }
+    static inline Mask InByteSet(const Mask &k, const Vec &x,
+                                const Vec &table_lo, const Vec &table_hi){
+        const __m128i nibble = _mm_set1_epi8(0x0f);
+        const __m128i bit_table = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128,
+                                                1, 2, 4, 8, 16, 32, 64, -128);
+        __m128i lo = _mm_and_si128(x, nibble);
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(x, 4), nibble);
+        __m128i row = _mm_blendv_epi8(_mm_shuffle_epi8(table_lo, lo),
+                                      _mm_shuffle_epi8(table_hi, lo),
+                                      _mm_slli_epi16(hi, 4));
+        __m128i bit = _mm_shuffle_epi8(bit_table, hi);
+        return _mm_and_si128(k, _mm_cmpeq_epi8(_mm_and_si128(row, bit), bit));
+    }
+
+    static inline WordVec LoadWords(const WordUnit* p){
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    }
+    static inline void StoreWords(WordUnit* p, const WordVec &a){
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), a);
+    }
+    static inline WordVec AndWords(const WordVec &a, const WordVec &b){
+        return _mm_and_si128(a, b);
+    }
+    static inline WordVec OrWords(const WordVec &a, const WordVec &b){
+        return _mm_or_si128(a, b);
+    }
+    static inline WordVec ZeroWords(){
+        return _mm_setzero_si128();
+    }
+    static inline WordVec AddWords(const WordVec &a, const WordVec &b){
+        return _mm_add_epi64(a, b);
+    }
+    static inline WordUnit ReduceWords(const WordVec &a){
+        return _mm_cvtsi128_si64(a) + _mm_extract_epi64(a, 1);
+    }
+    static inline WordVec AndNotWords(const WordVec &a, const WordVec &b){
+        return _mm_andnot_si128(b, a);
+    }
+    static inline WordVec XorWords(const WordVec &a, const WordVec &b){
+        return _mm_xor_si128(a, b);
+    }
+    static inline WordVec OnesWords(){
+        return _mm_set1_epi64x(-1LL);
+    }
+    static inline bool AnyWords(const WordVec &a){
+        return !_mm_testz_si128(a, a);
+    }
+    static inline WordVec CountWords(const WordVec &a){
+        const __m128i table = _mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3,
+                                            1, 2, 2, 3, 2, 3, 3, 4);
+        const __m128i nibble = _mm_set1_epi8(0x0f);
+        const __m128i lo = _mm_shuffle_epi8(table, _mm_and_si128(a, nibble));
+        const __m128i hi = _mm_shuffle_epi8(table,
+                _mm_and_si128(_mm_srli_epi16(a, 4), nibble));
+        return _mm_sad_epu8(_mm_add_epi8(lo, hi), _mm_setzero_si128());
+    }
+};
+#pragma GCC pop_options
+
+
+#pragma GCC push_options
+#pragma GCC target("avx2,popcnt")
+struct Avx2Isa{
+    typedef __m256i Vec;
+    typedef __m256i Mask;
+    typedef __m256i WordVec;
+    static constexpr size_t kNumLanes = 32;
+    static constexpr size_t kNumWordsPerVec = 4;
+
+    static inline Vec Load(const ByteUnit* p){
+        return _mm256_lddqu_si256(reinterpret_cast<const __m256i*>(p));
+    }
+    static inline Vec Set1(ByteUnit byte){
+        return avx_set1<ByteUnit>(byte);
+    }
+    static inline Mask MaskZero(){
+        return avx_zero();
+    }
+    static inline Mask MaskOnes(){
+        return avx_ones();
+    }
+    static inline Mask CmpLt(const Mask &k, const Vec &a, const Vec &b){
+        return avx_and(k, avx_cmplt<ByteUnit>(a, b));
+    }
+    static inline Mask CmpGt(const Mask &k, const Vec &a, const Vec &b){
+        return avx_and(k, avx_cmpgt<ByteUnit>(a, b));
+    }
+    static inline Mask CmpEq(const Mask &k, const Vec &a, const Vec &b){
+        return avx_and(k, avx_cmpeq<ByteUnit>(a, b));
+    }
+    static inline Mask Or(const Mask &a, const Mask &b){
+        return avx_or(a, b);
+    }
+    static inline Mask And(const Mask &a, const Mask &b){
+        return avx_and(a, b);
+    }
+    static inline Mask Not(const Mask &a){
+        return avx_not(a);
+    }
+    static inline bool Any(const Mask &k){
+        return !avx_iszero(k);
+    }
+    static inline bool AnyIn(const Mask &k, WordUnit bits){
+        return 0 != (bits & ToBits(k));
+    }
+    static inline WordUnit ToBits(const Mask &k){
+        return static_cast<uint32_t>(_mm256_movemask_epi8(k));
+    }
+    static inline Vec Broadcast16(const ByteUnit* p){
+        return _mm256_broadcastsi128_si256(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+    }
+    static inline void Store(ByteUnit* p, const Vec &a){
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), a);
+    }
+    static inline Vec Select(const Mask &k, const Vec &a, const Vec &b){
+        return _mm256_blendv_epi8(b, a, k);
+    }
+    static inline Vec MinBytes(const Vec &a, const Vec &b){
+        return _mm256_min_epi8(a, b);
+    }
+    static inline Vec MaxBytes(const Vec &a, const Vec &b){
+        return _mm256_max_epi8(a, b);
+    }
+    static inline Mask FromBits(WordUnit bits){
+        const __m256i select = _mm256_set1_epi64x(0x8040201008040201LL);
+        __m256i x = _mm256_shuffle_epi8(_mm256_set1_epi32(static_cast<int>(bits)),
+                _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+                                 2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3));
+        return _mm256_cmpeq_epi8(_mm256_and_si256(x, select), select);
+    }
+    static inline WordVec SumBytes(const Mask &k, const Vec &x){
+        const __m256i unflipped = _mm256_xor_si256(x, _mm256_set1_epi8(-128));
+        return _mm256_sad_epu8(_mm256_and_si256(k, unflipped), _mm256_setzero_si256());
+    }
+    static inline void SplitBytes(const WordUnit* codes, size_t shift, Vec* bytes){
+        //keep the low dword of every code, 8 codes per register
+        __m256i r[4];
+        const __m128i count = _mm_cvtsi32_si128(static_cast<int>(shift));
+        const __m256i low_dwords = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+        //gather byte b of 4 codes into dword b, per 128-bit lane
+        const __m256i group = _mm256_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13,
+                                               2, 6, 10, 14, 3, 7, 11, 15,
+                                               0, 4, 8, 12, 1, 5, 9, 13,
+                                               2, 6, 10, 14, 3, 7, 11, 15);
+        for(size_t g = 0; g < 4; g++){
+            const __m256i lo = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(
+                    reinterpret_cast<const __m256i*>(codes + 8*g)), low_dwords);
+            const __m256i hi = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(
+                    reinterpret_cast<const __m256i*>(codes + 8*g + 4)), low_dwords);
+            r[g] = _mm256_inserti128_si256(lo, _mm256_castsi256_si128(hi), 1);
+            r[g] = _mm256_shuffle_epi8(_mm256_sll_epi32(r[g], count), group);
+        }
+        //4x4 transpose of dwords per lane leaves groups of 4 codes in the
+        //order 0, 2, 4, 6, 1, 3, 5, 7
+        const __m256i t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+        const __m256i t1 = _mm256_unpacklo_epi32(r[2], r[3]);
+        const __m256i t2 = _mm256_unpackhi_epi32(r[0], r[1]);
+        const __m256i t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+        const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+        const __m256i flip = _mm256_set1_epi8(-128);
+        bytes[0] = _mm256_xor_si256(_mm256_permutevar8x32_epi32(
+                    _mm256_unpacklo_epi64(t0, t1), order), flip);
+        bytes[1] = _mm256_xor_si256(_mm256_permutevar8x32_epi32(
+                    _mm256_unpackhi_epi64(t0, t1), order), flip);
+        bytes[2] = _mm256_xor_si256(_mm256_permutevar8x32_epi32(
+                    _mm256_unpacklo_epi64(t2, t3), order), flip);
+        bytes[3] = _mm256_xor_si256(_mm256_permutevar8x32_epi32(
+                    _mm256_unpackhi_epi64(t2, t3), order), flip);
+    }
+    static inline Mask InByteSet(const Mask &k, const Vec &x,
+                                const Vec &table_lo, const Vec &table_hi){
+        const __m256i nibble = _mm256_set1_epi8(0x0f);
+        const __m256i bit_table = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128,
+                                                   1, 2, 4, 8, 16, 32, 64, -128,
+                                                   1, 2, 4, 8, 16, 32, 64, -128,
+                                                   1, 2, 4, 8, 16, 32, 64, -128);
+        __m256i lo = _mm256_and_si256(x, nibble);
+        __m256i hi = _mm256_and_si256(_mm256_srli_epi16(x, 4), nibble);
+        __m256i row = _mm256_blendv_epi8(_mm256_shuffle_epi8(table_lo, lo),
+                                         _mm256_shuffle_epi8(table_hi, lo),
+                                         _mm256_slli_epi16(hi, 4));
+        __m256i bit = _mm256_shuffle_epi8(bit_table, hi);
+        return avx_and(k, _mm256_cmpeq_epi8(_mm256_and_si256(row, bit), bit));
+    }
+
+    static inline WordVec LoadWords(const WordUnit* p){
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    }
+    static inline void StoreWords(WordUnit* p, const WordVec &a){
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), a);
+    }
+    static inline WordVec AndWords(const WordVec &a, const WordVec &b){
+        return avx_and(a, b);
+    }
+    static inline WordVec OrWords(const WordVec &a, const WordVec &b){
+        return avx_or(a, b);
+    }
+    static inline WordVec ZeroWords(){
+        return _mm256_setzero_si256();
+    }
+    static inline WordVec AddWords(const WordVec &a, const WordVec &b){
+        return _mm256_add_epi64(a, b);
+    }
+    static inline WordUnit ReduceWords(const WordVec &a){
+        __m128i x = _mm_add_epi64(_mm256_castsi256_si128(a), _mm256_extracti128_si256(a, 1));
+        return _mm_cvtsi128_si64(x) + _mm_extract_epi64(x, 1);
+    }
+    static inline WordVec AndNotWords(const WordVec &a, const WordVec &b){
+        return _mm256_andnot_si256(b, a);
+    }
+    static inline WordVec XorWords(const WordVec &a, const WordVec &b){
+        return _mm256_xor_si256(a, b);
+    }
+    static inline WordVec OnesWords(){
+        return _mm256_set1_epi64x(-1LL);
+    }
+    static inline bool AnyWords(const WordVec &a){
+        return !_mm256_testz_si256(a, a);
+    }
+    static inline WordVec CountWords(const WordVec &a){
+        const __m256i table = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+                0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4));
+        const __m256i nibble = _mm256_set1_epi8(0x0f);
+        const __m256i lo = _mm256_shuffle_epi8(table, _mm256_and_si256(a, nibble));
+        const __m256i hi = _mm256_shuffle_epi8(table,
+                _mm256_and_si256(_mm256_srli_epi16(a, 4), nibble));
+        return _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256());
+    }
+};
+#pragma GCC pop_options
+
+
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512bw,avx512vl,avx2,popcnt")
+struct Avx512Isa{
+    typedef __m512i Vec;
+    typedef __mmask64 Mask;
+    typedef __m512i WordVec;
+    static constexpr size_t kNumLanes = 64;
+    static constexpr size_t kNumWordsPerVec = 8;
+
+    static inline Vec Load(const ByteUnit* p){
+        return _mm512_loadu_si512(p);
+    }
+    static inline Vec Set1(ByteUnit byte){
+        return avx512_set1_epi8(byte);
+    }
+    static inline Mask MaskZero(){
+        return 0;
+    }
+    static inline Mask MaskOnes(){
+        return static_cast<Mask>(-1ULL);
+    }
+    static inline Mask CmpLt(Mask k, const Vec &a, const Vec &b){
+        return avx512_cmplt_epi8(k, a, b);
+    }
+    static inline Mask CmpGt(Mask k, const Vec &a, const Vec &b){
+        return avx512_cmpgt_epi8(k, a, b);
+    }
+    static inline Mask CmpEq(Mask k, const Vec &a, const Vec &b){
+        return avx512_cmpeq_epi8(k, a, b);
+    }
+    static inline Mask Or(Mask a, Mask b){
+        return a | b;
+    }
+    static inline Mask And(Mask a, Mask b){
+        return a & b;
+    }
+    static inline Mask Not(Mask a){
+        return ~a;
+    }
+    static inline bool Any(Mask k){
+        return !avx512_iszero(k);
+    }
+    static inline bool AnyIn(Mask k, WordUnit bits){
+        return !_ktestz_mask64_u8(k, bits);
+    }
+    static inline WordUnit ToBits(Mask k){
+        return k;
+    }
+    static inline Vec Broadcast16(const ByteUnit* p){
+        //zero-masked: GCC 12 builds the unmasked form over an undefined source
+        return _mm512_maskz_broadcast_i32x4(0xffff,
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+    }
+    static inline void Store(ByteUnit* p, const Vec &a){
+        _mm512_storeu_si512(p, a);
+    }
+    static inline Vec Select(Mask k, const Vec &a, const Vec &b){
+        return _mm512_mask_blend_epi8(k, b, a);
+    }
+    static inline Vec MinBytes(const Vec &a, const Vec &b){
+        return _mm512_min_epi8(a, b);
+    }
+    static inline Vec MaxBytes(const Vec &a, const Vec &b){
+        return _mm512_max_epi8(a, b);
+    }
+    static inline Mask FromBits(WordUnit bits){
+        return bits;
+    }
+    static inline WordVec SumBytes(Mask k, const Vec &x){
+        const __m512i unflipped = _mm512_xor_si512(x, _mm512_set1_epi8(-128));
+        return _mm512_sad_epu8(_mm512_maskz_mov_epi8(k, unflipped), _mm512_setzero_si512());
+    }
+    static inline void SplitBytes(const WordUnit* codes, size_t shift, Vec* bytes){
+        //keep the low dword of every code, 16 codes per register
+        //zero-masked forms with all lanes set: GCC 12 implements the unmasked
+        //ones over an undefined source and -Wuninitialized fires at -O3
+        __m512i r[4];
+        const __m128i count = _mm_cvtsi32_si128(static_cast<int>(shift));
+        for(size_t g = 0; g < 4; g++){
+            const __m256i lo = _mm512_maskz_cvtepi64_epi32(0xff,
+                        _mm512_loadu_si512(codes + 16*g));
+            const __m256i hi = _mm512_maskz_cvtepi64_epi32(0xff,
+                        _mm512_loadu_si512(codes + 16*g + 8));
+            r[g] = _mm512_maskz_sll_epi32(0xffff,
+                        _mm512_maskz_inserti64x4(0xff, _mm512_castsi256_si512(lo), hi, 1),
+                        count);
+        }
+        const __m128i flip = _mm_set1_epi8(-128);
+        for(size_t b = 0; b < 4; b++){
+            const __m128i byte_count = _mm_cvtsi32_si128(static_cast<int>(8*b));
+            __m128i part[4];
+            for(size_t g = 0; g < 4; g++){
+                part[g] = _mm_xor_si128(flip, _mm512_maskz_cvtepi32_epi8(0xffff,
+                            _mm512_maskz_srl_epi32(0xffff, r[g], byte_count)));
+            }
+            __m512i x = _mm512_castsi128_si512(part[0]);
+            x = _mm512_inserti32x4(x, part[1], 1);
+            x = _mm512_inserti32x4(x, part[2], 2);
+            x = _mm512_inserti32x4(x, part[3], 3);
+            bytes[b] = x;
+        }
+    }
+    static inline Mask InByteSet(Mask k, const Vec &x,
+                                const Vec &table_lo, const Vec &table_hi){
+        const __m512i nibble = _mm512_set1_epi8(0x0f);
+        const __m512i bit_table = _mm512_maskz_broadcast_i32x4(0xffff, _mm_setr_epi8(
+                    1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128));
+        __m512i lo = _mm512_and_si512(x, nibble);
+        __m512i hi = _mm512_and_si512(_mm512_srli_epi16(x, 4), nibble);
+        __m512i row = _mm512_mask_blend_epi8(
+                _mm512_test_epi8_mask(hi, _mm512_set1_epi8(0x08)),
+                _mm512_shuffle_epi8(table_lo, lo),
+                _mm512_shuffle_epi8(table_hi, lo));
+        __m512i bit = _mm512_shuffle_epi8(bit_table, hi);
+        return _mm512_mask_test_epi8_mask(k, row, bit);
+    }
+
+    static inline WordVec LoadWords(const WordUnit* p){
+        return _mm512_loadu_si512(p);
+    }
+    static inline void StoreWords(WordUnit* p, const WordVec &a){
+        _mm512_storeu_si512(p, a);
+    }
+    static inline WordVec AndWords(const WordVec &a, const WordVec &b){
+        return _mm512_and_si512(a, b);
+    }
+    static inline WordVec OrWords(const WordVec &a, const WordVec &b){
+        return _mm512_or_si512(a, b);
+    }
+    static inline WordVec ZeroWords(){
+        return _mm512_setzero_si512();
+    }
+    static inline WordVec AddWords(const WordVec &a, const WordVec &b){
+        return _mm512_add_epi64(a, b);
+    }
+    static inline WordUnit ReduceWords(const WordVec &a){
+        //not _mm512_reduce_add_epi64: GCC 12 extracts its halves over an
+        //undefined source, so use the zero-masked extracts
+        const __m256i half = _mm256_add_epi64(_mm512_maskz_extracti64x4_epi64(0xf, a, 0),
+                _mm512_maskz_extracti64x4_epi64(0xf, a, 1));
+        const __m128i quarter = _mm_add_epi64(_mm256_castsi256_si128(half),
+                _mm256_extracti128_si256(half, 1));
+        return _mm_cvtsi128_si64(quarter) + _mm_extract_epi64(quarter, 1);
+    }
+    static inline WordVec AndNotWords(const WordVec &a, const WordVec &b){
+        //zero-masked: GCC 12 builds the unmasked form over an undefined source
+        return _mm512_maskz_andnot_epi64(0xff, b, a);
+    }
+    static inline WordVec XorWords(const WordVec &a, const WordVec &b){
+        return _mm512_xor_si512(a, b);
+    }
+    static inline WordVec OnesWords(){
+        return _mm512_set1_epi64(-1LL);
+    }
+    static inline bool AnyWords(const WordVec &a){
+        return 0 != _mm512_test_epi64_mask(a, a);
+    }
+    static inline WordVec CountWords(const WordVec &a){
+        const __m512i table = _mm512_maskz_broadcast_i32x4(0xffff, _mm_setr_epi8(
+                0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4));
+        const __m512i nibble = _mm512_set1_epi8(0x0f);
+        const __m512i lo = _mm512_shuffle_epi8(table, _mm512_and_si512(a, nibble));
+        const __m512i hi = _mm512_shuffle_epi8(table,
+                _mm512_and_si512(_mm512_srli_epi16(a, 4), nibble));
+        return _mm512_sad_epu8(_mm512_add_epi8(lo, hi), _mm512_setzero_si512());
+    }
+};
+#pragma GCC pop_options
+
+}   // namespace
+
+#endif  //SIMD_ISA_H
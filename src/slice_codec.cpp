@@ -0,0 +1,146 @@
+/*******************************************************************************
+ * Copyright (c) 2015
+ * The Hong Kong Polytechnic University, Database Group
+ *
+ * Author: Ziqiang Feng (cszqfeng AT comp DOT polyu.edu.hk)
+ *
+ * See file LICENSE.md for details.
+ *******************************************************************************/
+#include "slice_codec.h"
+
+#include    <cstring>
+
+namespace byteslice{
+
+static constexpr size_t kMaxPackedValues = 16;
+static constexpr size_t kRunSize = sizeof(ByteUnit) + sizeof(uint32_t);
+
+//bits per code for num_values distinct bytes
+static size_t PackedBits(size_t num_values){
+    return num_values <= 1 ? 0 : (num_values <= 2 ? 1 : (num_values <= 4 ? 2 : 4));
+}
+
+static void EncodeRle(const ByteUnit* data, size_t size, std::vector<char> &payload){
+    for(size_t begin = 0; begin < size;){
+        size_t end = begin + 1;
+        while(end < size && data[end] == data[begin] && end - begin < UINT32_MAX){
+            end++;
+        }
+        const uint32_t length = end - begin;
+        payload.push_back(static_cast<char>(data[begin]));
+        payload.insert(payload.end(), reinterpret_cast<const char*>(&length),
+                reinterpret_cast<const char*>(&length) + sizeof(length));
+        begin = end;
+    }
+}
+
+static void EncodePacked(const ByteUnit* data, size_t size, const bool* present,
+        std::vector<char> &payload){
+    ByteUnit code[256];
+    std::vector<char> dictionary;
+    for(size_t value = 0; value < 256; value++){
+        if(present[value]){
+            code[value] = dictionary.size();
+            dictionary.push_back(static_cast<char>(value));
+        }
+    }
+    payload.push_back(static_cast<char>(dictionary.size()));
+    payload.insert(payload.end(), dictionary.begin(), dictionary.end());
+    const size_t bits = PackedBits(dictionary.size());
+    if(0 == bits){
+        return;
+    }
+    const size_t codes_per_byte = 8 / bits;
+    for(size_t pos = 0; pos < size; pos += codes_per_byte){
+        ByteUnit packed = 0;
+        for(size_t i = 0; i < codes_per_byte && pos + i < size; i++){
+            packed |= code[data[pos + i]] << (i * bits);
+        }
+        payload.push_back(static_cast<char>(packed));
+    }
+}
+
+SliceCodec EncodeSlice(const ByteUnit* data, size_t size, std::vector<char> &payload){
+    bool present[256] = {false};
+    size_t num_values = 0;
+    size_t num_runs = 0;
+    for(size_t pos = 0; pos < size; pos++){
+        num_runs += (0 == pos || data[pos] != data[pos - 1]);
+        num_values += !present[data[pos]];
+        present[data[pos]] = true;
+    }
+
+    const size_t raw_size = size;
+    const size_t rle_size = num_runs * kRunSize;
+    const size_t packed_size = num_values > kMaxPackedValues ? SIZE_MAX :
+        1 + num_values + (size * PackedBits(num_values) + 7) / 8;
+
+    payload.clear();
+    if(packed_size < raw_size && packed_size <= rle_size){
+        EncodePacked(data, size, present, payload);
+        return SliceCodec::kPacked;
+    }
+    if(rle_size < raw_size){
+        EncodeRle(data, size, payload);
+        return SliceCodec::kRle;
+    }
+    payload.assign(reinterpret_cast<const char*>(data),
+            reinterpret_cast<const char*>(data) + size);
+    return SliceCodec::kRaw;
+}
+
+bool DecodeSlice(SliceCodec codec, const char* payload, size_t payload_size,
+        ByteUnit* data, size_t size){
+    switch(codec){
+        case SliceCodec::kRaw:
+            if(payload_size != size){
+                return false;
+            }
+            memcpy(data, payload, size);
+            return true;
+        case SliceCodec::kRle:{
+            size_t pos = 0;
+            for(size_t offset = 0; offset + kRunSize <= payload_size; offset += kRunSize){
+                uint32_t length;
+                memcpy(&length, payload + offset + 1, sizeof(length));
+                if(pos + length > size){
+                    return false;
+                }
+                memset(data + pos, static_cast<ByteUnit>(payload[offset]), length);
+                pos += length;
+            }
+            return pos == size && 0 == payload_size % kRunSize;
+        }
+        case SliceCodec::kPacked:{
+            if(payload_size < 1){
+                return false;
+            }
+            const size_t num_values = static_cast<ByteUnit>(payload[0]);
+            const size_t bits = PackedBits(num_values);
+            if(0 == num_values || num_values > kMaxPackedValues ||
+                    payload_size != 1 + num_values + (size * bits + 7) / 8){
+                return false;
+            }
+            const ByteUnit* dictionary = reinterpret_cast<const ByteUnit*>(payload + 1);
+            if(0 == bits){
+                memset(data, dictionary[0], size);
+                return true;
+            }
+            const ByteUnit* packed = dictionary + num_values;
+            const size_t codes_per_byte = 8 / bits;
+            const ByteUnit code_mask = (1 << bits) - 1;
+            for(size_t pos = 0; pos < size; pos++){
+                const size_t code = (packed[pos / codes_per_byte] >>
+                        ((pos % codes_per_byte) * bits)) & code_mask;
+                if(code >= num_values){
+                    return false;
+                }
+                data[pos] = dictionary[code];
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+}   // namespace
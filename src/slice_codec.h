@@ -0,0 +1,43 @@
+/*******************************************************************************
+ * Copyright (c) 2015
+ * The Hong Kong Polytechnic University, Database Group
+ *
+ * Author: Ziqiang Feng (cszqfeng AT comp DOT polyu.edu.hk)
+ *
+ * See file LICENSE.md for details.
+ *******************************************************************************/
+#ifndef SLICE_CODEC_H
+#define SLICE_CODEC_H
+
+#include    <cstddef>
+#include    <vector>
+
+#include "../src/types.h"
+
+namespace byteslice{
+
+/**
+  Compression of one byte slice for cold storage.
+  High-order slices often hold few distinct bytes or long runs:
+    kRle:    (byte, uint32 run length) pairs
+    kPacked: a dictionary of at most 16 bytes, then 1, 2 or 4 bit codes
+             (no codes at all for a single distinct byte)
+    kRaw:    the bytes as they are
+  EncodeSlice picks the codec with the smallest encoded size, estimated
+  in a single pass over the slice.
+*/
+enum class SliceCodec : uint8_t{
+    kRaw,
+    kRle,
+    kPacked
+};
+
+SliceCodec EncodeSlice(const ByteUnit* data, size_t size, std::vector<char> &payload);
+
+//decodes payload into exactly size bytes at data; false on malformed input
+bool DecodeSlice(SliceCodec codec, const char* payload, size_t payload_size,
+        ByteUnit* data, size_t size);
+
+}   // namespace
+
+#endif  //SLICE_CODEC_H
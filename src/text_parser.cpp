@@ -0,0 +1,129 @@
+/*******************************************************************************
+ * Copyright (c) 2015
+ * The Hong Kong Polytechnic University, Database Group
+ *
+ * Author: Ziqiang Feng (cszqfeng AT comp DOT polyu.edu.hk)
+ *
+ * See file LICENSE.md for details.
+ *******************************************************************************/
+#include "text_parser.h"
+
+#include "macros.h"
+
+namespace byteslice{
+
+static constexpr size_t kNumBlockBytes = 16;
+
+static inline bool IsDigit(char c){
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+//bit i is set iff p[i] is a digit
+TARGET_SSE42 static inline uint32_t DigitBits(const char* p){
+    const __m128i x = _mm_sub_epi8(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), _mm_set1_epi8('0'));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(x, _mm_set1_epi8(9)), x));
+}
+
+//bit i is set iff a value starts at p[i]; prev_digit: whether p[-1] is a digit
+static inline uint32_t StartBits(uint32_t digits, bool prev_digit){
+    return digits & ~((digits << 1) | (prev_digit ? 1 : 0));
+}
+
+//Value of the len (< 16) digits at p; p[0..15] must be readable.
+//The digits are moved to the end of a register, then combined pairwise.
+TARGET_SSE42 static inline WordUnit ParseDigits(const char* p, size_t len){
+    static const int8_t kAlign[32] = {
+        -128, -128, -128, -128, -128, -128, -128, -128,
+        -128, -128, -128, -128, -128, -128, -128, -128,
+        0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
+    __m128i x = _mm_sub_epi8(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), _mm_set1_epi8('0'));
+    x = _mm_shuffle_epi8(x, _mm_loadu_si128(reinterpret_cast<const __m128i*>(kAlign + len)));
+    //2, 4 and 8 digits per lane
+    x = _mm_maddubs_epi16(x, _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1,
+                                            10, 1, 10, 1, 10, 1, 10, 1));
+    x = _mm_madd_epi16(x, _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1));
+    x = _mm_packus_epi32(x, x);
+    x = _mm_madd_epi16(x, _mm_setr_epi16(10000, 1, 10000, 1, 10000, 1, 10000, 1));
+    return static_cast<WordUnit>(static_cast<uint32_t>(_mm_cvtsi128_si32(x))) * 100000000ULL +
+        static_cast<uint32_t>(_mm_extract_epi32(x, 1));
+}
+
+TARGET_SSE42 size_t CountIntegers(const char* begin, const char* end){
+    size_t count = 0;
+    bool prev_digit = false;
+    const char* p = begin;
+    for(; p + kNumBlockBytes <= end; p += kNumBlockBytes){
+        const uint32_t digits = DigitBits(p);
+        count += __builtin_popcount(StartBits(digits, prev_digit));
+        prev_digit = (digits >> (kNumBlockBytes - 1)) & 1;
+    }
+    for(; p < end; p++){
+        const bool digit = IsDigit(*p);
+        count += digit && !prev_digit;
+        prev_digit = digit;
+    }
+    return count;
+}
+
+TARGET_SSE42 const char* SkipIntegers(const char* begin, const char* end, size_t num){
+    bool prev_digit = false;
+    const char* p = begin;
+    for(; p + kNumBlockBytes <= end; p += kNumBlockBytes){
+        const uint32_t digits = DigitBits(p);
+        uint32_t starts = StartBits(digits, prev_digit);
+        const size_t n = __builtin_popcount(starts);
+        if(n > num){
+            for(; num > 0; num--){
+                starts &= starts - 1;
+            }
+            return p + __builtin_ctz(starts);
+        }
+        num -= n;
+        prev_digit = (digits >> (kNumBlockBytes - 1)) & 1;
+    }
+    for(; p < end; p++){
+        const bool digit = IsDigit(*p);
+        if(digit && !prev_digit){
+            if(0 == num){
+                return p;
+            }
+            num--;
+        }
+        prev_digit = digit;
+    }
+    return end;
+}
+
+TARGET_SSE42 size_t ParseIntegers(const char* begin, const char* end, WordUnit* values,
+        size_t num, const char** stop){
+    const char* p = begin;
+    size_t count = 0;
+    while(count < num){
+        while(p < end && !IsDigit(*p)){
+            p++;
+        }
+        if(p == end){
+            break;
+        }
+        const size_t len = (p + kNumBlockBytes <= end) ?
+            __builtin_ctz(~DigitBits(p) | (1U << kNumBlockBytes)) : kNumBlockBytes;
+        WordUnit value = 0;
+        if(len < kNumBlockBytes){
+            value = ParseDigits(p, len);
+            p += len;
+        }
+        else{
+            //long value or close to the end
+            for(; p < end && IsDigit(*p); p++){
+                value = value * 10 + (*p - '0');
+            }
+        }
+        values[count++] = value;
+    }
+    *stop = p;
+    return count;
+}
+
+}   // namespace
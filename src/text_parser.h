@@ -0,0 +1,39 @@
+/*******************************************************************************
+ * Copyright (c) 2015
+ * The Hong Kong Polytechnic University, Database Group
+ *
+ * Author: Ziqiang Feng (cszqfeng AT comp DOT polyu.edu.hk)
+ *
+ * See file LICENSE.md for details.
+ *******************************************************************************/
+#ifndef TEXT_PARSER_H
+#define TEXT_PARSER_H
+
+#include    <cstddef>
+
+#include "../src/types.h"
+
+namespace byteslice{
+
+/**
+  Unsigned integers in text, for the parallel loaders.
+  A value is a maximal run of decimal digits; any other byte separates
+  values. begin must not point into the middle of a value.
+  Digit runs are located 16 bytes at a time, and values of up to 15
+  digits are converted in SIMD registers.
+*/
+
+//number of values in [begin, end)
+size_t CountIntegers(const char* begin, const char* end);
+
+//start of value number num (counting from 0) in [begin, end), or end
+const char* SkipIntegers(const char* begin, const char* end, size_t num);
+
+//parses up to num values into values, returns how many were parsed;
+//*stop is where parsing stopped
+size_t ParseIntegers(const char* begin, const char* end, WordUnit* values,
+        size_t num, const char** stop);
+
+}   // namespace
+
+#endif  //TEXT_PARSER_H
@@ -51,5 +51,46 @@ std::ostream& operator<< (std::ostream &out, Comparator comp){
     return out;
 }
 
+std::ostream& operator<< (std::ostream &out, SimdLevel level){
+    switch(level){
+        case SimdLevel::kSSE42:
+            out << "SSE4.2";
+            break;
+        case SimdLevel::kAVX2:
+            out << "AVX2";
+            break;
+        case SimdLevel::kAVX512:
+            out << "AVX512";
+            break;
+    }
+    return out;
+}
+
+std::ostream& operator<< (std::ostream &out, EarlyStop policy){
+    switch(policy){
+        case EarlyStop::kAlways:
+            out << "always";
+            break;
+        case EarlyStop::kNever:
+            out << "never";
+            break;
+        case EarlyStop::kAdaptive:
+            out << "adaptive";
+            break;
+    }
+    return out;
+}
+
+std::ostream& operator<< (std::ostream &out, Compression compression){
+    switch(compression){
+        case Compression::kNone:
+            out << "none";
+            break;
+        case Compression::kAuto:
+            out << "auto";
+            break;
+    }
+    return out;
+}
 
 }   // namespace
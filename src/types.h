@@ -22,6 +22,10 @@ typedef __m256i AvxUnit;
 constexpr size_t kNumWordBits = 8*sizeof(WordUnit);
 constexpr size_t kNumAvxBits = 8*sizeof(AvxUnit);
 
+typedef __m512i Avx512Unit;
+typedef __mmask64 Avx512Mask;   // one bit per byte lane
+constexpr size_t kNumAvx512Bits = 8*sizeof(Avx512Unit);
+
 enum class ColumnType{
     kNaive,
     kByteSlicePadRight,
@@ -49,10 +53,34 @@ enum class Direction{
     kRight
 };
 
+// Instruction set used by scan, bit vector and bulk-load kernels.
+// Ordered from the lowest to the highest.
+enum class SimdLevel{
+    kSSE42,
+    kAVX2,
+    kAVX512
+};
+
+// Whether ByteSlice scans stop comparing once no lane can change.
+enum class EarlyStop{
+    kAlways,
+    kNever,
+    kAdaptive   // chosen per stride from sampled stop rates
+};
+
+// Byte slice encoding in serialized blocks.
+enum class Compression{
+    kNone,
+    kAuto       // cheapest codec per slice (see slice_codec.h)
+};
+
 
 //for debug use
 std::ostream& operator<< (std::ostream &out, ColumnType type);
 std::ostream& operator<< (std::ostream &out, Comparator comp);
+std::ostream& operator<< (std::ostream &out, SimdLevel level);
+std::ostream& operator<< (std::ostream &out, EarlyStop policy);
+std::ostream& operator<< (std::ostream &out, Compression compression);
 
 }   // namespace
 
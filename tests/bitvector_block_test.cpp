@@ -8,8 +8,11 @@
  *******************************************************************************/
 #include "../src/bitvector_block.h"
 
+#include    <cstdlib>
 #include    <iostream>
+#include    <vector>
 
+#include "../src/cpu_features.h"
 #include "../src/macros.h"
 #include "../src/param.h"
 #include "../src/types.h"
@@ -89,6 +92,138 @@ TEST_F(BitVectorBlockTest, AndOr){
     delete block2;
 }
 
+TEST_F(BitVectorBlockTest, Algebra){
+    //a tail that wide vectors leave to the scalar loop
+    const size_t num = kNumTuplesPerBlock - 300;
+    const size_t num_inputs = 5;
+    std::vector<BitVectorBlock*> inputs;
+    for(size_t j=0; j < num_inputs; j++){
+        inputs.push_back(new BitVectorBlock(num));
+        for(size_t w=0; w < inputs[j]->num_word_units(); w++){
+            //mostly ones, so that the AND of all stays non-zero
+            inputs[j]->SetWordUnit(~(WordUnit(std::rand()) << (j * 7 % 40)), w);
+        }
+        inputs[j]->ClearTail();
+    }
+    //a region where the AND of all becomes zero early
+    for(size_t w=1000; w < 3000; w++){
+        inputs[1]->SetWordUnit(0, w);
+    }
+    BitVectorBlock* a = inputs[0];
+    BitVectorBlock* b = inputs[2];
+    BitVectorBlock* result = new BitVectorBlock(num);
+
+    const SimdLevel levels[] = {SimdLevel::kSSE42, SimdLevel::kAVX2, SimdLevel::kAVX512};
+    for(SimdLevel level : levels){
+        if(!SetSimdLevel(level)){
+            continue;
+        }
+        size_t expected_a = 0;
+        size_t expected_and = 0;
+        for(size_t i=0; i < num; i++){
+            expected_a += a->GetBit(i);
+            expected_and += a->GetBit(i) && b->GetBit(i);
+        }
+        EXPECT_EQ(expected_a, a->CountOnes()) << level;
+        EXPECT_EQ(expected_and, a->AndCount(b)) << level;
+
+        result->Set(a);
+        result->AndNot(b);
+        for(size_t i=0; i < num; i++){
+            ASSERT_EQ(a->GetBit(i) && !b->GetBit(i), result->GetBit(i)) << level << " " << i;
+        }
+        result->Set(a);
+        result->Xor(b);
+        for(size_t i=0; i < num; i++){
+            ASSERT_EQ(a->GetBit(i) != b->GetBit(i), result->GetBit(i)) << level << " " << i;
+        }
+        result->Set(a);
+        result->Not();
+        EXPECT_EQ(num - expected_a, result->CountOnes()) << level;
+        for(size_t i=0; i < num; i++){
+            ASSERT_EQ(!a->GetBit(i), result->GetBit(i)) << level << " " << i;
+        }
+
+        result->SetOnes();
+        result->AndAll(inputs.data(), num_inputs);
+        for(size_t i=0; i < num; i++){
+            bool expected = true;
+            for(BitVectorBlock* input : inputs){
+                expected = expected && input->GetBit(i);
+            }
+            ASSERT_EQ(expected, result->GetBit(i)) << level << " " << i;
+        }
+        result->SetZeros();
+        result->OrAll(inputs.data() + 1, num_inputs - 1);
+        for(size_t i=0; i < num; i++){
+            bool expected = false;
+            for(size_t j=1; j < num_inputs; j++){
+                expected = expected || inputs[j]->GetBit(i);
+            }
+            ASSERT_EQ(expected, result->GetBit(i)) << level << " " << i;
+        }
+        //padding stays clear
+        for(size_t w = num / kNumWordBits + 1; w < result->num_word_units(); w++){
+            ASSERT_EQ(0UL, result->GetWordUnit(w)) << level;
+        }
+    }
+    SetSimdLevel(DetectSimdLevel());
+
+    delete result;
+    for(BitVectorBlock* input : inputs){
+        delete input;
+    }
+}
+
+TEST_F(BitVectorBlockTest, Summary){
+    const size_t run_bits = BitVectorBlock::kNumSummaryRunWords * kNumWordBits;
+    BitVectorBlock* block = new BitVectorBlock(kNumTuplesPerBlock - 100);
+    BitVectorBlock* other = new BitVectorBlock(kNumTuplesPerBlock - 100);
+    block->SetZeros();
+    block->EnableSummary();
+    EXPECT_TRUE(block->has_summary());
+    EXPECT_EQ(block->num_word_units(), block->NextLiveWord(0));
+
+    //ones in runs 3 and 5 only
+    block->SetBit(3 * run_bits + 10);
+    block->SetWordUnit(0xf0, 5 * BitVectorBlock::kNumSummaryRunWords + 7);
+    EXPECT_EQ(3 * BitVectorBlock::kNumSummaryRunWords, block->NextLiveWord(0));
+    EXPECT_EQ(5 * BitVectorBlock::kNumSummaryRunWords,
+            block->NextLiveWord(4 * BitVectorBlock::kNumSummaryRunWords));
+    EXPECT_EQ(3 * BitVectorBlock::kNumSummaryRunWords + 1,
+            block->NextLiveWord(3 * BitVectorBlock::kNumSummaryRunWords + 1));
+    std::vector<size_t> ranges;
+    block->ForEachLiveRange([&](size_t begin_word, size_t num_words){
+        ranges.push_back(begin_word);
+        ranges.push_back(num_words);
+    });
+    const std::vector<size_t> expected_ranges = {
+        3 * BitVectorBlock::kNumSummaryRunWords, BitVectorBlock::kNumSummaryRunWords,
+        5 * BitVectorBlock::kNumSummaryRunWords, BitVectorBlock::kNumSummaryRunWords};
+    EXPECT_EQ(expected_ranges, ranges);
+    EXPECT_EQ(5UL, block->CountOnes());
+
+    //an AND only visits live runs, and marks runs it empties dead
+    other->SetOnes();
+    other->UnsetBit(3 * run_bits + 10);
+    EXPECT_EQ(4UL, block->AndCount(other));
+    block->And(other);
+    EXPECT_EQ(4UL, block->CountOnes());
+    EXPECT_EQ(5 * BitVectorBlock::kNumSummaryRunWords, block->NextLiveWord(0));
+
+    //writes through data() are picked up by UpdateSummary
+    block->data()[100] = 1;
+    block->UpdateSummary();
+    EXPECT_EQ(BitVectorBlock::kNumSummaryRunWords, block->NextLiveWord(0));
+    EXPECT_EQ(5UL, block->CountOnes());
+    block->Not();
+    EXPECT_EQ(block->num() - 5, block->CountOnes());
+    EXPECT_EQ(0UL, block->NextLiveWord(0));
+
+    delete other;
+    delete block;
+}
+
 TEST_F(BitVectorBlockTest, SetAvxUnit){
     BitVectorBlock* block1 = new BitVectorBlock(kNumTuplesPerBlock);
     block1->SetZeros();
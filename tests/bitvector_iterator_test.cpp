@@ -10,6 +10,7 @@
 
 #include    "gtest/gtest.h"
 #include    <cstdlib>
+#include    <vector>
 
 namespace byteslice{
 
@@ -77,4 +78,51 @@ TEST_F(BitVectorIteratorTest, AllOnes){
     delete itor;
 }
 
+TEST_F(BitVectorIteratorTest, NextBatch){
+    //dense and sparse regions
+    bitvector_->SetZeros();
+    std::vector<uint64_t> expected;
+    for(size_t i=0; i < num_; i++){
+        const bool dense = (i / 100000) % 2;
+        if(dense ? 0 != std::rand() % 3 : 0 == std::rand() % 5000){
+            bitvector_->SetBit(i);
+            expected.push_back(i);
+        }
+    }
+
+    //batch sizes below and above a word, mixed with Next
+    const size_t batch_sizes[] = {1, 7, 64, 1000, 100000};
+    for(size_t max : batch_sizes){
+        BitVectorIterator* itor = new BitVectorIterator(bitvector_);
+        std::vector<uint64_t> actual;
+        std::vector<uint32_t> batch(max);
+        for(size_t round = 0; ; round++){
+            if(2 == round % 3){
+                if(!itor->Next()){
+                    break;
+                }
+                actual.push_back(itor->GetPosition());
+                continue;
+            }
+            const size_t count = itor->NextBatch(batch.data(), max);
+            ASSERT_LE(count, max);
+            actual.insert(actual.end(), batch.begin(), batch.begin() + count);
+            if(0 == count){
+                EXPECT_FALSE(itor->Next());
+                break;
+            }
+        }
+        EXPECT_EQ(expected, actual) << max;
+        delete itor;
+    }
+
+    BitVectorIterator* itor = new BitVectorIterator(bitvector_);
+    std::vector<uint64_t> all(num_);
+    EXPECT_EQ(expected.size(), itor->NextBatch(all.data(), num_));
+    all.resize(expected.size());
+    EXPECT_EQ(expected, all);
+    EXPECT_EQ(0U, itor->NextBatch(all.data(), num_));
+    delete itor;
+}
+
 }   // namespace
@@ -8,6 +8,8 @@
  *******************************************************************************/
 #include "../src/bitvector.h"
 
+#include    <vector>
+
 #include "../src/macros.h"
 #include "../src/param.h"
 #include "../src/types.h"
@@ -39,5 +41,50 @@ TEST_F(BitVectorTest, Ctor){
     delete bitvector;
 }
 
+TEST_F(BitVectorTest, Algebra){
+    std::vector<BitVector*> inputs;
+    for(size_t j=0; j < 4; j++){
+        BitVector* bitvector = new BitVector(num_);
+        bitvector->SetZeros();
+        for(size_t i=j; i < num_; i += j + 2){
+            bitvector->SetBit(i);
+        }
+        inputs.push_back(bitvector);
+    }
+    const std::vector<const BitVector*> others(inputs.begin() + 1, inputs.end());
+
+    //n-ary combination gives the same as one pairwise step per input
+    BitVector* all = new BitVector(num_);
+    BitVector* pairwise = new BitVector(num_);
+    all->SetOnes();
+    all->AndAll(others);
+    for(const BitVector* other : others){
+        pairwise->And(other);
+    }
+    EXPECT_EQ(pairwise->CountOnes(), all->CountOnes());
+    EXPECT_EQ(pairwise->AndCount(all), all->CountOnes());
+    all->SetZeros();
+    all->OrAll(others);
+    pairwise->SetZeros();
+    for(const BitVector* other : others){
+        pairwise->Or(other);
+    }
+    pairwise->Xor(all);
+    EXPECT_EQ(0UL, pairwise->CountOnes());
+
+    //a & ~b and a & b partition a
+    size_t count_and = inputs[0]->AndCount(inputs[1]);
+    inputs[0]->AndNot(inputs[1]);
+    EXPECT_EQ(0UL, inputs[0]->AndCount(inputs[1]));
+    EXPECT_EQ(CEIL(num_, 2), count_and + inputs[0]->CountOnes());
+    inputs[0]->Not();
+    EXPECT_EQ(num_ - (CEIL(num_, 2) - count_and), inputs[0]->CountOnes());
+
+    delete pairwise;
+    delete all;
+    for(BitVector* input : inputs){
+        delete input;
+    }
+}
 
 }   // namespace
@@ -7,12 +7,16 @@
  * See file LICENSE.md for details.
  *******************************************************************************/
 
+#include    <algorithm>
 #include	<cstdio>
 #include    <cstdlib>
+#include    <set>
+#include    <vector>
 
 #include 	"gtest/gtest.h"
 #include 	"src/byteslice_column_block.h"
 #include 	"src/bitvector_block.h"
+#include 	"src/cpu_features.h"
 
 namespace byteslice{
 
@@ -61,6 +65,8 @@ TEST_F(ByteSliceColumnBlockTest, SerDeser){
     for(size_t i=0; i<num_; i++){
         EXPECT_EQ(block_->GetTuple(i), block2->GetTuple(i));
     }
+    EXPECT_EQ(block_->min_value(), block2->min_value());
+    EXPECT_EQ(block_->max_value(), block2->max_value());
 
     delete block2;
     std::remove(filename.c_str());
@@ -72,6 +78,100 @@ TEST_F(ByteSliceColumnBlockTest, BulkLoadAndGetTuple){
     }
 }
 
+TEST_F(ByteSliceColumnBlockTest, ZoneMap){
+    EXPECT_EQ(0ULL, block_->min_value());
+    EXPECT_EQ(num_ - 1, block_->max_value());
+    EXPECT_EQ(BlockMatch::kAll, block_->Match(Comparator::kLess, num_));
+    EXPECT_EQ(BlockMatch::kNone, block_->Match(Comparator::kGreater, num_ - 1));
+    EXPECT_EQ(BlockMatch::kSome, block_->Match(Comparator::kEqual, 100));
+    EXPECT_EQ(BlockMatch::kAll, block_->Match(Comparator::kInequal, num_ + 5));
+    EXPECT_EQ(BlockMatch::kNone, block_->MatchBetween(num_, num_ + 100));
+    EXPECT_EQ(BlockMatch::kAll, block_->MatchBetween(0, num_));
+
+    //updates only widen the bounds
+    block_->SetTuple(10, (1ULL << 20) - 1);
+    EXPECT_EQ((1ULL << 20) - 1, block_->max_value());
+    block_->SetTuple(10, 10);
+    EXPECT_EQ((1ULL << 20) - 1, block_->max_value());
+
+    //a grown block covers the zeroed tuples
+    ByteSliceColumnBlock<20>* block2 = new ByteSliceColumnBlock<20>(0);
+    block2->Resize(100);
+    const WordUnit codes[] = {500, 700, 600};
+    block2->BulkLoadArray(codes, 3);
+    EXPECT_EQ(0ULL, block2->min_value());
+    EXPECT_EQ(700ULL, block2->max_value());
+    delete block2;
+}
+
+TEST_F(ByteSliceColumnBlockTest, Imprints){
+    //shuffle within runs of 256 tuples: strides are clustered but not sorted
+    for(size_t i=0; i < num_; i++){
+        block_->SetTuple(i, (i & ~255ULL) | ((i * 37) & 255));
+    }
+    block_->BuildImprints();
+    ASSERT_TRUE(block_->HasImprints());
+    block_->SetTuple(5000, 7);      //an update after building
+    EXPECT_NE(0ULL, block_->GetImprint(5000 / 64) & 1ULL);
+
+    const Comparator comparators[] = {Comparator::kLess, Comparator::kLessEqual,
+        Comparator::kGreater, Comparator::kGreaterEqual,
+        Comparator::kEqual, Comparator::kInequal};
+    const WordUnit literals[] = {7, 5000, num_ / 2 + 3};
+    BitVectorBlock* bvblock = new BitVectorBlock(num_);
+    for(Comparator comparator : comparators){
+        for(WordUnit literal : literals){
+            block_->Scan(comparator, literal, bvblock);
+            size_t num_wrong = 0;
+            for(size_t i=0; i < num_; i++){
+                WordUnit value = block_->GetTuple(i);
+                bool expected = false;
+                switch(comparator){
+                    case Comparator::kLess:
+                        expected = value < literal;
+                        break;
+                    case Comparator::kLessEqual:
+                        expected = value <= literal;
+                        break;
+                    case Comparator::kGreater:
+                        expected = value > literal;
+                        break;
+                    case Comparator::kGreaterEqual:
+                        expected = value >= literal;
+                        break;
+                    case Comparator::kEqual:
+                        expected = value == literal;
+                        break;
+                    case Comparator::kInequal:
+                        expected = value != literal;
+                        break;
+                }
+                num_wrong += (expected != bvblock->GetBit(i));
+            }
+            EXPECT_EQ(0UL, num_wrong) << comparator << " " << literal;
+        }
+    }
+    delete bvblock;
+
+    //imprints travel with the block
+    std::string filename(std::tmpnam(nullptr));
+    SequentialWriteBinaryFile outfile;
+    outfile.Open(filename);
+    block_->SerToFile(outfile);
+    outfile.Close();
+    ByteSliceColumnBlock<20>* block2 = new ByteSliceColumnBlock<20>(num_);
+    SequentialReadBinaryFile infile;
+    infile.Open(filename);
+    block2->DeserFromFile(infile);
+    infile.Close();
+    ASSERT_TRUE(block2->HasImprints());
+    for(size_t s=0; s < CEIL(num_, 64); s++){
+        EXPECT_EQ(block_->GetImprint(s), block2->GetImprint(s));
+    }
+    delete block2;
+    std::remove(filename.c_str());
+}
+
 TEST_F(ByteSliceColumnBlockTest, ScanLiteral){
     BitVectorBlock* bvblock = new BitVectorBlock(num_);
 
@@ -101,4 +201,320 @@ TEST_F(ByteSliceColumnBlockTest, ScanOtherBlock){
     delete bvblock;
 }
 
+TEST_F(ByteSliceColumnBlockTest, ScanAllComparators){
+    const Comparator comparators[] = {Comparator::kEqual, Comparator::kInequal,
+        Comparator::kLess, Comparator::kGreater,
+        Comparator::kLessEqual, Comparator::kGreaterEqual};
+    const Bitwise opts[] = {Bitwise::kSet, Bitwise::kAnd, Bitwise::kOr};
+
+    BitVectorBlock* bvblock = new BitVectorBlock(num_);
+    ByteSliceColumnBlock<20>* block2 = new ByteSliceColumnBlock<20>(num_);
+    std::srand(std::time(0));
+    for(size_t i=0; i < num_; i++){
+        //keep many ties so that every byte slice gets compared
+        block2->SetTuple(i, (i & 0x7) ? std::rand() % num_ : i);
+    }
+    //a fixed input pattern for kAnd/kOr
+    auto input_bit = [](size_t i){ return (i % 3) == 0; };
+    auto compare = [](Comparator cmp, WordUnit a, WordUnit b){
+        switch(cmp){
+            case Comparator::kEqual:        return a == b;
+            case Comparator::kInequal:      return a != b;
+            case Comparator::kLess:         return a < b;
+            case Comparator::kGreater:      return a > b;
+            case Comparator::kLessEqual:    return a <= b;
+            case Comparator::kGreaterEqual: return a >= b;
+        }
+        return false;
+    };
+
+    const WordUnit lit = std::rand() % num_;
+    const SimdLevel levels[] = {SimdLevel::kSSE42, SimdLevel::kAVX2, SimdLevel::kAVX512};
+    for(SimdLevel level : levels){
+        if(!SetSimdLevel(level)){
+            continue;
+        }
+        for(Comparator cmp : comparators){
+        for(Bitwise opt : opts){
+            for(int against_block = 0; against_block < 2; against_block++){
+                bvblock->SetZeros();
+                for(size_t i=0; i < num_; i++){
+                    if(input_bit(i)){
+                        bvblock->SetBit(i);
+                    }
+                }
+                if(against_block){
+                    block_->Scan(cmp, block2, bvblock, opt);
+                }
+                else{
+                    block_->Scan(cmp, lit, bvblock, opt);
+                }
+                size_t num_wrong = 0;
+                for(size_t i=0; i < num_; i++){
+                    WordUnit other = against_block ? block2->GetTuple(i) : lit;
+                    bool expected = compare(cmp, block_->GetTuple(i), other);
+                    if(Bitwise::kAnd == opt){
+                        expected = expected && input_bit(i);
+                    }
+                    else if(Bitwise::kOr == opt){
+                        expected = expected || input_bit(i);
+                    }
+                    num_wrong += (expected != bvblock->GetBit(i));
+                }
+                EXPECT_EQ(0UL, num_wrong) << level << " " << cmp << " "
+                    << static_cast<int>(opt)
+                    << (against_block ? " other block" : " literal");
+            }
+        }
+        }
+    }
+    SetSimdLevel(DetectSimdLevel());
+
+    delete block2;
+    delete bvblock;
+}
+
+TEST_F(ByteSliceColumnBlockTest, ScanBetween){
+    const Bitwise opts[] = {Bitwise::kSet, Bitwise::kAnd, Bitwise::kOr};
+    const SimdLevel levels[] = {SimdLevel::kSSE42, SimdLevel::kAVX2, SimdLevel::kAVX512};
+    BitVectorBlock* bvblock = new BitVectorBlock(num_);
+    auto input_bit = [](size_t i){ return (i % 5) == 0; };
+
+    std::srand(std::time(0));
+    WordUnit bounds[][2] = {
+        {0, 0},
+        {std::rand() % num_, 0},   //upper set below
+        {num_ / 3, num_ / 3 + 256},   //bounds share their high bytes
+        {num_ / 2, num_ * 4},      //upper beyond the values
+        {300, 200},                //empty
+    };
+    bounds[1][1] = bounds[1][0] + std::rand() % 100000;
+
+    for(SimdLevel level : levels){
+        if(!SetSimdLevel(level)){
+            continue;
+        }
+        for(auto &b : bounds){
+            for(Bitwise opt : opts){
+                bvblock->SetZeros();
+                for(size_t i=0; i < num_; i++){
+                    if(input_bit(i)){
+                        bvblock->SetBit(i);
+                    }
+                }
+                block_->ScanBetween(b[0], b[1], bvblock, opt);
+                size_t num_wrong = 0;
+                for(size_t i=0; i < num_; i++){
+                    bool expected = (b[0] <= i) && (i <= b[1]);
+                    if(Bitwise::kAnd == opt){
+                        expected = expected && input_bit(i);
+                    }
+                    else if(Bitwise::kOr == opt){
+                        expected = expected || input_bit(i);
+                    }
+                    num_wrong += (expected != bvblock->GetBit(i));
+                }
+                EXPECT_EQ(0UL, num_wrong) << level << " [" << b[0] << ", " << b[1] << "] "
+                    << static_cast<int>(opt);
+            }
+        }
+    }
+    SetSimdLevel(DetectSimdLevel());
+    delete bvblock;
+}
+
+TEST_F(ByteSliceColumnBlockTest, ScanIn){
+    const Bitwise opts[] = {Bitwise::kSet, Bitwise::kAnd, Bitwise::kOr};
+    const SimdLevel levels[] = {SimdLevel::kSSE42, SimdLevel::kAVX2, SimdLevel::kAVX512};
+    BitVectorBlock* bvblock = new BitVectorBlock(num_);
+    auto input_bit = [](size_t i){ return (i % 5) == 0; };
+
+    //few prefixes, with duplicates and values beyond the block or code range
+    std::vector<WordUnit> small_list = {5, 300, 70000, 5, 70001, num_ + 10, 1ULL << 21};
+    //many prefixes
+    std::vector<WordUnit> large_list;
+    std::srand(std::time(0));
+    for(size_t v=0; v < 200; v++){
+        large_list.push_back(std::rand() % (num_ + 1000));
+    }
+    //many prefixes, each shared by runs of nearby values
+    std::vector<WordUnit> clustered_list;
+    for(size_t v=0; v < 200; v++){
+        clustered_list.push_back((v % 20) * 37000 + (v / 20) * (v % 3 + 1));
+    }
+    const std::vector<WordUnit>* lists[] = {&small_list, &large_list, &clustered_list};
+
+    for(SimdLevel level : levels){
+        if(!SetSimdLevel(level)){
+            continue;
+        }
+        for(auto list : lists){
+            std::set<WordUnit> members(list->begin(), list->end());
+            for(Bitwise opt : opts){
+                bvblock->SetZeros();
+                for(size_t i=0; i < num_; i++){
+                    if(input_bit(i)){
+                        bvblock->SetBit(i);
+                    }
+                }
+                block_->ScanIn(list->data(), list->size(), bvblock, opt);
+                size_t num_wrong = 0;
+                for(size_t i=0; i < num_; i++){
+                    bool expected = members.count(i) > 0;
+                    if(Bitwise::kAnd == opt){
+                        expected = expected && input_bit(i);
+                    }
+                    else if(Bitwise::kOr == opt){
+                        expected = expected || input_bit(i);
+                    }
+                    num_wrong += (expected != bvblock->GetBit(i));
+                }
+                EXPECT_EQ(0UL, num_wrong) << level << " " << list->size() << " values "
+                    << static_cast<int>(opt);
+            }
+        }
+    }
+    SetSimdLevel(DetectSimdLevel());
+    delete bvblock;
+}
+
+TEST_F(ByteSliceColumnBlockTest, SumAllLevels){
+    const SimdLevel levels[] = {SimdLevel::kSSE42, SimdLevel::kAVX2, SimdLevel::kAVX512};
+    BitVectorBlock* filter = new BitVectorBlock(num_);
+    filter->SetZeros();
+    WordUnit expected = 0;
+    for(size_t i=0; i < num_; i++){
+        if(i % 7 == 0 || i % 64 < 3){
+            filter->SetBit(i);
+            expected += i;
+        }
+    }
+    const WordUnit total = num_ * (num_ - 1) / 2;
+    for(SimdLevel level : levels){
+        if(!SetSimdLevel(level)){
+            continue;
+        }
+        EXPECT_EQ(expected, block_->Sum(filter)) << level;
+        EXPECT_EQ(total, block_->Sum(nullptr)) << level;
+    }
+    SetSimdLevel(DetectSimdLevel());
+    delete filter;
+}
+
+TEST_F(ByteSliceColumnBlockTest, MinMaxTopKAllLevels){
+    const SimdLevel levels[] = {SimdLevel::kSSE42, SimdLevel::kAVX2, SimdLevel::kAVX512};
+    //values with many ties
+    ByteSliceColumnBlock<20>* block = new ByteSliceColumnBlock<20>(num_);
+    BitVectorBlock* filter = new BitVectorBlock(num_);
+    filter->SetZeros();
+    std::vector<WordUnit> selected;
+    for(size_t i=0; i < num_; i++){
+        const WordUnit value = (i * 2654435761ULL) % 300007;
+        block->SetTuple(i, value);
+        if(i % 5 == 1){
+            filter->SetBit(i);
+            selected.push_back(value);
+        }
+    }
+    std::sort(selected.begin(), selected.end());
+    const size_t k = 100;
+    std::vector<WordUnit> smallest(selected.begin(), selected.begin() + k);
+    std::vector<WordUnit> largest(selected.rbegin(), selected.rbegin() + k);
+
+    for(SimdLevel level : levels){
+        if(!SetSimdLevel(level)){
+            continue;
+        }
+        WordUnit result;
+        ASSERT_TRUE(block->Min(filter, result)) << level;
+        EXPECT_EQ(selected.front(), result) << level;
+        ASSERT_TRUE(block->Max(filter, result)) << level;
+        EXPECT_EQ(selected.back(), result) << level;
+        ASSERT_TRUE(block_->Max(nullptr, result)) << level;
+        EXPECT_EQ(num_ - 1, result) << level;
+
+        std::vector<WordUnit> topk;
+        block->TopK(filter, k, false, topk);
+        EXPECT_EQ(smallest, topk) << level;
+        block->TopK(filter, k, true, topk);
+        EXPECT_EQ(largest, topk) << level;
+        block->TopK(filter, selected.size() + 10, false, topk);
+        EXPECT_EQ(selected, topk) << level;
+    }
+    SetSimdLevel(DetectSimdLevel());
+
+    filter->SetZeros();
+    WordUnit result;
+    EXPECT_FALSE(block->Min(filter, result));
+    std::vector<WordUnit> topk;
+    block->TopK(filter, 10, false, topk);
+    EXPECT_TRUE(topk.empty());
+    delete filter;
+    delete block;
+}
+
+TEST_F(ByteSliceColumnBlockTest, RadixHistogram){
+    const SimdLevel levels[] = {SimdLevel::kSSE42, SimdLevel::kAVX2, SimdLevel::kAVX512};
+    //20 bits are read as 3 digits of (value << 4)
+    const WordUnit value = num_ / 2;
+    const WordUnit code = value << 4;
+    for(SimdLevel level : levels){
+        if(!SetSimdLevel(level)){
+            continue;
+        }
+        size_t histogram[256] = {0};
+        block_->RadixHistogram(nullptr, 0, 0, histogram);
+        EXPECT_EQ(1ULL << 12, histogram[0]) << level;
+        EXPECT_EQ(num_ >> 12, std::count(histogram, histogram + 256, 1ULL << 12)) << level;
+
+        std::fill(histogram, histogram + 256, 0);
+        block_->RadixHistogram(nullptr, 2, code >> 8, histogram);
+        //16 values share the top two digits, each with a distinct low digit
+        EXPECT_EQ(16, std::count(histogram, histogram + 256, 1ULL)) << level;
+        EXPECT_EQ(1ULL, histogram[code & 0xFF]) << level;
+    }
+    SetSimdLevel(DetectSimdLevel());
+}
+
+//Batched transpose and scalar tail must agree with SetTuple
+template <size_t BIT_WIDTH>
+static void CheckBulkLoad(SimdLevel level){
+    const size_t num = 1000;
+    const size_t start_pos = 37;
+    WordUnit codes[num];
+    for(size_t i=0; i < num; i++){
+        //high garbage bits are dropped like SetTuple does
+        codes[i] = (i * 2654435761ULL) ^ (0xABCDULL << 40);
+    }
+    ByteSliceColumnBlock<BIT_WIDTH>* bulk = new ByteSliceColumnBlock<BIT_WIDTH>(num + start_pos);
+    ByteSliceColumnBlock<BIT_WIDTH>* single = new ByteSliceColumnBlock<BIT_WIDTH>(num + start_pos);
+    bulk->BulkLoadArray(codes, num, start_pos);
+    for(size_t i=0; i < num; i++){
+        single->SetTuple(start_pos + i, codes[i]);
+    }
+    for(size_t i=0; i < num + start_pos; i++){
+        ASSERT_EQ(single->GetTuple(i), bulk->GetTuple(i)) << level << " " << BIT_WIDTH << " " << i;
+    }
+    EXPECT_EQ(single->min_value(), bulk->min_value());
+    EXPECT_EQ(single->max_value(), bulk->max_value());
+    delete bulk;
+    delete single;
+}
+
+TEST_F(ByteSliceColumnBlockTest, BulkLoadAllLevels){
+    const SimdLevel levels[] = {SimdLevel::kSSE42, SimdLevel::kAVX2, SimdLevel::kAVX512};
+    for(SimdLevel level : levels){
+        if(!SetSimdLevel(level)){
+            continue;
+        }
+        CheckBulkLoad<3>(level);
+        CheckBulkLoad<8>(level);
+        CheckBulkLoad<13>(level);
+        CheckBulkLoad<20>(level);
+        CheckBulkLoad<27>(level);
+        CheckBulkLoad<32>(level);
+    }
+    SetSimdLevel(DetectSimdLevel());
+}
+
 }   // namespace
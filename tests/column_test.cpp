@@ -7,13 +7,19 @@
  * See file LICENSE.md for details.
  *******************************************************************************/
 
+#include    <algorithm>
 #include    <cstdlib>
 #include    <fstream>
+#include    <set>
 #include    <string>
+#include    <thread>
+#include    <vector>
 
 #include    "gtest/gtest.h"
 
+#include 	"src/bitvector_iterator.h"
 #include 	"src/column.h"
+#include 	"src/compressed_bitvector.h"
 
 
 namespace byteslice{
@@ -50,10 +56,30 @@ TEST_F(ColumnTest, LoadTextFile){
     outfile.close();
 
     // Verify
+    const ColumnType types[] = {ColumnType::kNaive, ColumnType::kByteSlicePadRight};
+    for(ColumnType type : types){
+        Column* column = new Column(type, bit_width_, num_);
+        EXPECT_EQ(num_, column->LoadTextFile(filename)) << type;
+        for(size_t i=0; i < num_; i++){
+            ASSERT_EQ(data_[i], column->GetTuple(i)) << type << " " << i;
+        }
+        delete column;
+    }
+
+    // A shorter file fills the leading tuples only
+    Column* column = new Column(ColumnType::kByteSlicePadRight, bit_width_, 2*num_);
+    EXPECT_EQ(num_, column->LoadTextFile(filename));
+    EXPECT_EQ(data_[num_ - 1], column->GetTuple(num_ - 1));
+    delete column;
+    std::remove(filename.c_str());
+}
+
+TEST_F(ColumnTest, BulkLoadArrayAtOffset){
     Column* column = new Column(ColumnType::kByteSlicePadRight, bit_width_, num_);
-    column->LoadTextFile(filename);
+    const size_t pos = kNumTuplesPerBlock / 2 + 3;
+    column->BulkLoadArray(data_, num_ - pos, pos);
     for(size_t i=0; i < num_; i++){
-        EXPECT_EQ(data_[i], column->GetTuple(i));
+        ASSERT_EQ(i < pos ? 0 : data_[i - pos], column->GetTuple(i)) << i;
     }
     delete column;
 }
@@ -89,6 +115,921 @@ TEST_F(ColumnTest, NaiveBulkLoadAndScanLiteral){
     delete column;
 }
 
+TEST_F(ColumnTest, ScanBetween){
+    WordUnit lower = std::rand() & mask_;
+    WordUnit upper = lower + (std::rand() & (mask_ >> 2));
+    const ColumnType types[] = {ColumnType::kNaive, ColumnType::kByteSlicePadRight};
+    for(ColumnType type : types){
+        Column* column = new Column(type, bit_width_, num_);
+        BitVector* bitvector = new BitVector(column);
+        column->BulkLoadArray(data_, num_);
+        column->ScanBetween(lower, upper, bitvector, Bitwise::kSet);
+        size_t count = 0;
+        for(size_t i=0; i < num_; i++){
+            bool expected = (lower <= data_[i]) && (data_[i] <= upper);
+            count += expected;
+            EXPECT_EQ(expected, bitvector->GetBit(i));
+        }
+        EXPECT_EQ(count, bitvector->CountOnes()) << type;
+        delete bitvector;
+        delete column;
+    }
+}
+
+TEST_F(ColumnTest, ScanIn){
+    std::vector<WordUnit> values;
+    for(size_t v=0; v < 50; v++){
+        values.push_back(data_[std::rand() % num_]);
+        values.push_back(std::rand() & mask_);
+    }
+    std::set<WordUnit> members(values.begin(), values.end());
+    const ColumnType types[] = {ColumnType::kNaive, ColumnType::kByteSlicePadRight};
+    for(ColumnType type : types){
+        Column* column = new Column(type, bit_width_, num_);
+        BitVector* bitvector = new BitVector(column);
+        column->BulkLoadArray(data_, num_);
+        column->ScanIn(values.data(), values.size(), bitvector, Bitwise::kSet);
+        size_t count = 0;
+        for(size_t i=0; i < num_; i++){
+            bool expected = members.count(data_[i]) > 0;
+            count += expected;
+            EXPECT_EQ(expected, bitvector->GetBit(i));
+        }
+        EXPECT_EQ(count, bitvector->CountOnes()) << type;
+        delete bitvector;
+        delete column;
+    }
+}
+
+TEST_F(ColumnTest, ScanConjunction){
+    const ColumnType types[] = {ColumnType::kNaive, ColumnType::kByteSlicePadRight};
+    const Bitwise opts[] = {Bitwise::kSet, Bitwise::kAnd, Bitwise::kOr};
+    for(ColumnType type : types){
+        Column* column1 = new Column(type, bit_width_, num_);
+        Column* column2 = new Column(type, bit_width_, num_);
+        column1->BulkLoadArray(data_, num_);
+        for(size_t i=0; i < num_; i++){
+            column2->SetTuple(i, data_[num_ - 1 - i]);
+        }
+        std::vector<ScanTerm> terms = {
+            {column1, Comparator::kLess, mask_ / 2},
+            {column2, Comparator::kGreaterEqual, mask_ / 4},
+            {column1, Comparator::kInequal, data_[0]},
+        };
+        BitVector* expected = new BitVector(column1);
+        BitVector* bitvector = new BitVector(column1);
+        for(Bitwise opt : opts){
+            expected->SetZeros();
+            for(size_t i=0; i < num_; i += 3){
+                expected->SetBit(i);
+            }
+            bitvector->SetZeros();
+            bitvector->Or(expected);
+            ScanConjunction(terms, bitvector, opt);
+
+            BitVector* terms_only = new BitVector(column1);
+            terms_only->SetOnes();
+            for(const ScanTerm &term : terms){
+                term.column->Scan(term.comparator, term.literal, terms_only, Bitwise::kAnd);
+            }
+            switch(opt){
+                case Bitwise::kSet:
+                    expected->SetOnes();
+                    expected->And(terms_only);
+                    break;
+                case Bitwise::kAnd:
+                    expected->And(terms_only);
+                    break;
+                case Bitwise::kOr:
+                    expected->Or(terms_only);
+                    break;
+            }
+            delete terms_only;
+
+            size_t num_wrong = 0;
+            for(size_t i=0; i < num_; i++){
+                num_wrong += (expected->GetBit(i) != bitvector->GetBit(i));
+            }
+            EXPECT_EQ(0UL, num_wrong) << type << " " << static_cast<int>(opt);
+            EXPECT_EQ(expected->CountOnes(), bitvector->CountOnes());
+        }
+        delete bitvector;
+        delete expected;
+        delete column2;
+        delete column1;
+    }
+}
+
+TEST_F(ColumnTest, ZoneMapSkipsBlocks){
+    //clustered column: most blocks are decided by their zone maps
+    std::vector<WordUnit> sorted(data_, data_ + num_);
+    std::sort(sorted.begin(), sorted.end());
+    const WordUnit literal = sorted[num_ / 2];
+    const Comparator comparators[] = {Comparator::kLess, Comparator::kGreaterEqual,
+        Comparator::kEqual, Comparator::kInequal};
+    const ColumnType types[] = {ColumnType::kNaive, ColumnType::kByteSlicePadRight};
+    for(ColumnType type : types){
+        Column* column = new Column(type, bit_width_, num_);
+        BitVector* bitvector = new BitVector(column);
+        column->BulkLoadArray(sorted.data(), num_);
+        EXPECT_EQ(sorted.front(), column->GetBlock(0)->min_value());
+        EXPECT_EQ(sorted.back(), column->GetBlock(column->GetNumBlocks() - 1)->max_value());
+        //loaded blocks have exact bounds, so no block straddles more than it must
+        for(size_t block_id=0; block_id < column->GetNumBlocks(); block_id++){
+            const ColumnBlock* block = column->GetBlock(block_id);
+            const size_t begin = block_id * kNumTuplesPerBlock;
+            EXPECT_EQ(sorted[begin], block->min_value()) << block_id;
+            EXPECT_EQ(sorted[begin + block->num_tuples() - 1], block->max_value()) << block_id;
+        }
+        for(Comparator comparator : comparators){
+            bitvector->SetOnes();
+            column->Scan(comparator, literal, bitvector, Bitwise::kAnd);
+            size_t num_wrong = 0;
+            for(size_t i=0; i < num_; i++){
+                bool expected = false;
+                switch(comparator){
+                    case Comparator::kLess:
+                        expected = sorted[i] < literal;
+                        break;
+                    case Comparator::kGreaterEqual:
+                        expected = sorted[i] >= literal;
+                        break;
+                    case Comparator::kEqual:
+                        expected = sorted[i] == literal;
+                        break;
+                    default:
+                        expected = sorted[i] != literal;
+                        break;
+                }
+                num_wrong += (expected != bitvector->GetBit(i));
+            }
+            EXPECT_EQ(0UL, num_wrong) << type << " " << comparator;
+        }
+        bitvector->SetZeros();
+        column->ScanBetween(sorted[num_ / 4], sorted[num_ / 3], bitvector, Bitwise::kOr);
+        size_t count = 0;
+        for(size_t i=0; i < num_; i++){
+            count += (sorted[num_ / 4] <= sorted[i]) && (sorted[i] <= sorted[num_ / 3]);
+        }
+        EXPECT_EQ(count, bitvector->CountOnes()) << type;
+        delete bitvector;
+        delete column;
+
+        //growing exposes zeros: the bounds of the exact block have to cover them
+        std::vector<WordUnit> codes;
+        for(WordUnit v = 100; v < 110; v++){
+            codes.push_back(v);
+        }
+        column = new Column(type, bit_width_, codes.size());
+        column->BulkLoadArray(codes.data(), codes.size());
+        EXPECT_EQ(100U, column->GetBlock(0)->min_value());
+        column->Resize(20);
+        EXPECT_EQ(0U, column->GetTuple(15));
+        bitvector = new BitVector(column);
+        column->Scan(Comparator::kEqual, WordUnit(0), bitvector);
+        EXPECT_EQ(10U, bitvector->CountOnes()) << type;
+        column->Scan(Comparator::kLess, WordUnit(50), bitvector);
+        EXPECT_EQ(10U, bitvector->CountOnes()) << type;
+        delete bitvector;
+        //and so do the ones a shrink left behind
+        column->Resize(5);
+        column->Resize(20);
+        column->BulkLoadArray(codes.data(), 5, 15);
+        EXPECT_EQ(0U, column->GetTuple(7));
+        bitvector = new BitVector(column);
+        column->Scan(Comparator::kEqual, WordUnit(0), bitvector);
+        EXPECT_EQ(10U, bitvector->CountOnes()) << type;
+        delete bitvector;
+        delete column;
+    }
+}
+
+TEST_F(ColumnTest, ScanToPositions){
+    const WordUnit literal = std::rand() & mask_;
+    const ColumnType types[] = {ColumnType::kNaive, ColumnType::kByteSlicePadRight};
+    for(ColumnType type : types){
+        Column* column = new Column(type, bit_width_, num_);
+        column->BulkLoadArray(data_, num_);
+        std::vector<uint32_t> positions32(num_);
+        std::vector<uint64_t> positions64(num_);
+        std::vector<size_t> counts32 = column->ScanToPositions(Comparator::kLess, literal,
+                positions32.data());
+        std::vector<size_t> counts64 = column->ScanToPositions(Comparator::kLess, literal,
+                positions64.data());
+        ASSERT_EQ(column->GetNumBlocks(), counts32.size());
+        ASSERT_EQ(counts32, counts64);
+
+        size_t num_wrong = 0;
+        size_t next = 0;
+        for(size_t block_id=0; block_id < counts32.size(); block_id++){
+            for(size_t j=0; j < counts32[block_id]; j++){
+                const size_t k = block_id * kNumTuplesPerBlock + j;
+                while(next < num_ && !(data_[next] < literal)){
+                    next++;
+                }
+                num_wrong += (next != positions32[k]) + (next != positions64[k]);
+                next++;
+            }
+        }
+        while(next < num_ && !(data_[next] < literal)){
+            next++;
+        }
+        EXPECT_EQ(num_, next) << type;     //no match missed
+        EXPECT_EQ(0UL, num_wrong) << type;
+        delete column;
+    }
+}
+
+TEST_F(ColumnTest, Aggregate){
+    const WordUnit literal = std::rand() & mask_;
+    const ColumnType types[] = {ColumnType::kNaive, ColumnType::kByteSlicePadRight};
+    WordUnit expected_sum = 0;
+    WordUnit expected_total = 0;
+    size_t expected_count = 0;
+    for(size_t i=0; i < num_; i++){
+        expected_total += data_[i];
+        if(data_[i] > literal){
+            expected_sum += data_[i];
+            expected_count++;
+        }
+    }
+    for(ColumnType type : types){
+        Column* column = new Column(type, bit_width_, num_);
+        BitVector* bitvector = new BitVector(column);
+        column->BulkLoadArray(data_, num_);
+        column->Scan(Comparator::kGreater, literal, bitvector);
+        EXPECT_EQ(expected_sum, column->Sum(bitvector)) << type;
+        EXPECT_EQ(expected_count, column->Count(bitvector)) << type;
+        EXPECT_DOUBLE_EQ(static_cast<double>(expected_sum) / expected_count,
+                column->Avg(bitvector)) << type;
+        EXPECT_EQ(expected_total, column->Sum()) << type;
+        EXPECT_EQ(num_, column->Count()) << type;
+        bitvector->SetZeros();
+        EXPECT_EQ(0ULL, column->Sum(bitvector)) << type;
+        EXPECT_EQ(0.0, column->Avg(bitvector)) << type;
+        delete bitvector;
+        delete column;
+    }
+}
+
+TEST_F(ColumnTest, MinMaxTopK){
+    const WordUnit literal = std::rand() & mask_;
+    const ColumnType types[] = {ColumnType::kNaive, ColumnType::kByteSlicePadRight};
+    std::vector<WordUnit> selected;
+    for(size_t i=0; i < num_; i++){
+        if(data_[i] <= literal){
+            selected.push_back(data_[i]);
+        }
+    }
+    std::sort(selected.begin(), selected.end());
+    const size_t k = std::min<size_t>(1000, selected.size());
+    std::vector<WordUnit> smallest(selected.begin(), selected.begin() + k);
+    std::vector<WordUnit> largest(selected.rbegin(), selected.rbegin() + k);
+    const WordUnit expected_min = *std::min_element(data_, data_ + num_);
+    const WordUnit expected_max = *std::max_element(data_, data_ + num_);
+
+    for(ColumnType type : types){
+        Column* column = new Column(type, bit_width_, num_);
+        BitVector* bitvector = new BitVector(column);
+        column->BulkLoadArray(data_, num_);
+        column->Scan(Comparator::kLessEqual, literal, bitvector);
+
+        WordUnit result;
+        EXPECT_EQ(!selected.empty(), column->Min(result, bitvector)) << type;
+        if(!selected.empty()){
+            EXPECT_EQ(selected.front(), result) << type;
+            EXPECT_TRUE(column->Max(result, bitvector)) << type;
+            EXPECT_EQ(selected.back(), result) << type;
+        }
+        EXPECT_TRUE(column->Min(result)) << type;
+        EXPECT_EQ(expected_min, result) << type;
+        EXPECT_TRUE(column->Max(result)) << type;
+        EXPECT_EQ(expected_max, result) << type;
+        EXPECT_EQ(smallest, column->TopK(k, false, bitvector)) << type;
+        EXPECT_EQ(largest, column->TopK(k, true, bitvector)) << type;
+
+        bitvector->SetZeros();
+        EXPECT_FALSE(column->Max(result, bitvector)) << type;
+        EXPECT_TRUE(column->TopK(k, false, bitvector).empty()) << type;
+        delete bitvector;
+        delete column;
+    }
+}
+
+TEST_F(ColumnTest, Quantile){
+    const WordUnit literal = std::rand() & mask_;
+    const ColumnType types[] = {ColumnType::kNaive, ColumnType::kByteSlicePadRight};
+    const double fractions[] = {0.0, 0.5, 0.95, 0.99, 1.0};
+    std::vector<WordUnit> selected;
+    for(size_t i=0; i < num_; i++){
+        if(data_[i] > literal){
+            selected.push_back(data_[i]);
+        }
+    }
+    std::sort(selected.begin(), selected.end());
+    std::vector<WordUnit> all(data_, data_ + num_);
+    std::sort(all.begin(), all.end());
+
+    for(ColumnType type : types){
+        Column* column = new Column(type, bit_width_, num_);
+        BitVector* bitvector = new BitVector(column);
+        column->BulkLoadArray(data_, num_);
+        column->Scan(Comparator::kGreater, literal, bitvector);
+
+        WordUnit result;
+        for(double fraction : fractions){
+            EXPECT_EQ(!selected.empty(), column->Quantile(fraction, result, bitvector))
+                << type;
+            if(!selected.empty()){
+                EXPECT_EQ(selected[static_cast<size_t>(fraction * (selected.size() - 1))],
+                        result) << type << " " << fraction;
+            }
+            EXPECT_TRUE(column->Quantile(fraction, result)) << type;
+            EXPECT_EQ(all[static_cast<size_t>(fraction * (num_ - 1))], result)
+                << type << " " << fraction;
+        }
+        EXPECT_TRUE(column->Median(result)) << type;
+        EXPECT_EQ(all[(num_ - 1) / 2], result) << type;
+
+        bitvector->SetZeros();
+        EXPECT_FALSE(column->Median(result, bitvector)) << type;
+        delete bitvector;
+        delete column;
+    }
+}
+
+TEST_F(ColumnTest, MapFile){
+    const ColumnType types[] = {ColumnType::kNaive, ColumnType::kByteSlicePadRight};
+    const WordUnit literal = std::rand() & mask_;
+    for(ColumnType type : types){
+        std::string filename(std::tmpnam(nullptr));
+        Column* column = new Column(type, bit_width_, num_);
+        column->BulkLoadArray(data_, num_);
+        column->BuildImprints();
+        SequentialWriteBinaryFile outfile;
+        outfile.Open(filename);
+        column->SerToFile(outfile);
+        outfile.Close();
+
+        Column* mapped = new Column(type, bit_width_, num_);
+        ASSERT_TRUE(mapped->MapFile(filename, MapHint::kWillNeed)) << type;
+        EXPECT_FALSE(mapped->MapFile(filename)) << type;
+        for(size_t block_id=0; block_id < mapped->GetNumBlocks(); block_id++){
+            EXPECT_TRUE(mapped->GetBlock(block_id)->mapped());
+            EXPECT_EQ(column->GetBlock(block_id)->min_value(),
+                    mapped->GetBlock(block_id)->min_value());
+        }
+        for(size_t i=0; i < num_; i++){
+            ASSERT_EQ(data_[i], mapped->GetTuple(i)) << type << " " << i;
+        }
+        BitVector* expected = new BitVector(column);
+        BitVector* bitvector = new BitVector(mapped);
+        column->Scan(Comparator::kLess, literal, expected);
+        mapped->Scan(Comparator::kLess, literal, bitvector);
+        EXPECT_EQ(expected->CountOnes(), bitvector->CountOnes()) << type;
+        EXPECT_EQ(column->Sum(expected), mapped->Sum(bitvector)) << type;
+
+        //a truncated file is rejected
+        Column* truncated = new Column(type, bit_width_, num_ + kNumTuplesPerBlock);
+        EXPECT_FALSE(truncated->MapFile(filename)) << type;
+
+        delete truncated;
+        delete expected;
+        delete bitvector;
+        delete mapped;
+        delete column;
+        std::remove(filename.c_str());
+    }
+}
+
+TEST_F(ColumnTest, ColumnFile){
+    const ColumnType types[] = {ColumnType::kNaive, ColumnType::kByteSlicePadRight};
+    for(ColumnType type : types){
+        std::string filename(std::tmpnam(nullptr));
+        Column* column = new Column(type, bit_width_, num_);
+        column->BulkLoadArray(data_, num_);
+        ASSERT_TRUE(column->SaveToFile(filename)) << type;
+
+        //the partial last block is trimmed
+        std::ifstream infile(filename, std::ifstream::binary | std::ifstream::ate);
+        const size_t file_size = infile.tellg();
+        infile.close();
+        const size_t bytes_per_tuple = ColumnType::kNaive == type ? 4 : CEIL(bit_width_, 8);
+        EXPECT_LT(file_size, bytes_per_tuple * num_ + 64 * 1024) << type;
+
+        Column* loaded = Column::LoadFromFile(filename);
+        ASSERT_NE(nullptr, loaded) << type;
+        EXPECT_EQ(type, loaded->GetType());
+        EXPECT_EQ(bit_width_, loaded->GetBitWidth());
+        EXPECT_EQ(num_, loaded->GetNumTuples());
+        for(size_t i=0; i < num_; i++){
+            ASSERT_EQ(data_[i], loaded->GetTuple(i)) << type << " " << i;
+        }
+
+        Column* mapped = Column::MapFromFile(filename);
+        ASSERT_NE(nullptr, mapped) << type;
+        EXPECT_EQ(num_, mapped->GetNumTuples());
+        for(size_t i=0; i < num_; i++){
+            ASSERT_EQ(data_[i], mapped->GetTuple(i)) << type << " " << i;
+        }
+
+        //random access to one block
+        Column* partial = new Column(type, bit_width_, num_);
+        ASSERT_TRUE(partial->LoadBlockFromFile(filename, 2)) << type;
+        EXPECT_EQ(0ULL, partial->GetTuple(0));
+        EXPECT_EQ(data_[2*kNumTuplesPerBlock], partial->GetTuple(2*kNumTuplesPerBlock));
+        EXPECT_EQ(data_[num_ - 1], partial->GetTuple(num_ - 1));
+        Column* other = new Column(type, bit_width_ + 1, num_);
+        EXPECT_FALSE(other->LoadBlockFromFile(filename, 0)) << type;
+
+        delete other;
+        delete partial;
+        delete mapped;
+        delete loaded;
+        delete column;
+        std::remove(filename.c_str());
+    }
+
+    //not a column file
+    std::string filename(std::tmpnam(nullptr));
+    std::ofstream outfile(filename, std::ofstream::out);
+    outfile << "12345\n";
+    outfile.close();
+    EXPECT_EQ(nullptr, Column::LoadFromFile(filename));
+    EXPECT_EQ(nullptr, Column::MapFromFile(filename));
+    std::remove(filename.c_str());
+}
+
+TEST_F(ColumnTest, ScanFile){
+    const ColumnType types[] = {ColumnType::kNaive, ColumnType::kByteSlicePadRight};
+    const WordUnit literal = data_[num_ / 2];
+    for(ColumnType type : types){
+        std::string filename(std::tmpnam(nullptr));
+        Column* column = new Column(type, bit_width_, num_);
+        column->BulkLoadArray(data_, num_);
+        ASSERT_TRUE(column->SaveToFile(filename)) << type;
+
+        BitVector* expected = new BitVector(column);
+        column->Scan(Comparator::kLess, literal, expected, Bitwise::kSet);
+        column->Scan(Comparator::kGreater, literal / 2, expected, Bitwise::kAnd);
+        const size_t depths[] = {1, 3, 16};
+        for(size_t depth : depths){
+            BitVector* bitvector = new BitVector(column);
+            ASSERT_TRUE(Column::ScanFile(filename, Comparator::kLess, literal,
+                        bitvector, Bitwise::kSet, depth)) << type << " " << depth;
+            ASSERT_TRUE(Column::ScanFile(filename, Comparator::kGreater, literal / 2,
+                        bitvector, Bitwise::kAnd, depth)) << type << " " << depth;
+            for(size_t i=0; i < num_; i++){
+                ASSERT_EQ(expected->GetBit(i), bitvector->GetBit(i))
+                    << type << " " << depth << " " << i;
+            }
+            delete bitvector;
+        }
+
+        //the bit vector must fit the stored column
+        BitVector* small = new BitVector(num_ - 1);
+        EXPECT_FALSE(Column::ScanFile(filename, Comparator::kLess, literal, small));
+        delete small;
+
+        //compressed files are not streamed
+        ASSERT_TRUE(column->SaveToFile(filename, Compression::kAuto));
+        BitVector* bitvector = new BitVector(column);
+        EXPECT_FALSE(Column::ScanFile(filename, Comparator::kLess, literal, bitvector)) << type;
+
+        delete bitvector;
+        delete expected;
+        delete column;
+        std::remove(filename.c_str());
+    }
+}
+
+TEST_F(ColumnTest, Append){
+    const ColumnType types[] = {ColumnType::kNaive, ColumnType::kByteSlicePadRight};
+    for(ColumnType type : types){
+        Column* column = new Column(type, bit_width_);
+        EXPECT_EQ(0U, column->Snapshot().GetNumTuples());
+        //pieces crossing block boundaries
+        size_t num_appended = 0;
+        for(size_t piece = 0; num_appended < num_; piece++){
+            const size_t count = std::min(num_ - num_appended, 1 + piece * 77777);
+            EXPECT_EQ(num_appended, column->Append(data_ + num_appended, count));
+            num_appended += count;
+        }
+        EXPECT_EQ(num_, column->GetNumTuples());
+        EXPECT_EQ(CEIL(num_, kNumTuplesPerBlock), column->GetNumBlocks());
+        for(size_t i=0; i < num_; i++){
+            ASSERT_EQ(data_[i], column->GetTuple(i)) << type << " " << i;
+        }
+
+        //a snapshot keeps its size
+        const WordUnit literal = data_[num_ / 3];
+        ColumnSnapshot snapshot = column->Snapshot();
+        column->Append(data_, 12345);
+        EXPECT_EQ(num_, snapshot.GetNumTuples());
+        EXPECT_EQ(num_ + 12345, column->Snapshot().GetNumTuples());
+        EXPECT_EQ(data_[num_ - 1], snapshot.GetTuple(num_ - 1));
+        EXPECT_EQ(data_[7], column->GetTuple(num_ + 7));
+        BitVector* bitvector = new BitVector(snapshot.GetNumTuples());
+        snapshot.Scan(Comparator::kLess, literal, bitvector);
+        size_t count = 0;
+        for(size_t i=0; i < num_; i++){
+            count += data_[i] < literal;
+        }
+        EXPECT_EQ(count, bitvector->CountOnes()) << type;
+
+        delete bitvector;
+        delete column;
+    }
+}
+
+TEST_F(ColumnTest, AppendWhileScanning){
+    //one writer, scans of snapshots taken meanwhile
+    const WordUnit literal = 1ULL << (bit_width_ - 1);
+    std::vector<size_t> num_less(num_ + 1, 0);
+    for(size_t i=0; i < num_; i++){
+        num_less[i + 1] = num_less[i] + (data_[i] < literal);
+    }
+    Column* column = new Column(ColumnType::kByteSlicePadRight, bit_width_);
+    std::thread writer([&](){
+        for(size_t done = 0; done < num_; done += 100003){
+            column->Append(data_ + done, std::min<size_t>(100003, num_ - done));
+        }
+    });
+    size_t num_seen = 0;
+    while(num_seen < num_){
+        ColumnSnapshot snapshot = column->Snapshot();
+        num_seen = snapshot.GetNumTuples();
+        BitVector* less = new BitVector(num_seen);
+        BitVector* either = new BitVector(num_seen);
+        snapshot.Scan(Comparator::kLess, literal, less);
+        snapshot.Scan(Comparator::kGreaterEqual, literal, either);
+        snapshot.Scan(Comparator::kLess, literal, either, Bitwise::kOr);
+        ASSERT_EQ(num_less[num_seen], less->CountOnes()) << num_seen;
+        ASSERT_EQ(num_seen, either->CountOnes()) << num_seen;
+        delete either;
+        delete less;
+    }
+    writer.join();
+    delete column;
+}
+
+TEST_F(ColumnTest, UpdateAndMerge){
+    const ColumnType types[] = {ColumnType::kNaive, ColumnType::kByteSlicePadRight};
+    const WordUnit mask = (1ULL << bit_width_) - 1;
+    for(ColumnType type : types){
+        Column* column = new Column(type, bit_width_, num_);
+        column->BulkLoadArray(data_, num_);
+        std::vector<WordUnit> expected(data_, data_ + num_);
+
+        //scattered updates, repeated ids, and a run long enough for bulk merging
+        std::vector<size_t> ids;
+        std::vector<WordUnit> values;
+        for(size_t i=0; i < 5000; i++){
+            ids.push_back(std::rand() % num_);
+            values.push_back(std::rand() & mask);
+        }
+        for(size_t i=0; i < 3000; i++){
+            ids.push_back(kNumTuplesPerBlock - 1000 + i);
+            values.push_back(std::rand() & mask);
+        }
+        ids.push_back(ids[0]);
+        values.push_back(values[0] ^ 1);
+        column->Update(ids.data(), values.data(), ids.size() / 2);
+        ColumnSnapshot before = column->Snapshot();
+        column->Update(ids.data() + ids.size() / 2, values.data() + ids.size() / 2,
+                ids.size() - ids.size() / 2);
+        column->Update(num_ - 1, 7);
+        ids.push_back(num_ - 1);
+        values.push_back(7);
+        for(size_t i=0; i < ids.size(); i++){
+            expected[ids[i]] = values[i];
+        }
+        EXPECT_LT(0U, column->GetNumPendingUpdates());
+        EXPECT_GE(ids.size(), column->GetNumPendingUpdates());
+        //a second column for conjunctions, with updates of its own
+        Column* other = new Column(type, bit_width_, num_);
+        other->BulkLoadArray(data_, num_);
+        std::vector<WordUnit> expected_other(data_, data_ + num_);
+        for(size_t i=0; i < 2000; i++){
+            const size_t id = std::rand() % num_;
+            expected_other[id] = std::rand() & mask;
+            other->Update(id, expected_other[id]);
+        }
+
+        //the snapshot taken in between only sees the first batch
+        EXPECT_EQ(values[0], before.GetTuple(ids[0]));
+        EXPECT_EQ(data_[num_ - 1], before.GetTuple(num_ - 1));
+
+        const WordUnit literal = mask / 2;
+        const WordUnit in_values[] = {values[1], values[6000], data_[3]};
+        for(int merged = 0; merged < 2; merged++){
+            for(size_t i=0; i < num_; i++){
+                ASSERT_EQ(expected[i], column->GetTuple(i)) << type << " " << i;
+            }
+            BitVector* bitvector = new BitVector(column);
+            BitVector* between = new BitVector(column);
+            BitVector* in = new BitVector(column);
+            BitVector* snapshot_bits = new BitVector(column);
+            BitVector* conjunction = new BitVector(column);
+            column->Scan(Comparator::kLess, literal, bitvector);
+            column->Scan(Comparator::kGreater, literal / 4, bitvector, Bitwise::kAnd);
+            column->Scan(Comparator::kEqual, expected[ids[9]], bitvector, Bitwise::kOr);
+            column->ScanBetween(literal / 4, literal / 2, between);
+            column->ScanIn(in_values, 3, in);
+            column->Snapshot().Scan(Comparator::kLess, literal, snapshot_bits);
+            const std::vector<ScanTerm> terms = {
+                {column, Comparator::kLess, literal},
+                {other, Comparator::kGreater, literal / 4},
+            };
+            ScanConjunction(terms, conjunction);
+            std::vector<uint64_t> positions(num_);
+            const std::vector<size_t> counts = column->ScanToPositions(Comparator::kLess,
+                    literal, positions.data());
+            for(size_t i=0; i < num_; i++){
+                const WordUnit v = expected[i];
+                ASSERT_EQ((v < literal && v > literal / 4) || v == expected[ids[9]],
+                        bitvector->GetBit(i)) << type << " " << merged << " " << i;
+                ASSERT_EQ(literal / 4 <= v && v <= literal / 2, between->GetBit(i)) << i;
+                ASSERT_EQ(v == in_values[0] || v == in_values[1] || v == in_values[2],
+                        in->GetBit(i)) << i;
+                ASSERT_EQ(v < literal, snapshot_bits->GetBit(i)) << i;
+                ASSERT_EQ(v < literal && expected_other[i] > literal / 4,
+                        conjunction->GetBit(i)) << type << " " << merged << " " << i;
+            }
+            for(size_t block_id=0; block_id < counts.size(); block_id++){
+                std::vector<uint64_t> expected_positions;
+                for(size_t i = block_id * kNumTuplesPerBlock;
+                        i < std::min(num_, (block_id + 1) * kNumTuplesPerBlock); i++){
+                    if(expected[i] < literal){
+                        expected_positions.push_back(i);
+                    }
+                }
+                const uint64_t* block_positions = positions.data() + block_id * kNumTuplesPerBlock;
+                EXPECT_EQ(expected_positions, std::vector<uint64_t>(block_positions,
+                            block_positions + counts[block_id])) << type << " " << merged;
+            }
+
+            //aggregates, column-column scans and files see the updates too
+            WordUnit sum = 0;
+            std::vector<WordUnit> selected;
+            for(size_t i=0; i < num_; i++){
+                if(between->GetBit(i)){
+                    sum += expected[i];
+                    selected.push_back(expected[i]);
+                }
+            }
+            std::vector<WordUnit> sorted(expected);
+            std::sort(sorted.begin(), sorted.end());
+            std::sort(selected.begin(), selected.end());
+            WordUnit result = 0;
+            EXPECT_EQ(sum, column->Sum(between)) << type << " " << merged;
+            EXPECT_TRUE(column->Max(result));
+            EXPECT_EQ(sorted.back(), result) << type << " " << merged;
+            EXPECT_TRUE(column->Min(result, between));
+            EXPECT_EQ(selected.front(), result) << type << " " << merged;
+            EXPECT_EQ(std::vector<WordUnit>(sorted.rbegin(), sorted.rbegin() + 5),
+                    column->TopK(5, true)) << type << " " << merged;
+            EXPECT_TRUE(column->Median(result));
+            EXPECT_EQ(sorted[(num_ - 1) / 2], result) << type << " " << merged;
+            BitVector* less_other = new BitVector(column);
+            column->Scan(Comparator::kLess, other, less_other);
+            for(size_t i=0; i < num_; i++){
+                ASSERT_EQ(expected[i] < expected_other[i], less_other->GetBit(i))
+                        << type << " " << merged << " " << i;
+            }
+            delete less_other;
+            std::string filename(std::tmpnam(nullptr));
+            ASSERT_TRUE(column->SaveToFile(filename));
+            Column* loaded = Column::LoadFromFile(filename);
+            ASSERT_NE(nullptr, loaded);
+            for(size_t i=0; i < num_; i++){
+                ASSERT_EQ(expected[i], loaded->GetTuple(i)) << type << " " << merged << " " << i;
+            }
+            delete loaded;
+            std::remove(filename.c_str());
+
+            delete conjunction;
+            delete snapshot_bits;
+            delete in;
+            delete between;
+            delete bitvector;
+            column->Merge();
+            other->Merge();
+            EXPECT_EQ(0U, column->GetNumPendingUpdates());
+        }
+        delete other;
+        //merged into the blocks themselves
+        EXPECT_EQ(expected[ids[0]], column->GetBlock(ids[0] / kNumTuplesPerBlock)
+                ->GetTuple(ids[0] % kNumTuplesPerBlock));
+        EXPECT_EQ(7U, column->GetBlock(column->GetNumBlocks() - 1)
+                ->GetTuple((num_ - 1) % kNumTuplesPerBlock));
+        //the old snapshot keeps its blocks and updates across merges
+        EXPECT_EQ(values[0], before.GetTuple(ids[0]));
+        EXPECT_EQ(data_[num_ - 1], before.GetTuple(num_ - 1));
+        delete column;
+        //and outlives the column
+        EXPECT_EQ(values[0], before.GetTuple(ids[0]));
+    }
+}
+
+TEST_F(ColumnTest, WritesOverrideUpdates){
+    const ColumnType types[] = {ColumnType::kNaive, ColumnType::kByteSlicePadRight};
+    for(ColumnType type : types){
+        Column* column = new Column(type, bit_width_, num_);
+        column->BulkLoadArray(data_, num_);
+        const size_t ids[] = {3, 10, kNumTuplesPerBlock + 5};
+        const WordUnit values[] = {1, 2, 3};
+        column->Update(ids, values, 3);
+        //a direct write replaces the pending update of its tuple only
+        column->SetTuple(3, 4);
+        EXPECT_EQ(4U, column->GetTuple(3)) << type;
+        EXPECT_EQ(2U, column->GetTuple(10)) << type;
+        EXPECT_EQ(2U, column->GetNumPendingUpdates());
+        const WordUnit codes[] = {5, 6};
+        column->BulkLoadArray(codes, 2, kNumTuplesPerBlock + 4);
+        EXPECT_EQ(6U, column->GetTuple(kNumTuplesPerBlock + 5)) << type;
+        EXPECT_EQ(1U, column->GetNumPendingUpdates());
+        BitVector* bitvector = new BitVector(column);
+        column->Scan(Comparator::kEqual, WordUnit(4), bitvector);
+        EXPECT_TRUE(bitvector->GetBit(3)) << type;
+        column->Scan(Comparator::kEqual, WordUnit(6), bitvector);
+        EXPECT_TRUE(bitvector->GetBit(kNumTuplesPerBlock + 5)) << type;
+        delete bitvector;
+        column->Merge();
+        EXPECT_EQ(4U, column->GetTuple(3)) << type;
+        EXPECT_EQ(2U, column->GetTuple(10)) << type;
+        EXPECT_EQ(6U, column->GetTuple(kNumTuplesPerBlock + 5)) << type;
+        delete column;
+    }
+}
+
+TEST_F(ColumnTest, UpdateWhileScanning){
+    //batches of updates move tuples above the literal; merges run meanwhile
+    const WordUnit literal = 1ULL << (bit_width_ - 1);
+    const size_t batch = 1000;
+    const size_t num_batches = 200;
+    for(size_t i=0; i < num_; i++){
+        data_[i] = data_[i] % literal;
+    }
+    Column* column = new Column(ColumnType::kByteSlicePadRight, bit_width_, num_);
+    column->BulkLoadArray(data_, num_);
+    std::thread writer([&](){
+        std::vector<size_t> ids(batch);
+        std::vector<WordUnit> values(batch, literal + 1);
+        for(size_t b=0; b < num_batches; b++){
+            for(size_t i=0; i < batch; i++){
+                ids[i] = (b * batch + i) * 3 % num_;
+            }
+            column->Update(ids.data(), values.data(), batch);
+            if(0 == b % 16){
+                column->Merge();
+            }
+        }
+        column->Merge();
+    });
+    size_t num_seen = 0;
+    while(num_seen < batch * num_batches){
+        BitVector* bitvector = new BitVector(num_);
+        column->Snapshot().Scan(Comparator::kGreater, literal, bitvector);
+        const size_t count = bitvector->CountOnes();
+        ASSERT_EQ(0U, count % batch);
+        ASSERT_LE(num_seen, count);
+        num_seen = count;
+        delete bitvector;
+    }
+    writer.join();
+    EXPECT_EQ(0U, column->GetNumPendingUpdates());
+    delete column;
+}
+
+TEST_F(ColumnTest, ScanCompressed){
+    const ColumnType types[] = {ColumnType::kNaive, ColumnType::kByteSlicePadRight};
+    for(ColumnType type : types){
+        Column* column = new Column(type, bit_width_, num_);
+        column->BulkLoadArray(data_, num_);
+        column->Update(5, 3);
+        //selective, everything (zone map), and a mix of both
+        const WordUnit literals[] = {1000, 1ULL << bit_width_, 1ULL << (bit_width_ - 1)};
+        for(WordUnit literal : literals){
+            BitVector* expected = new BitVector(column);
+            CompressedBitVector* compressed = new CompressedBitVector(num_);
+            column->Scan(Comparator::kLess, literal, expected);
+            column->Scan(Comparator::kLess, literal, compressed);
+            column->Scan(Comparator::kGreater, literal / 3, expected, Bitwise::kAnd);
+            column->Scan(Comparator::kGreater, literal / 3, compressed, Bitwise::kAnd);
+            column->Scan(Comparator::kEqual, data_[77], expected, Bitwise::kOr);
+            column->Scan(Comparator::kEqual, data_[77], compressed, Bitwise::kOr);
+            EXPECT_EQ(expected->CountOnes(), compressed->CountOnes()) << type << " " << literal;
+            for(size_t i=0; i < num_; i++){
+                ASSERT_EQ(expected->GetBit(i), compressed->GetBit(i))
+                    << type << " " << literal << " " << i;
+            }
+            delete compressed;
+            delete expected;
+        }
+        delete column;
+    }
+}
+
+TEST_F(ColumnTest, ScanWithSummary){
+    const ColumnType types[] = {ColumnType::kNaive, ColumnType::kByteSlicePadRight};
+    for(ColumnType type : types){
+        Column* column = new Column(type, bit_width_, num_);
+        column->BulkLoadArray(data_, num_);
+        BitVector* expected = new BitVector(column);
+        BitVector* summarized = new BitVector(column);
+        summarized->EnableSummary();
+        //a few alive regions, so that most runs are dead
+        for(BitVector* bitvector : {expected, summarized}){
+            bitvector->SetZeros();
+            for(size_t i=0; i < num_; i += 300000){
+                for(size_t k = i; k < std::min(num_, i + 9000); k++){
+                    bitvector->SetBit(k);
+                }
+            }
+            column->Scan(Comparator::kLess, mask_ / 2, bitvector, Bitwise::kAnd);
+            column->Scan(Comparator::kGreater, mask_ / 8, bitvector, Bitwise::kAnd);
+        }
+        EXPECT_EQ(expected->CountOnes(), summarized->CountOnes()) << type;
+        for(size_t i=0; i < num_; i++){
+            ASSERT_EQ(expected->GetBit(i), summarized->GetBit(i)) << type << " " << i;
+        }
+
+        //positions skip the dead runs
+        std::vector<uint64_t> expected_positions;
+        BitVectorIterator* itor = new BitVectorIterator(expected);
+        while(itor->Next()){
+            expected_positions.push_back(itor->GetPosition());
+        }
+        delete itor;
+        std::vector<uint64_t> positions;
+        itor = new BitVectorIterator(summarized);
+        while(itor->Next()){
+            positions.push_back(itor->GetPosition());
+        }
+        delete itor;
+        EXPECT_EQ(expected_positions, positions) << type;
+        std::vector<uint64_t> batch(num_);
+        itor = new BitVectorIterator(summarized);
+        batch.resize(itor->NextBatch(batch.data(), num_));
+        delete itor;
+        EXPECT_EQ(expected_positions, batch) << type;
+
+        //ones outside the old runs: the summary follows a kOr scan
+        for(BitVector* bitvector : {expected, summarized}){
+            column->Scan(Comparator::kEqual, data_[150000], bitvector, Bitwise::kOr);
+            column->Scan(Comparator::kLessEqual, data_[150000], bitvector, Bitwise::kAnd);
+        }
+        EXPECT_TRUE(summarized->GetBit(150000));
+        EXPECT_EQ(expected->CountOnes(), summarized->CountOnes()) << type;
+        for(size_t i=0; i < num_; i++){
+            ASSERT_EQ(expected->GetBit(i), summarized->GetBit(i)) << type << " " << i;
+        }
+        delete summarized;
+        delete expected;
+        delete column;
+    }
+}
+
+TEST_F(ColumnTest, CompressedColumnFile){
+    //low-entropy values: the high-order slices compress well
+    const size_t bytes_per_tuple = CEIL(bit_width_, 8);
+    for(size_t i=0; i < num_; i++){
+        data_[i] = (i / 100000) % (1ULL << bit_width_);
+    }
+    Column* column = new Column(ColumnType::kByteSlicePadRight, bit_width_, num_);
+    column->BulkLoadArray(data_, num_);
+    std::string filename(std::tmpnam(nullptr));
+    ASSERT_TRUE(column->SaveToFile(filename, Compression::kAuto));
+
+    std::ifstream infile(filename, std::ifstream::binary | std::ifstream::ate);
+    const size_t file_size = infile.tellg();
+    infile.close();
+    EXPECT_LT(file_size, bytes_per_tuple * num_ / 4);
+
+    Column* loaded = Column::LoadFromFile(filename);
+    ASSERT_NE(nullptr, loaded);
+    for(size_t i=0; i < num_; i++){
+        ASSERT_EQ(data_[i], loaded->GetTuple(i)) << i;
+    }
+    BitVector* bitvector = new BitVector(loaded);
+    loaded->Scan(Comparator::kLess, 5, bitvector, Bitwise::kSet);
+    EXPECT_EQ(500000U, bitvector->CountOnes());
+
+    //random access into a compressed file
+    Column* partial = new Column(ColumnType::kByteSlicePadRight, bit_width_, num_);
+    ASSERT_TRUE(partial->LoadBlockFromFile(filename, 1));
+    EXPECT_EQ(data_[kNumTuplesPerBlock + 7], partial->GetTuple(kNumTuplesPerBlock + 7));
+
+    //compressed slices can't be mapped
+    EXPECT_EQ(nullptr, Column::MapFromFile(filename));
+
+    delete partial;
+    delete bitvector;
+    delete loaded;
+    delete column;
+    std::remove(filename.c_str());
+}
 
 
 }   // namespace
@@ -0,0 +1,196 @@
+/*******************************************************************************
+ * Copyright (c) 2015
+ * The Hong Kong Polytechnic University, Database Group
+ *
+ * Author: Ziqiang Feng (cszqfeng AT comp.polyu.edu.hk)
+ *
+ * See file LICENSE.md for details.
+ *******************************************************************************/
+#include "../src/compressed_bitvector.h"
+
+#include    <cstdlib>
+#include    <ctime>
+#include    <vector>
+
+#include "../src/macros.h"
+#include "../src/param.h"
+#include "../src/types.h"
+#include    "gtest/gtest.h"
+
+namespace byteslice{
+
+class CompressedBitVectorTest: public ::testing::Test{
+public:
+    virtual void SetUp(){
+        std::srand(std::time(0));
+    }
+
+    //ones with probability 1 / period, plus a dense region and a full container
+    BitVector* MakeDense(size_t period){
+        BitVector* bitvector = new BitVector(num_);
+        bitvector->SetZeros();
+        for(size_t i=0; i < num_; i++){
+            if(0 == std::rand() % period){
+                bitvector->SetBit(i);
+            }
+        }
+        for(size_t i = kNumTuplesPerBlock + 5; i < kNumTuplesPerBlock + 30000; i += 2){
+            bitvector->SetBit(i);
+        }
+        for(size_t i = 5 * CompressedBitVector::kNumContainerBits;
+                i < 6 * CompressedBitVector::kNumContainerBits; i++){
+            bitvector->SetBit(i);
+        }
+        return bitvector;
+    }
+
+    void ExpectSame(BitVector* expected, const CompressedBitVector* actual){
+        ASSERT_EQ(expected->num(), actual->num());
+        EXPECT_EQ(expected->CountOnes(), actual->CountOnes());
+        BitVector* dense = new BitVector(num_);
+        actual->ToBitVector(dense);
+        for(size_t i=0; i < num_; i++){
+            ASSERT_EQ(expected->GetBit(i), dense->GetBit(i)) << i;
+            ASSERT_EQ(expected->GetBit(i), actual->GetBit(i)) << i;
+        }
+        delete dense;
+    }
+
+protected:
+    const size_t num_ = 2*kNumTuplesPerBlock + 70000;
+
+};
+
+TEST_F(CompressedBitVectorTest, Conversion){
+    CompressedBitVector* empty = new CompressedBitVector(num_);
+    EXPECT_EQ(0U, empty->CountOnes());
+    EXPECT_FALSE(empty->IsDense());
+
+    const size_t periods[] = {1, 3, 10000};
+    for(size_t period : periods){
+        BitVector* dense = MakeDense(period);
+        CompressedBitVector* compressed = new CompressedBitVector(dense);
+        ExpectSame(dense, compressed);
+        EXPECT_EQ(period < 100, compressed->IsDense()) << period;
+        delete compressed;
+        delete dense;
+    }
+
+    //a sparse result takes a fraction of the dense size
+    BitVector* sparse = new BitVector(num_);
+    sparse->SetZeros();
+    for(size_t i=0; i < num_; i += 9973){
+        sparse->SetBit(i);
+    }
+    CompressedBitVector* compressed = new CompressedBitVector(sparse);
+    EXPECT_LT(compressed->GetMemorySize() * 50, num_ / 8);
+    compressed->SetOnes();
+    EXPECT_EQ(num_, compressed->CountOnes());
+    compressed->SetZeros();
+    EXPECT_EQ(0U, compressed->CountOnes());
+    delete compressed;
+    delete sparse;
+    delete empty;
+}
+
+TEST_F(CompressedBitVectorTest, AndOr){
+    const size_t periods[] = {2, 50, 20000};
+    for(size_t p1 : periods){
+        for(size_t p2 : periods){
+            BitVector* dense1 = MakeDense(p1);
+            BitVector* dense2 = MakeDense(p2);
+            CompressedBitVector* compressed2 = new CompressedBitVector(dense2);
+
+            //compressed with compressed
+            CompressedBitVector* both = new CompressedBitVector(dense1);
+            CompressedBitVector* either = new CompressedBitVector(dense1);
+            both->And(compressed2);
+            either->Or(compressed2);
+            //compressed with dense
+            CompressedBitVector* both_dense = new CompressedBitVector(dense1);
+            CompressedBitVector* either_dense = new CompressedBitVector(dense1);
+            both_dense->And(dense2);
+            either_dense->Or(dense2);
+
+            BitVector* expected_and = MakeDense(1);
+            expected_and->SetOnes();
+            expected_and->And(dense1);
+            expected_and->And(dense2);
+            BitVector* expected_or = MakeDense(1);
+            expected_or->SetZeros();
+            expected_or->Or(dense1);
+            expected_or->Or(dense2);
+            ExpectSame(expected_and, both);
+            ExpectSame(expected_or, either);
+            ExpectSame(expected_and, both_dense);
+            ExpectSame(expected_or, either_dense);
+
+            delete expected_or;
+            delete expected_and;
+            delete either_dense;
+            delete both_dense;
+            delete either;
+            delete both;
+            delete compressed2;
+            delete dense2;
+            delete dense1;
+        }
+    }
+}
+
+TEST_F(CompressedBitVectorTest, BitManipulation){
+    CompressedBitVector* bitvector = new CompressedBitVector(num_);
+    //an array container grows into a bitmap and shrinks back
+    const size_t base = 3 * CompressedBitVector::kNumContainerBits;
+    const size_t num_ones = CompressedBitVector::kMaxArraySize + 10;
+    for(size_t i=0; i < num_ones; i++){
+        bitvector->SetBit(base + i * 7);
+    }
+    bitvector->SetBit(base);
+    EXPECT_EQ(num_ones, bitvector->CountOnes());
+    const size_t bitmap_size = bitvector->GetMemorySize();
+    for(size_t i=0; i < 20; i++){
+        bitvector->UnsetBit(base + i * 7);
+    }
+    EXPECT_EQ(num_ones - 20, bitvector->CountOnes());
+    EXPECT_GT(bitmap_size, bitvector->GetMemorySize());
+    EXPECT_FALSE(bitvector->GetBit(base));
+    EXPECT_TRUE(bitvector->GetBit(base + 20 * 7));
+    EXPECT_FALSE(bitvector->GetBit(base + 20 * 7 + 1));
+    bitvector->SetBit(num_ - 1);
+    EXPECT_TRUE(bitvector->GetBit(num_ - 1));
+    bitvector->UnsetBit(num_ - 1);
+    EXPECT_FALSE(bitvector->GetBit(num_ - 1));
+    delete bitvector;
+}
+
+TEST_F(CompressedBitVectorTest, GetPositions){
+    const size_t periods[] = {2, 20000};
+    for(size_t period : periods){
+        BitVector* dense = MakeDense(period);
+        CompressedBitVector* compressed = new CompressedBitVector(dense);
+        std::vector<uint64_t> expected;
+        for(size_t i=0; i < num_; i++){
+            if(dense->GetBit(i)){
+                expected.push_back(i);
+            }
+        }
+        //in batches, resuming after the last position
+        std::vector<uint64_t> actual;
+        std::vector<uint64_t> batch(1000);
+        size_t begin = 0;
+        while(true){
+            const size_t count = compressed->GetPositions(begin, batch.data(), batch.size());
+            actual.insert(actual.end(), batch.begin(), batch.begin() + count);
+            if(count < batch.size()){
+                break;
+            }
+            begin = batch.back() + 1;
+        }
+        EXPECT_EQ(expected, actual) << period;
+        delete compressed;
+        delete dense;
+    }
+}
+
+}   // namespace
@@ -0,0 +1,74 @@
+/*******************************************************************************
+ * Copyright (c) 2015
+ * The Hong Kong Polytechnic University, Database Group
+ *
+ * Author: Ziqiang Feng (cszqfeng AT comp.polyu.edu.hk)
+ *
+ * See file LICENSE.md for details.
+ *******************************************************************************/
+
+#include    <iostream>
+
+#include    "gtest/gtest.h"
+
+#include 	"src/column.h"
+#include 	"src/cpu_features.h"
+
+namespace byteslice{
+
+class CpuFeaturesTest: public ::testing::Test{
+public:
+    virtual void SetUp(){
+        std::cout << "detected simd level: " << DetectSimdLevel() << "\n";
+    }
+
+    virtual void TearDown(){
+        SetSimdLevel(DetectSimdLevel());
+    }
+};
+
+TEST_F(CpuFeaturesTest, DefaultIsDetected){
+    EXPECT_EQ(DetectSimdLevel(), GetSimdLevel());
+}
+
+TEST_F(CpuFeaturesTest, SetSimdLevel){
+    // The baseline is always available
+    EXPECT_TRUE(SetSimdLevel(SimdLevel::kSSE42));
+    EXPECT_EQ(SimdLevel::kSSE42, GetSimdLevel());
+
+    // Cannot go beyond what the machine supports
+    if(SimdLevel::kAVX512 != DetectSimdLevel()){
+        EXPECT_FALSE(SetSimdLevel(SimdLevel::kAVX512));
+        EXPECT_EQ(SimdLevel::kSSE42, GetSimdLevel());
+    }
+}
+
+TEST_F(CpuFeaturesTest, SameResultOnAllLevels){
+    const size_t num = kNumTuplesPerBlock + 1000;
+    Column* column = new Column(ColumnType::kByteSlicePadRight, 13, num);
+    for(size_t i=0; i < num; i++){
+        column->SetTuple(i, (i * 7919) & 0x1fff);
+    }
+    BitVector* expected = new BitVector(column);
+    BitVector* bitvector = new BitVector(column);
+
+    SetSimdLevel(SimdLevel::kSSE42);
+    column->Scan(Comparator::kGreaterEqual, 0x0abc, expected, Bitwise::kSet);
+
+    const SimdLevel levels[] = {SimdLevel::kAVX2, SimdLevel::kAVX512};
+    for(SimdLevel level : levels){
+        if(!SetSimdLevel(level)){
+            continue;
+        }
+        column->Scan(Comparator::kGreaterEqual, 0x0abc, bitvector, Bitwise::kSet);
+        EXPECT_EQ(expected->CountOnes(), bitvector->CountOnes()) << level;
+        bitvector->Or(expected);
+        EXPECT_EQ(expected->CountOnes(), bitvector->CountOnes()) << level;
+    }
+
+    delete bitvector;
+    delete expected;
+    delete column;
+}
+
+}   // namespace
@@ -0,0 +1,140 @@
+/*******************************************************************************
+ * Copyright (c) 2015
+ * The Hong Kong Polytechnic University, Database Group
+ *
+ * Author: Ziqiang Feng (cszqfeng AT comp.polyu.edu.hk)
+ *
+ * See file LICENSE.md for details.
+ *******************************************************************************/
+
+#include    <algorithm>
+
+#include    "gtest/gtest.h"
+
+#include 	"src/bitvector_block.h"
+#include 	"src/byteslice_column_block.h"
+#include 	"src/early_stop.h"
+
+namespace byteslice{
+
+class EarlyStopTest: public ::testing::Test{
+public:
+    virtual void SetUp(){
+        block_ = new ByteSliceColumnBlock<20>(num_);
+        bvblock_ = new BitVectorBlock(num_);
+        ResetEarlyStopStats();
+    }
+
+    virtual void TearDown(){
+        SetEarlyStop(EarlyStop::kAdaptive);
+        delete bvblock_;
+        delete block_;
+    }
+
+protected:
+    const size_t num_ = kNumTuplesPerBlock;
+    ByteSliceColumnBlock<20>* block_;
+    BitVectorBlock* bvblock_;
+};
+
+TEST_F(EarlyStopTest, DefaultIsAdaptive){
+    EXPECT_EQ(EarlyStop::kAdaptive, GetEarlyStop());
+}
+
+TEST_F(EarlyStopTest, SameResultUnderAllPolicies){
+    for(size_t i=0; i < num_; i++){
+        block_->SetTuple(i, (i * 7919) & 0xfffff);
+    }
+    const EarlyStop policies[] = {EarlyStop::kAlways, EarlyStop::kNever, EarlyStop::kAdaptive};
+    const Bitwise opts[] = {Bitwise::kSet, Bitwise::kAnd, Bitwise::kOr};
+    BitVectorBlock* expected = new BitVectorBlock(num_);
+    for(Bitwise opt : opts){
+        for(EarlyStop policy : policies){
+            SetEarlyStop(policy);
+            bvblock_->SetZeros();
+            for(size_t i=0; i < num_; i += 3){
+                bvblock_->SetBit(i);
+            }
+            block_->Scan(Comparator::kLessEqual, 0x7abcd, bvblock_, opt);
+            if(EarlyStop::kAlways == policy){
+                expected->Set(bvblock_);
+                continue;
+            }
+            size_t num_wrong = 0;
+            for(size_t i=0; i < num_; i++){
+                num_wrong += (expected->GetBit(i) != bvblock_->GetBit(i));
+            }
+            EXPECT_EQ(0UL, num_wrong) << policy << " " << static_cast<int>(opt);
+        }
+    }
+    delete expected;
+}
+
+TEST_F(EarlyStopTest, Counters){
+    //distinct values: the leading byte mostly decides
+    for(size_t i=0; i < num_; i++){
+        block_->SetTuple(i, i);
+    }
+    SetEarlyStop(EarlyStop::kNever);
+    block_->Scan(Comparator::kEqual, 12345, bvblock_);
+    EarlyStopStats stats = GetEarlyStopStats();
+    EXPECT_EQ(0UL, stats.num_checks);
+    EXPECT_EQ(0UL, stats.num_strides_checked);
+    EXPECT_LT(0UL, stats.num_strides_full);
+
+    ResetEarlyStopStats();
+    SetEarlyStop(EarlyStop::kAlways);
+    block_->Scan(Comparator::kEqual, 12345, bvblock_);
+    stats = GetEarlyStopStats();
+    EXPECT_EQ(0UL, stats.num_strides_full);
+    EXPECT_LT(0UL, stats.num_stops);
+    EXPECT_LE(stats.num_stops, stats.num_checks);
+
+    //stops fire often: adaptive keeps early stop everywhere
+    ResetEarlyStopStats();
+    SetEarlyStop(EarlyStop::kAdaptive);
+    block_->Scan(Comparator::kEqual, 12345, bvblock_);
+    stats = GetEarlyStopStats();
+    EXPECT_EQ(0UL, stats.num_strides_full);
+    EXPECT_EQ(1UL, bvblock_->CountOnes());
+}
+
+TEST_F(EarlyStopTest, AdaptiveSwitchesOnLowEntropy){
+    //every value shares its leading bytes with the literal: checks never stop
+    for(size_t i=0; i < num_; i++){
+        block_->SetTuple(i, 0x12300 | (i & 0xf));
+    }
+    SetEarlyStop(EarlyStop::kAdaptive);
+    block_->Scan(Comparator::kLess, 0x12308, bvblock_);
+    EarlyStopStats stats = GetEarlyStopStats();
+    EXPECT_EQ(0UL, stats.num_stops);
+    EXPECT_LT(0UL, stats.num_strides_checked);
+    EXPECT_GT(stats.num_strides_full, stats.num_strides_checked);
+    EXPECT_EQ(num_ / 2, bvblock_->CountOnes());
+}
+
+TEST_F(EarlyStopTest, AdaptiveCarriesAcrossChunks){
+    //the same low-entropy block, filtered one stride-sized chunk at a time
+    for(size_t i=0; i < num_; i++){
+        block_->SetTuple(i, 0x12300 | (i & 0xf));
+    }
+    SetEarlyStop(EarlyStop::kAdaptive);
+    bvblock_->SetOnes();
+    const size_t num_words = num_ / kNumWordBits;
+    const size_t chunk_words = 64;
+    {
+        EarlyStopState early_stop;
+        for(size_t begin = 0; begin < num_words; begin += chunk_words){
+            block_->FilterWords(Comparator::kLess, 0x12308, bvblock_->data() + begin,
+                    begin, std::min(chunk_words, num_words - begin), &early_stop);
+        }
+        //published once, when the scan's state goes away
+        EXPECT_EQ(0UL, GetEarlyStopStats().num_strides_checked);
+    }
+    EarlyStopStats stats = GetEarlyStopStats();
+    EXPECT_LT(0UL, stats.num_strides_checked);
+    EXPECT_GT(stats.num_strides_full, stats.num_strides_checked);
+    EXPECT_EQ(num_ / 2, bvblock_->CountOnes());
+}
+
+}   // namespace
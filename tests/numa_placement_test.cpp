@@ -0,0 +1,60 @@
+/*******************************************************************************
+ * Copyright (c) 2015
+ * The Hong Kong Polytechnic University, Database Group
+ *
+ * Author: Ziqiang Feng (cszqfeng AT comp.polyu.edu.hk)
+ *
+ * See file LICENSE.md for details.
+ *******************************************************************************/
+#include "../src/numa_placement.h"
+
+#include    <atomic>
+#include    <cstdlib>
+#include    <vector>
+
+#include    "gtest/gtest.h"
+
+namespace byteslice{
+
+TEST(NumaPlacementTest, BlockNode){
+    const size_t num_nodes = GetNumNodes();
+    ASSERT_LE(1U, num_nodes);
+    EXPECT_GT(num_nodes, GetCurrentNode());
+    for(size_t block_id=0; block_id < 3*num_nodes + 1; block_id++){
+        EXPECT_EQ(block_id % num_nodes, GetBlockNode(block_id));
+    }
+}
+
+TEST(NumaPlacementTest, ForEachBlock){
+    const size_t sizes[] = {0, 1, 7, 1000};
+    for(size_t num_blocks : sizes){
+        std::vector<std::atomic<int>> visits(num_blocks);
+        for(auto &v : visits){
+            v.store(0);
+        }
+        ForEachBlock(num_blocks, [&](size_t block_id){
+            visits[block_id]++;
+        });
+        for(size_t block_id=0; block_id < num_blocks; block_id++){
+            EXPECT_EQ(1, visits[block_id].load()) << block_id;
+        }
+    }
+}
+
+TEST(NumaPlacementTest, PlaceOnNode){
+    //placement moves pages, never their contents
+    const size_t size = 1 << 20;
+    unsigned char* data = static_cast<unsigned char*>(std::malloc(size + 1));
+    for(size_t i=0; i < size + 1; i++){
+        data[i] = static_cast<unsigned char>(i * 7);
+    }
+    PlaceOnNode(data + 1, size, GetNumNodes() - 1);
+    PlaceOnNode(data, 0, 0);
+    PlaceOnNode(data, size, kAnyNode);
+    for(size_t i=0; i < size + 1; i++){
+        ASSERT_EQ(static_cast<unsigned char>(i * 7), data[i]) << i;
+    }
+    std::free(data);
+}
+
+}   // namespace
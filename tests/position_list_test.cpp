@@ -0,0 +1,122 @@
+/*******************************************************************************
+ * Copyright (c) 2015
+ * The Hong Kong Polytechnic University, Database Group
+ *
+ * Author: Ziqiang Feng (cszqfeng AT comp.polyu.edu.hk)
+ *
+ * See file LICENSE.md for details.
+ *******************************************************************************/
+
+#include    <cstdlib>
+#include    <ctime>
+#include    <vector>
+
+#include    "gtest/gtest.h"
+
+#include 	"src/bitvector.h"
+#include 	"src/cpu_features.h"
+#include 	"src/position_list.h"
+
+namespace byteslice{
+
+class PositionListTest: public ::testing::Test{
+public:
+    virtual void SetUp(){
+        std::srand(std::time(0));
+        //dense, sparse and empty words
+        for(size_t w=0; w < num_words_; w++){
+            WordUnit word = (static_cast<WordUnit>(std::rand()) << 32) ^ std::rand();
+            switch(w % 4){
+                case 0:
+                    break;
+                case 1:
+                    word &= word >> 7;
+                    word &= word >> 13;
+                    break;
+                case 2:
+                    word = 0;
+                    break;
+                case 3:
+                    word = -1ULL;
+                    break;
+            }
+            words_.push_back(word);
+        }
+    }
+
+    virtual void TearDown(){
+        SetSimdLevel(DetectSimdLevel());
+    }
+
+protected:
+    //expected positions of the first num_bits bits
+    std::vector<uint64_t> Expected(size_t num_bits, uint64_t base){
+        std::vector<uint64_t> expected;
+        for(size_t i=0; i < num_bits; i++){
+            if((words_[i / 64] >> (i % 64)) & 1ULL){
+                expected.push_back(base + i);
+            }
+        }
+        return expected;
+    }
+
+    const size_t num_words_ = 1000;
+    std::vector<WordUnit> words_;
+};
+
+TEST_F(PositionListTest, AllLevels){
+    const SimdLevel levels[] = {SimdLevel::kSSE42, SimdLevel::kAVX2, SimdLevel::kAVX512};
+    const size_t num_bits[] = {num_words_ * 64, num_words_ * 64 - 21, 63, 0};
+    const uint64_t base = 3ULL << 20;
+    for(SimdLevel level : levels){
+        if(!SetSimdLevel(level)){
+            continue;
+        }
+        for(size_t n : num_bits){
+            std::vector<uint64_t> expected = Expected(n, base);
+            std::vector<uint32_t> positions32(n);
+            std::vector<uint64_t> positions64(n);
+            ASSERT_EQ(expected.size(),
+                    ExtractPositions(words_.data(), n, base, positions32.data()));
+            ASSERT_EQ(expected.size(),
+                    ExtractPositions(words_.data(), n, base, positions64.data()));
+            for(size_t i=0; i < expected.size(); i++){
+                EXPECT_EQ(expected[i], positions32[i]) << level << " " << n;
+                EXPECT_EQ(expected[i], positions64[i]) << level << " " << n;
+            }
+        }
+    }
+}
+
+TEST_F(PositionListTest, BitVector){
+    const size_t num = 2 * kNumTuplesPerBlock + 3000;
+    BitVector* bitvector = new BitVector(num);
+    bitvector->SetZeros();
+    for(size_t i=0; i < num; i++){
+        if((words_[i / 64 % num_words_] >> (i % 64)) & 1ULL){
+            bitvector->SetBit(i);
+        }
+    }
+    std::vector<uint32_t> positions32(num);
+    std::vector<uint64_t> positions64(num);
+    const std::vector<size_t> counts32 = ExtractPositions(bitvector, positions32.data());
+    const std::vector<size_t> counts64 = ExtractPositions(bitvector, positions64.data());
+    ASSERT_EQ(bitvector->GetNumBlocks(), counts32.size());
+    EXPECT_EQ(counts32, counts64);
+    for(size_t block_id = 0; block_id < counts32.size(); block_id++){
+        const size_t block_offset = block_id * kNumTuplesPerBlock;
+        const size_t block_num = bitvector->GetBVBlock(block_id)->num();
+        size_t count = 0;
+        for(size_t i = block_offset; i < block_offset + block_num; i++){
+            if(bitvector->GetBit(i)){
+                ASSERT_EQ(i, positions32[block_offset + count]);
+                ASSERT_EQ(i, positions64[block_offset + count]);
+                count++;
+            }
+        }
+        EXPECT_EQ(count, counts32[block_id]);
+    }
+    delete bitvector;
+}
+
+}   // namespace
@@ -0,0 +1,102 @@
+/*******************************************************************************
+ * Copyright (c) 2015
+ * The Hong Kong Polytechnic University, Database Group
+ *
+ * Author: Ziqiang Feng (cszqfeng AT comp.polyu.edu.hk)
+ *
+ * See file LICENSE.md for details.
+ *******************************************************************************/
+
+#include    <cstdlib>
+#include    <ctime>
+#include    <vector>
+
+#include    "gtest/gtest.h"
+
+#include 	"src/slice_codec.h"
+
+namespace byteslice{
+
+class SliceCodecTest: public ::testing::Test{
+public:
+    virtual void SetUp(){
+        std::srand(std::time(0));
+        data_.resize(size_);
+    }
+
+    SliceCodec RoundTrip(){
+        std::vector<char> payload;
+        const SliceCodec codec = EncodeSlice(data_.data(), size_, payload);
+        std::vector<ByteUnit> decoded(size_, 0x55);
+        EXPECT_TRUE(DecodeSlice(codec, payload.data(), payload.size(),
+                    decoded.data(), size_));
+        EXPECT_EQ(data_, decoded);
+        payload_size_ = payload.size();
+        return codec;
+    }
+
+protected:
+    const size_t size_ = 100000;
+    std::vector<ByteUnit> data_;
+    size_t payload_size_ = 0;
+};
+
+TEST_F(SliceCodecTest, Runs){
+    for(size_t i=0; i < size_; i++){
+        data_[i] = i / 30000;
+    }
+    EXPECT_EQ(SliceCodec::kRle, RoundTrip());
+    EXPECT_LT(payload_size_, 32U);
+}
+
+TEST_F(SliceCodecTest, Constant){
+    for(size_t i=0; i < size_; i++){
+        data_[i] = 0x80;
+    }
+    RoundTrip();
+    EXPECT_LT(payload_size_, 8U);
+}
+
+TEST_F(SliceCodecTest, FewDistinct){
+    const ByteUnit values[] = {3, 17, 200, 91};
+    for(size_t i=0; i < size_; i++){
+        data_[i] = values[std::rand() % 4];
+    }
+    EXPECT_EQ(SliceCodec::kPacked, RoundTrip());
+    EXPECT_LE(payload_size_, size_ / 4 + 8);
+
+    for(size_t i=0; i < size_; i++){
+        data_[i] = 40 + std::rand() % 16;
+    }
+    EXPECT_EQ(SliceCodec::kPacked, RoundTrip());
+    EXPECT_LE(payload_size_, size_ / 2 + 20);
+}
+
+TEST_F(SliceCodecTest, Random){
+    for(size_t i=0; i < size_; i++){
+        data_[i] = std::rand() & 0xFF;
+    }
+    EXPECT_EQ(SliceCodec::kRaw, RoundTrip());
+    EXPECT_EQ(size_, payload_size_);
+}
+
+TEST_F(SliceCodecTest, Malformed){
+    for(size_t i=0; i < size_; i++){
+        data_[i] = i / 1000;
+    }
+    std::vector<char> payload;
+    const SliceCodec codec = EncodeSlice(data_.data(), size_, payload);
+    std::vector<ByteUnit> decoded(size_);
+    //truncated
+    EXPECT_FALSE(DecodeSlice(codec, payload.data(), payload.size() - 1,
+                decoded.data(), size_));
+    //too few bytes for the slice
+    EXPECT_FALSE(DecodeSlice(codec, payload.data(), payload.size(),
+                decoded.data(), size_ + 1));
+    EXPECT_FALSE(DecodeSlice(SliceCodec::kRaw, payload.data(), payload.size(),
+                decoded.data(), size_));
+    EXPECT_FALSE(DecodeSlice(static_cast<SliceCodec>(7), payload.data(), payload.size(),
+                decoded.data(), size_));
+}
+
+}   // namespace
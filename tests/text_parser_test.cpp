@@ -0,0 +1,85 @@
+/*******************************************************************************
+ * Copyright (c) 2015
+ * The Hong Kong Polytechnic University, Database Group
+ *
+ * Author: Ziqiang Feng (cszqfeng AT comp.polyu.edu.hk)
+ *
+ * See file LICENSE.md for details.
+ *******************************************************************************/
+
+#include    <cstdlib>
+#include    <ctime>
+#include    <string>
+#include    <vector>
+
+#include    "gtest/gtest.h"
+
+#include 	"src/text_parser.h"
+
+namespace byteslice{
+
+class TextParserTest: public ::testing::Test{
+public:
+    virtual void SetUp(){
+        std::srand(std::time(0));
+        const char* separators[] = {"\n", "\r\n", " ", "\t  ", ",", "\n\n"};
+        for(size_t i=0; i < num_; i++){
+            //1 to 20 digits
+            const size_t num_digits = 1 + i % 20;
+            WordUnit value = 0;
+            for(size_t d=0; d < num_digits && d < 19; d++){
+                value = value * 10 + std::rand() % 10;
+            }
+            values_.push_back(value);
+            text_ += std::to_string(value);
+            text_ += separators[std::rand() % 6];
+        }
+    }
+
+protected:
+    const size_t num_ = 10000;
+    std::vector<WordUnit> values_;
+    std::string text_;
+};
+
+TEST_F(TextParserTest, Count){
+    const char* begin = text_.data();
+    EXPECT_EQ(num_, CountIntegers(begin, begin + text_.size()));
+    EXPECT_EQ(0ULL, CountIntegers(begin, begin));
+    EXPECT_EQ(3ULL, CountIntegers("12 345\n6", "12 345\n6" + 8));
+}
+
+TEST_F(TextParserTest, Parse){
+    const char* begin = text_.data();
+    const char* end = begin + text_.size();
+    std::vector<WordUnit> parsed(num_ + 1);
+    const char* stop;
+    EXPECT_EQ(num_, ParseIntegers(begin, end, parsed.data(), num_ + 1, &stop));
+    EXPECT_EQ(end, stop);
+    for(size_t i=0; i < num_; i++){
+        ASSERT_EQ(values_[i], parsed[i]) << i;
+    }
+
+    //values at the very end of the buffer take the scalar path
+    const char tail[] = "18446744073709551615 7 123456789012345";
+    EXPECT_EQ(3ULL, ParseIntegers(tail, tail + sizeof(tail) - 1, parsed.data(), 3, &stop));
+    EXPECT_EQ(18446744073709551615ULL, parsed[0]);
+    EXPECT_EQ(7ULL, parsed[1]);
+    EXPECT_EQ(123456789012345ULL, parsed[2]);
+}
+
+TEST_F(TextParserTest, SkipThenParse){
+    const char* begin = text_.data();
+    const char* end = begin + text_.size();
+    const size_t skips[] = {0, 1, 15, 16, 17, 999, num_ - 1};
+    for(size_t skip : skips){
+        const char* p = SkipIntegers(begin, end, skip);
+        WordUnit value;
+        const char* stop;
+        ASSERT_EQ(1ULL, ParseIntegers(p, end, &value, 1, &stop));
+        EXPECT_EQ(values_[skip], value) << skip;
+    }
+    EXPECT_EQ(end, SkipIntegers(begin, end, num_));
+}
+
+}   // namespace